@@ -0,0 +1,287 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    comm_async.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+
+  supports comm_async.cpp -- requires C++20
+
+  ============================================================================*/
+
+
+#ifndef _COMM_ASYNC_
+#define _COMM_ASYNC_
+
+#include <coroutine>
+#include <exception>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#include "comm_reactor.h"
+
+namespace comm_reactor {
+
+  class CommExecutor;
+
+  template<typename T> class CommTask;
+
+  //! the parts of a task promise that do not depend on the result type
+  struct CommPromiseBase {
+    std::coroutine_handle<> continuation_;
+
+    //! a finished task resumes the coroutine that awaited it
+    struct FinalAwaiter {
+      bool await_ready() noexcept { return false; }
+
+      template<typename P>
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept
+      {
+	if (h.promise().continuation_)
+	  return h.promise().continuation_;
+	return std::noop_coroutine();
+      }
+
+      void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter        final_suspend() noexcept { return {}; }
+    void                unhandled_exception() { std::terminate(); }
+  };
+
+  template<typename T>
+  struct CommPromise : CommPromiseBase {
+    T value_;
+
+    CommTask<T> get_return_object();
+    void        return_value(T value) { value_ = std::move(value); }
+    T           result() { return std::move(value_); }
+  };
+
+  template<>
+  struct CommPromise<void> : CommPromiseBase {
+    CommTask<void> get_return_object();
+    void           return_void() {}
+    void           result() {}
+  };
+
+  //! a lazily started coroutine: it runs when awaited, or when given to
+  //! CommExecutor::spawn()
+  template<typename T = void>
+  class CommTask {
+  public:
+    typedef CommPromise<T> promise_type;
+
+    explicit CommTask(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+    CommTask(CommTask &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    CommTask(const CommTask &) = delete;
+
+    ~CommTask() { if (handle_) handle_.destroy(); }
+
+    bool await_ready() noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+    {
+      handle_.promise().continuation_ = continuation;
+      return handle_;
+    }
+
+    T await_resume() { return handle_.promise().result(); }
+
+  private:
+    std::coroutine_handle<promise_type> handle_;
+  };
+
+  template<typename T>
+  inline CommTask<T> CommPromise<T>::get_return_object()
+  {
+    return CommTask<T>(std::coroutine_handle<CommPromise<T>>::from_promise(*this));
+  }
+
+  inline CommTask<void> CommPromise<void>::get_return_object()
+  {
+    return CommTask<void>(std::coroutine_handle<CommPromise<void>>::from_promise(*this));
+  }
+
+  //! an awaitable operation that waits for a file descriptor and/or a time out
+  class CommWaiter {
+  public:
+    CommWaiter(CommExecutor &ex, int fd) : ex_(ex), fd_(fd), timer_id_(0) {}
+
+    virtual ~CommWaiter() {}
+
+    //! tries the operation when the fd is ready; true if done
+    virtual bool tryComplete() = 0;
+
+    //! called instead if the time out expires first
+    virtual void onTimeout() = 0;
+
+    CommExecutor            &ex_;
+    int                      fd_;       //!< -1 for a pure timer
+    uint64_t                 timer_id_; //!< 0 if no timer is armed
+    std::coroutine_handle<>  handle_;
+  };
+
+  //! a single-threaded executor that runs coroutines on top of a CommReactor
+  class CommExecutor {
+  public:
+    CommExecutor();
+
+    virtual ~CommExecutor();
+
+    void
+    spawn(CommTask<void> task);
+
+    int
+    runExecutor();
+
+    int
+    stepExecutor(int max_wait_ms);
+
+    void
+    stopExecutor();
+
+    int
+    addEndpoint(int fd);
+
+    int
+    removeEndpoint(int fd);
+
+    int
+    waitFd(CommWaiter *w);
+
+    void
+    armTimer(CommWaiter *w, uint64_t deadline_ns);
+
+    void
+    cancelWait(CommWaiter *w);
+
+    CommReactor &
+    getReactor() { return reactor_; }
+
+    static uint64_t
+    deadlineIn(int timeout_ms);
+
+    //! awaitable pause of a coroutine
+    class SleepAwaitable : public CommWaiter {
+    public:
+      SleepAwaitable(CommExecutor &ex, int ms) : CommWaiter(ex, -1), ms_(ms) {}
+      bool await_ready() { return ms_ <= 0; }
+      void await_suspend(std::coroutine_handle<> h) { handle_ = h; ex_.armTimer(this, deadlineIn(ms_)); }
+      void await_resume() {}
+      bool tryComplete() { return true; }
+      void onTimeout() {}
+    private:
+      int ms_;
+    };
+
+    SleepAwaitable
+    sleepFor(int ms) { return SleepAwaitable(*this, ms); }
+
+    int                      n_tasks_;   //!< spawned tasks that did not finish
+
+
+  private:
+    struct Timer {
+      uint64_t deadline;
+      uint64_t id;
+      bool operator>(const Timer &o) const { return deadline > o.deadline; }
+    };
+
+    void
+    onFdReady(int fd);
+
+    int
+    fireTimers();
+
+    CommReactor                                   reactor_;
+    std::vector<CommWaiter *>                     waiters_;   //!< by fd
+    std::vector<bool>                             endpoints_; //!< fd registered
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer> > timers_;
+    std::unordered_map<uint64_t, CommWaiter *>    armed_;     //!< live timers
+    uint64_t                                      next_timer_id_;
+    volatile bool                                 running_;
+
+  };
+
+  //! awaitable receive on a UDP socket
+  class AsyncUDP {
+  public:
+    AsyncUDP(CommExecutor &ex, udp_communication::UDP_communication *udp);
+
+    virtual ~AsyncUDP();
+
+    class ReceiveAwaitable : public CommWaiter {
+    public:
+      ReceiveAwaitable(CommExecutor &ex, udp_communication::UDP_communication *udp,
+		       char *buf, int bufLen, udp_communication::UDPEndpoint *peer,
+		       int timeout_ms);
+      bool await_ready();
+      bool await_suspend(std::coroutine_handle<> h);
+      int  await_resume() { return result_; }
+      bool tryComplete();
+      void onTimeout() { result_ = 0; }
+    private:
+      udp_communication::UDP_communication *udp_;
+      char                                 *buf_;
+      int                                   buf_len_;
+      udp_communication::UDPEndpoint       *peer_;
+      int                                   timeout_ms_;
+      int                                   result_;
+    };
+
+    ReceiveAwaitable
+    receive(char *buf, int bufLen, int timeout_ms);
+
+    ReceiveAwaitable
+    receiveFrom(char *buf, int bufLen, udp_communication::UDPEndpoint *peer, int timeout_ms);
+
+  private:
+    CommExecutor                         &ex_;
+    udp_communication::UDP_communication *udp_;
+  };
+
+  //! awaitable reads from a serial port
+  class AsyncSerial {
+  public:
+    AsyncSerial(CommExecutor &ex, serial_communication::SerialCommunication *serial);
+
+    virtual ~AsyncSerial();
+
+    class ReadAwaitable : public CommWaiter {
+    public:
+      ReadAwaitable(CommExecutor &ex, serial_communication::SerialCommunication *serial,
+		    char *buf, int n_bytes, uint64_t deadline_ns);
+      bool await_ready();
+      bool await_suspend(std::coroutine_handle<> h);
+      int  await_resume() { return n_read_; }
+      bool tryComplete();
+      void onTimeout() {}
+    private:
+      serial_communication::SerialCommunication *serial_;
+      char                                      *buf_;
+      int                                        n_bytes_;
+      int                                        n_read_;
+      uint64_t                                   deadline_ns_;
+    };
+
+    ReadAwaitable
+    readExact(char *buf, int n_bytes, uint64_t deadline_ns);
+
+  private:
+    CommExecutor                              &ex_;
+    serial_communication::SerialCommunication *serial_;
+  };
+
+}
+
+#endif  // _COMM_ASYNC_
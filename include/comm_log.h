@@ -0,0 +1,98 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    comm_log.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+
+  supports comm_log.cpp
+
+  ============================================================================*/
+
+
+#ifndef _COMM_LOG_
+#define _COMM_LOG_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define COMM_LOG_RING_SIZE   256   //!< events per thread ring (power of 2)
+#define COMM_LOG_MAX_THREADS 64    //!< max. threads logging at the same time
+#define COMM_LOG_PERIOD_MS   10    //!< default drain period
+
+namespace comm_log {
+
+  //! event codes -- keep in sync with the table in comm_log.cpp
+  enum CommEventCode {
+    COMM_EV_UDP_NOT_ACTIVE,          //!< arg0: socket fd
+    COMM_EV_UDP_NOT_SERVER,          //!< arg0: socket fd
+    COMM_EV_UDP_READ_ERROR,          //!< arg0: socket fd
+    COMM_EV_UDP_WRITE_ERROR,         //!< arg0: socket fd
+    COMM_EV_UDP_POLL_ERROR,
+    COMM_EV_UDP_GSO_FAILED,          //!< arg0: socket fd
+    COMM_EV_UDP_BUFFER_ERROR,        //!< arg0: socket fd
+    COMM_EV_UDP_BUFFER_LOW,          //!< arg0: buffer size, arg1: requested size
+    COMM_EV_CHANNEL_NOT_ACTIVE,
+    COMM_EV_CHANNEL_INVALID_LENGTH,  //!< arg0: message length, arg1: max. length
+    COMM_EV_CHANNEL_INVALID_STREAM,  //!< arg0: stream id or path
+    COMM_EV_FEC_SINGULAR,
+    COMM_EV_SERIAL_NOT_ACTIVE,
+    COMM_EV_SERIAL_READ_ERROR,       //!< arg0: port fd, arg1: bytes requested
+    COMM_EV_SERIAL_WRITE_ERROR,      //!< arg0: port fd, arg1: bytes requested
+    COMM_EV_ECAT_NOT_ACTIVE,
+    COMM_EV_ECAT_WKC_LOW,            //!< arg0: work counter, arg1: expected
+    COMM_EV_ECAT_SLAVE_SAFEOP_ERROR, //!< arg0: slave
+    COMM_EV_ECAT_SLAVE_SAFEOP,       //!< arg0: slave
+    COMM_EV_ECAT_SLAVE_RECONFIGURED, //!< arg0: slave
+    COMM_EV_ECAT_SLAVE_LOST,         //!< arg0: slave
+    COMM_EV_ECAT_SLAVE_RECOVERED,    //!< arg0: slave
+    COMM_EV_ECAT_SLAVE_FOUND,        //!< arg0: slave
+    COMM_EV_ECAT_OPERATIONAL,        //!< all slaves resumed OPERATIONAL
+    COMM_EV_N_CODES
+  };
+
+  //! a compact binary event record
+  typedef struct {
+    uint64_t  t_ns;      //!< CLOCK_MONOTONIC time of the event
+    uint16_t  code;      //!< CommEventCode
+    uint16_t  thread;    //!< ring of the thread that logged the event
+    int32_t   err;       //!< errno, or 0
+    int64_t   args[2];   //!< event specific arguments
+  } CommEvent;
+
+  void
+  logCommEvent(int code, int err, int64_t arg0 = 0, int64_t arg1 = 0);
+
+  int
+  initCommLogThread(void);
+
+  int
+  drainCommLog(void);
+
+  int
+  startCommLogDrain(int period_ms);
+
+  void
+  stopCommLogDrain(void);
+
+  void
+  setCommLogOutput(FILE *out, bool auto_drain);
+
+  unsigned long
+  getCommEventCount(int code);
+
+  unsigned long
+  getCommEventsLost(void);
+
+  void
+  resetCommEventCounts(void);
+
+  const char *
+  getCommEventName(int code);
+
+}
+
+#endif  // _COMM_LOG_
@@ -0,0 +1,87 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    comm_reactor.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+
+  supports comm_reactor.cpp
+
+  ============================================================================*/
+
+
+#ifndef _COMM_REACTOR_
+#define _COMM_REACTOR_
+
+#include <functional>
+#include <vector>
+#include <sys/epoll.h>
+
+#include "udp_communication.h"
+#include "serial_communication.h"
+
+#define COMM_REACTOR_MAX_EVENTS 64    //!< max. events dispatched per epoll_wait
+
+namespace comm_reactor {
+
+  //! callback invoked with the file descriptor and the epoll event mask
+  typedef std::function<void(int fd, unsigned int events)> CommCallback;
+
+  class CommReactor {
+  public:
+    CommReactor();
+
+    virtual ~CommReactor();
+
+    int
+    addUDPSocket(udp_communication::UDP_communication *udp,
+		 CommCallback callback,
+		 bool edge_triggered);
+
+    int
+    addSerialPort(serial_communication::SerialCommunication *serial,
+		  CommCallback callback,
+		  bool edge_triggered);
+
+    int
+    addFd(int fd,
+	  unsigned int events,
+	  CommCallback callback,
+	  bool edge_triggered);
+
+    int
+    removeFd(int fd);
+
+    int
+    dispatchEvents(int timeout_ms);
+
+    int
+    runReactor();
+
+    void
+    stopReactor();
+
+    bool active_;    //!< reactor active or not
+
+  private:
+
+    struct Handler {
+      int           fd;
+      CommCallback  callback;
+      bool          removed;
+    };
+
+    int                    epoll_fd_;
+    int                    wakeup_fd_;    //!< eventfd to interrupt epoll_wait
+    volatile bool          running_;
+    std::vector<Handler *> handlers_;
+    std::vector<Handler *> removed_;      //!< freed after the current dispatch
+
+  };
+
+}
+
+#endif  // _COMM_REACTOR_
@@ -60,7 +60,6 @@ namespace ethercat_communication {
     char               ifname_[100];  //socket interface name
     char               IOmap_[4096];
     OSAL_THREAD_HANDLE thread1_;
-    boolean            needlf_;
     uint8              currentgroup_ = 0;
     
   };
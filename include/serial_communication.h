@@ -52,6 +52,9 @@ namespace serial_communication {
     int
     checkSerial();
 
+    int
+    getSerialFd();
+
     bool active_;    //!< serial port active or not
 
   private:
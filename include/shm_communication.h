@@ -0,0 +1,111 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    shm_communication.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  header file for shm_communication.cpp
+
+  ============================================================================*/
+
+#ifndef SHM_COMMUNICATION_H_
+#define SHM_COMMUNICATION_H_
+
+#include <atomic>
+#include <stdint.h>
+
+#include "udp_communication.h"
+
+#define SHM_N_SLOTS          256      //!< messages per ring, a power of 2
+#define SHM_SLOT_SIZE        9216     //!< max. message size, as for UDP
+#define SHM_SPIN_NS          50000    //!< busy wait before sleeping on the futex
+
+namespace udp_communication {
+
+//! one message slot of a ring
+typedef struct {
+	alignas(64) std::atomic<uint64_t> seq;   //!< Vyukov sequence number
+	uint32_t            len;
+	char                data[SHM_SLOT_SIZE];
+} SHMSlot;
+
+//! a bounded multi-producer/multi-consumer ring in shared memory
+typedef struct {
+	alignas(64) std::atomic<uint64_t> head;  //!< next position to write
+	alignas(64) std::atomic<uint64_t> tail;  //!< next position to read
+	alignas(64) std::atomic<uint32_t> futex; //!< bumped by every write
+	std::atomic<uint32_t> waiters;           //!< readers sleeping on futex
+	SHMSlot             slots[SHM_N_SLOTS];
+} SHMRing;
+
+//! the shared memory segment: one ring per direction
+typedef struct {
+	std::atomic<uint32_t> state;             //!< 0: new, 1: initializing, 2: ready
+	uint32_t            n_slots;
+	uint32_t            slot_size;
+	SHMRing             to_server;
+	SHMRing             to_client;
+} SHMSegment;
+
+class SHM_communication : public UDPTransport {
+public:
+	SHM_communication();
+
+	virtual ~SHM_communication();
+
+	int
+	readUDPSocket(char *buf,
+			int   bufLen,
+			char *inetAddr);
+
+	int
+	readUDPSocketFrom(char        *buf,
+			int          bufLen,
+			UDPEndpoint *peer);
+
+	int
+	closeUDPSocket(void);
+
+	int
+	writeUDPSocket(char *buf,
+			int   bufLen);
+
+	int
+	checkUDPSocket(void);
+
+	void
+	setUDPNonBlocking(int non_block);
+
+	int
+	makeUDPServer(int serverPortNum, char *serverName);
+
+	int
+	makeUDPClient(int socketPortNum, char *clientName);
+
+
+	bool                active;          //!< segment mapped or not
+	unsigned long       nDropped;        //!< messages not written as the ring was full
+
+
+private:
+	int
+	openSHMSegment(int portNum);
+
+	SHMSegment         *segment;
+	SHMRing            *rxRing;
+	SHMRing            *txRing;
+	char                shmName[64];
+	int                 portNum;
+	bool                is_server;
+	bool                non_block;
+
+};
+
+}
+
+#endif /* SHM_COMMUNICATION_H_ */
@@ -0,0 +1,128 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_capture.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  header file for udp_capture.cpp
+
+  ============================================================================*/
+
+#ifndef UDP_CAPTURE_H_
+#define UDP_CAPTURE_H_
+
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "udp_communication.h"
+
+#define UDP_CAPTURE_MAGIC    0x3130504143504455ULL  //!< "UDPCAP01"
+
+namespace udp_communication {
+
+enum { UDP_CAPTURE_RX, UDP_CAPTURE_TX, UDP_CAPTURE_ANY };
+
+//! the header at the start of a capture file
+typedef struct {
+	uint64_t            magic;           //!< UDP_CAPTURE_MAGIC
+	uint64_t            start_ns;        //!< CLOCK_REALTIME when the capture started
+	uint64_t            start_mono_ns;   //!< CLOCK_MONOTONIC when the capture started
+	uint64_t            reserved;
+} UDPCaptureFileHeader;
+
+//! the header of every captured datagram, followed by the data, padded to 8 bytes
+typedef struct {
+	uint32_t            len;             //!< datagram length, 0 while being written
+	uint16_t            direction;       //!< UDP_CAPTURE_RX or UDP_CAPTURE_TX
+	uint16_t            port;            //!< peer port (network byte order)
+	uint32_t            addr;            //!< peer address (network byte order)
+	uint32_t            reserved;
+	uint64_t            t_ns;            //!< CLOCK_MONOTONIC time of the datagram
+} UDPCaptureRecord;
+
+class UDPCapture {
+public:
+	UDPCapture();
+
+	virtual ~UDPCapture();
+
+	int
+	openUDPCapture(char *fileName,
+			size_t maxBytes);
+
+	int
+	closeUDPCapture(void);
+
+	void
+	recordUDPPacket(int                direction,
+			const char        *buf,
+			int                len,
+			const UDPEndpoint *peer);
+
+	void
+	recordUDPPacketV(int                direction,
+			const struct iovec *iov,
+			int                 iovcnt,
+			int                 len,
+			const UDPEndpoint  *peer);
+
+
+	bool                active;          //!< capture file open or not
+	std::atomic<unsigned long> nRecorded;
+	std::atomic<unsigned long> nDropped; //!< datagrams that did not fit into the file
+
+
+private:
+	int                 fd;
+	char               *map;
+	size_t              mapSize;
+	std::atomic<size_t> writePos;
+
+};
+
+class UDPReplay {
+public:
+	UDPReplay();
+
+	virtual ~UDPReplay();
+
+	int
+	openUDPReplay(char *fileName);
+
+	int
+	closeUDPReplay(void);
+
+	int
+	nextUDPRecord(UDPCaptureRecord **rec,
+			char             **data);
+
+	void
+	rewindUDPReplay(void);
+
+	int
+	replayUDPCapture(UDP_communication *udp,
+			int    direction,
+			double speed);
+
+
+	bool                active;          //!< capture file open or not
+	double              maxLateness;     //!< worst send delay of the last replay [s]
+
+
+private:
+	int                 fd;
+	char               *map;
+	size_t              mapSize;
+	size_t              readPos;
+
+};
+
+}
+
+#endif /* UDP_CAPTURE_H_ */
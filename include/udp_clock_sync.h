@@ -0,0 +1,128 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_clock_sync.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  header file for udp_clock_sync.cpp
+
+  ============================================================================*/
+
+#ifndef UDP_CLOCK_SYNC_H_
+#define UDP_CLOCK_SYNC_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#include "udp_communication.h"
+
+#define UDP_CLOCK_MAGIC        0x434B   //!< marks a clock synchronization datagram
+#define UDP_CLOCK_MAX_SAMPLES  64       //!< max. exchanges kept for the estimate
+#define UDP_CLOCK_RTT_SLACK_NS 10000    //!< round trip times accepted above the minimum
+#define UDP_CLOCK_MIN_SPAN_NS  1000000000LL  //!< min. time span to estimate drift
+#define UDP_CLOCK_MAX_DRIFT    0.001    //!< max. plausible rate difference of the clocks
+
+namespace udp_communication {
+
+enum { UDP_CLOCK_REQUEST, UDP_CLOCK_REPLY };
+
+//! the clock synchronization datagram (host byte order)
+typedef struct {
+	uint16_t            magic;           //!< UDP_CLOCK_MAGIC
+	uint8_t             type;            //!< UDP_CLOCK_REQUEST or UDP_CLOCK_REPLY
+	uint8_t             reserved;
+	uint32_t            seq;             //!< number of the request
+	uint64_t            t1;              //!< requester: request sent [ns]
+	uint64_t            t2;              //!< responder: request received [ns]
+	uint64_t            t3;              //!< responder: reply sent [ns]
+} UDPClockHeader;
+
+class UDPClockSync {
+public:
+	UDPClockSync();
+
+	virtual ~UDPClockSync();
+
+	int
+	initUDPClockSync(UDP_communication *udp,
+			clockid_t clock,
+			int window,
+			double period);
+
+	int
+	requestUDPClockSync(void);
+
+	int
+	serviceUDPClockSync(void);
+
+	int
+	handleUDPClockSync(const char        *buf,
+			int                len,
+			const UDPEndpoint *peer,
+			uint64_t           rxNs);
+
+	int
+	readUDPClockSync(char        *buf,
+			int          bufLen,
+			UDPEndpoint *peer);
+
+	uint64_t
+	remoteToLocal(uint64_t tRemote);
+
+	uint64_t
+	localToRemote(uint64_t tLocal);
+
+	int
+	getUDPClockOffset(double *offset,
+			double *drift,
+			double *rtt);
+
+	uint64_t
+	getUDPClockTime(void);
+
+
+	bool                active;          //!< service initialized or not
+	bool                synced;          //!< an estimate of the remote clock exists
+	unsigned long       nRequestsSent;
+	unsigned long       nRequestsAnswered;
+	unsigned long       nRepliesReceived; //!< replies used as samples
+	unsigned long       nRejected;       //!< stale, duplicate, or implausible replies
+	unsigned long       nInvalid;        //!< clock datagrams with a bad length or type
+
+
+private:
+	typedef struct {
+		uint64_t            tLocal;          //!< local time of the exchange (midpoint)
+		int64_t             offset;          //!< remote minus local clock [ns]
+		int64_t             rtt;             //!< round trip without the turn around [ns]
+	} Sample;
+
+	void
+	updateUDPClockEstimate(void);
+
+	UDP_communication  *udp;
+	clockid_t           clock;           //!< clock of all time stamps
+	int                 window;          //!< number of samples kept
+	uint64_t            periodNs;        //!< request period, 0 for manual requests
+	uint64_t            lastRequestNs;   //!< CLOCK_MONOTONIC time of the last request
+	uint32_t            seq;             //!< last request sent
+	uint32_t            lastReplySeq;    //!< last reply used
+	Sample              samples[UDP_CLOCK_MAX_SAMPLES];
+	int                 nSamples;
+	int                 head;            //!< next sample to overwrite
+
+	// the estimate: remote = local + offsetNs + drift * (local - refNs)
+	uint64_t            refNs;
+	double              offsetNs;
+	double              drift;
+	int64_t             minRttNs;
+};
+
+}
+
+#endif  // UDP_CLOCK_SYNC_H_
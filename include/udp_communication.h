@@ -20,6 +20,9 @@
 #include <cstdlib>
 #include <netinet/in.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/uio.h>
 
 
 // defines
@@ -33,17 +36,86 @@
 #define CLMCPORT3     55005
 #define CLMCPORT4     55006
 
+#define UDP_MAX_BATCH 64          //!< max. number of messages per batch call
+#define UDP_SKB_OVERHEAD 1024     //!< kernel memory per datagram besides the payload
+#define UDP_MAX_PAYLOAD  65507    //!< max. IPv4 UDP payload
+
 
 namespace udp_communication {
 
+class UDPCapture;
+
 void
 testUDPServer(char *name);
 
 void
 testUDPClient(int n_bytes, char *name);
 
+void
+testUDPSendLatency(int n_packets, char *name);
+
+
+//! a message slot for the batched read/write functions
+typedef struct {
+	char               *buf;        //!< data buffer
+	int                 bufLen;     //!< size of buf (read), or bytes to send (write)
+	int                 msgLen;     //!< number of bytes received or sent
+	struct sockaddr_in  addr;       //!< source address of a received message
+	bool                truncated;  //!< TRUE if the datagram did not fit into buf
+	uint32_t            drops;      //!< cumulative kernel drops, see setUDPDropCounting()
+} UDPMessage;
+
+//! information from the control messages of a received datagram
+typedef struct {
+	int                 segSize;    //!< GRO segment size
+	struct timespec     rxTime;     //!< kernel receive time stamp, or zero
+	uint32_t            drops;      //!< cumulative kernel drops of the socket
+} UDPRecvInfo;
+
+//! a binary peer address, both fields in network byte order
+typedef struct {
+	uint32_t            addr;       //!< IPv4 address
+	uint16_t            port;       //!< UDP port
+} UDPEndpoint;
+
+//! the message interface that UDP_communication and SHM_communication
+//! share, such that code written against it runs on either transport; the
+//! batched, vectored, and addressed variants are only offered by UDP
+class UDPTransport {
+public:
+	virtual ~UDPTransport() {}
+
+	virtual int
+	readUDPSocket(char *buf,
+			int   bufLen,
+			char *inetAddr) = 0;
+
+	virtual int
+	readUDPSocketFrom(char        *buf,
+			int          bufLen,
+			UDPEndpoint *peer) = 0;
+
+	virtual int
+	closeUDPSocket(void) = 0;
+
+	virtual int
+	writeUDPSocket(char *buf,
+			int   bufLen) = 0;
+
+	virtual int
+	checkUDPSocket(void) = 0;
+
+	virtual void
+	setUDPNonBlocking(int non_block) = 0;
+
+	virtual int
+	makeUDPServer(int serverPortNum, char *serverName) = 0;
 
-class UDP_communication {
+	virtual int
+	makeUDPClient(int socketPortNum, char *clientName) = 0;
+};
+
+class UDP_communication : public UDPTransport {
 public:
 	UDP_communication();
 
@@ -54,6 +126,11 @@ public:
 			int   bufLen,
 			char *inetAddr);
 
+	int
+	readUDPSocketFrom(char        *buf,
+			int          bufLen,
+			UDPEndpoint *peer);
+
 	int
 	closeUDPSocket(void);
 
@@ -61,28 +138,211 @@ public:
 	writeUDPSocket(char *buf,
 			int   bufLen);
 
+	int
+	writeUDPSocketTo(char              *buf,
+			int                bufLen,
+			const UDPEndpoint *peer);
+
+	int
+	writeUDPSocketV(const struct iovec *iov,
+			int                 iovcnt);
+
+	int
+	writeUDPSocketVTo(const struct iovec *iov,
+			int                 iovcnt,
+			const UDPEndpoint  *peer);
+
+	int
+	readUDPSocketV(const struct iovec *iov,
+			int                 iovcnt,
+			UDPEndpoint        *peer);
+
+	int
+	readUDPSocketBatch(UDPMessage *msgs,
+			int         n_msgs);
+
+	int
+	writeUDPSocketBatch(UDPMessage *msgs,
+			int         n_msgs);
+
+	int
+	writeUDPSocketSegmented(char *buf,
+			int   bufLen,
+			int   segSize);
+
+	int
+	readUDPSocketSegmented(char        *buf,
+			int          bufLen,
+			UDPEndpoint *peer,
+			int         *segSize);
+
+	int
+	setUDPGRO(int enable);
+
+	int
+	setUDPTimestamping(int rx, int tx, int hardware);
+
+	int
+	readUDPSocketTimestamped(char            *buf,
+			int              bufLen,
+			UDPEndpoint     *peer,
+			struct timespec *rxTime);
+
+	int
+	readUDPTxTimestamp(uint32_t        *id,
+			struct timespec *txTime);
+
 	int
 	checkUDPSocket(void);
 
 	void
 	setUDPNonBlocking(int non_block);
 
+	int
+	setUDPReusePort(int reuse);
+
+	int
+	setUDPBufferSizes(int rcvbuf, int sndbuf);
+
+	int
+	getUDPBufferSizes(int *rcvbuf, int *sndbuf);
+
+	int
+	autoTuneUDPBuffers(int msgLen, double rate, double maxStall);
+
+	int
+	setUDPDropCounting(int enable);
+
 	int
 	makeUDPServer(int serverPortNum, char *serverName);
 
 	int
 	makeUDPClient(int socketPortNum, char *clientName);
 
+	int
+	makeUDPConnectedClient(int socketPortNum, char *clientName);
+
+	int
+	makeUDPConnectedServer(int serverPortNum, char *serverName);
+
+	int
+	makeUDPMulticastPublisher(int socketPortNum, char *groupName, char *interfaceName,
+			int ttl, int loopback);
+
+	int
+	makeUDPMulticastSubscriber(int serverPortNum, char *groupName, char *interfaceName);
+
+	int
+	joinUDPMulticastGroup(char *groupName, char *interfaceName);
+
+	int
+	leaveUDPMulticastGroup(char *groupName, char *interfaceName);
+
+	int
+	setUDPMulticastInterface(char *interfaceName);
+
+	int
+	setUDPMulticastTTL(int ttl);
+
+	int
+	setUDPMulticastLoopback(int loopback);
+
+	int
+	getUDPSocketFd(void);
+
+	int
+	isUDPConnected(void);
+
+	void
+	setUDPCapture(UDPCapture *capture);
+
 
 	bool                active;          //!< socket active or not
+	unsigned long       nKernelDrops;    //!< datagrams dropped by the kernel so far
+	unsigned long       nDropEvents;     //!< receptions at which new drops were reported
 
 
 private:
+	int
+	recvUDPMessage(char        *buf,
+			int          bufLen,
+			UDPEndpoint *peer,
+			UDPRecvInfo *info);
+
+	int
+	recvUDPMessageV(const struct iovec *iov,
+			int                 iovcnt,
+			int                 flags,
+			UDPEndpoint        *peer,
+			UDPRecvInfo        *info);
+
+	int
+	sendUDPMessageV(const struct iovec       *iov,
+			int                       iovcnt,
+			const struct sockaddr_in *addr);
+
+	int
+	lockOnUDPPeer(struct sockaddr_in *peerAddr);
+
+	void
+	countUDPDrops(uint32_t drops);
+
+	int
+	setUDPBufferSize(int optForce, int opt, int size);
+
+	void
+	captureUDPPackets(int                       direction,
+			const char               *buf,
+			int                       len,
+			int                       segSize,
+			const struct sockaddr_in *addr);
+
+	void
+	captureUDPPacketV(int                       direction,
+			const struct iovec       *iov,
+			int                       iovcnt,
+			int                       len,
+			const struct sockaddr_in *addr);
+
 	struct sockaddr_in  socketAddr;      //!< server's socket address
 	bool				is_server;
+	bool                connected;       //!< socket is connected to a single peer
+	bool                lock_on_peer;    //!< server connects to the first peer
 	int                 sFd;             //!< socket file descriptor
 	bool                non_block;       //!< TRUE if non-blocking socket, FALSE otherwise
+	bool                count_drops;     //!< SO_RXQ_OVFL is enabled
+	UDPCapture         *capture;         //!< records all datagrams, or NULL
+
+
+};
+
+//! maps peer endpoints to stable integer ids
+class UDPPeerTable {
+public:
+	UDPPeerTable(int max_peers);
+
+	virtual ~UDPPeerTable();
+
+	int
+	getPeerId(const UDPEndpoint *peer);
+
+	int
+	findPeerId(const UDPEndpoint *peer);
+
+	int
+	getPeerEndpoint(int id, UDPEndpoint *peer);
+
+	int                 nPeers;          //!< number of known peers
+
+
+private:
+	int
+	findSlot(const UDPEndpoint *peer);
 
+	int                *slots;           //!< hash slots with peer ids, ERROR if empty
+	UDPEndpoint        *peers;           //!< endpoints indexed by peer id
+	int                 capacity;        //!< number of hash slots (power of 2)
+	int                 maxPeers;
 
 };
 
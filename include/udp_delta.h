@@ -0,0 +1,111 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_delta.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  header file for udp_delta.cpp
+
+  ============================================================================*/
+
+#ifndef UDP_DELTA_H_
+#define UDP_DELTA_H_
+
+#include <stdint.h>
+
+#include "udp_communication.h"
+
+#define UDP_DELTA_MAGIC      0x444C   //!< marks a delta codec datagram
+#define UDP_DELTA_MIN_ZEROS  4        //!< shorter unchanged runs stay in a literal
+#define UDP_DELTA_MAX_LATE   1024     //!< older keyframes are taken as a restart of the sender
+
+namespace udp_communication {
+
+//! the header in front of every frame datagram (host byte order)
+typedef struct {
+	uint16_t            magic;           //!< UDP_DELTA_MAGIC
+	uint8_t             type;            //!< UDP_DELTA_KEYFRAME or UDP_DELTA_DELTA
+	uint8_t             reserved;
+	uint32_t            seq;             //!< frame counter of the sender
+	uint32_t            frame_len;       //!< length of the decoded frame
+	uint32_t            payload_len;     //!< bytes following the header
+} UDPDeltaHeader;
+
+enum { UDP_DELTA_KEYFRAME, UDP_DELTA_DELTA };
+
+class UDPDeltaCodec {
+public:
+	UDPDeltaCodec();
+
+	virtual ~UDPDeltaCodec();
+
+	int
+	initUDPDelta(UDP_communication *udp,
+			int max_frame_len,
+			int keyframe_interval);
+
+	int
+	writeUDPDelta(char *frame,
+			int   frameLen);
+
+	int
+	readUDPDelta(char       **frame,
+			UDPEndpoint *peer);
+
+	static int
+	encodeUDPDelta(const char *prev,
+			const char *cur,
+			int         len,
+			char       *out,
+			int         maxOutLen,
+			char       *scratch,
+			uint64_t   *mask);
+
+	static int
+	decodeUDPDelta(const char *enc,
+			int         encLen,
+			char       *frame,
+			int         len);
+
+
+	bool                active;          //!< codec initialized or not
+	unsigned long       nKeyframes;      //!< keyframes sent or received
+	unsigned long       nDeltas;         //!< deltas sent or applied
+	unsigned long       nDeltasSkipped;  //!< deltas without a valid base frame
+	unsigned long       nLate;           //!< keyframes older than the last frame
+	unsigned long       nBytesRaw;       //!< frame bytes before encoding
+	unsigned long       nBytesEncoded;   //!< payload bytes after encoding
+
+
+private:
+	UDP_communication  *udp;
+	int                 maxFrameLen;
+	int                 keyframeInterval;
+
+	// sending
+	char               *prevFrame;       //!< the last frame sent
+	char               *sendBuf;         //!< header + payload
+	char               *scratch;         //!< XOR of two frames
+	uint64_t           *mask;            //!< bitmap of changed bytes
+	int                 prevLen;
+	uint32_t            sendSeq;
+	int                 sinceKeyframe;
+
+	// receiving
+	char               *frameBuf;        //!< the reconstructed frame
+	char               *recvBuf;
+	int                 frameLen;
+	uint32_t            recvSeq;         //!< the last frame delivered
+	bool                haveFrame;
+	bool                haveSeq;         //!< a frame was delivered before
+
+};
+
+}
+
+#endif /* UDP_DELTA_H_ */
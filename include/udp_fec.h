@@ -0,0 +1,146 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_fec.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  header file for udp_fec.cpp
+
+  ============================================================================*/
+
+#ifndef UDP_FEC_H_
+#define UDP_FEC_H_
+
+#include <stdint.h>
+
+#include "udp_communication.h"
+
+#define UDP_FEC_MAGIC        0x4645   //!< marks a FEC datagram
+#define UDP_FEC_MAX_PARITY   16       //!< max. parity packets per block
+#define UDP_FEC_BLOCKS       4        //!< blocks the receiver keeps open
+#define UDP_FEC_RECOVERED    0x01     //!< flag: datagram was rebuilt from parity
+
+namespace udp_communication {
+
+void
+testUDPFec(int n_packets, char *name);
+
+//! the header in front of every FEC datagram (host byte order)
+typedef struct {
+	uint16_t            magic;           //!< UDP_FEC_MAGIC
+	uint8_t             k;               //!< data packets in the block
+	uint8_t             m;               //!< parity packets in the block
+	uint32_t            block;           //!< block counter of the sender
+	uint8_t             index;           //!< 0...k-1 data, k...k+m-1 parity
+	uint8_t             flags;           //!< UDP_FEC_RECOVERED, receiver side only
+	uint16_t            len;             //!< payload length, or shard length of parity
+} UDPFecHeader;
+
+class UDPFecChannel {
+public:
+	UDPFecChannel();
+
+	virtual ~UDPFecChannel();
+
+	int
+	initUDPFec(UDP_communication *udp,
+			int k,
+			int m,
+			int max_msg_len);
+
+	int
+	writeUDPFec(char *buf,
+			int   bufLen);
+
+	int
+	flushUDPFec(void);
+
+	int
+	readUDPFec(char         *buf,
+			int           bufLen,
+			UDPFecHeader *hdr);
+
+	void
+	setUDPFecLoss(double loss_rate,
+			unsigned int seed);
+
+	static const char *
+	getUDPFecKernel(void);
+
+
+	bool                active;          //!< channel initialized or not
+	unsigned long       nDataSent;
+	unsigned long       nParitySent;
+	unsigned long       nSimDropped;     //!< datagrams dropped by the loss simulation
+	unsigned long       nReceived;       //!< data datagrams received
+	unsigned long       nRecovered;      //!< data datagrams rebuilt from parity
+	unsigned long       nUnrecoverable;  //!< data datagrams lost for good
+	unsigned long       nDuplicates;
+	unsigned long       nLate;           //!< data datagrams of closed blocks, delivered
+	unsigned long       nStale;          //!< parity datagrams of closed blocks
+	unsigned long       nResyncs;        //!< block counter jumped back, e.g., sender restart
+	unsigned long       nInvalid;        //!< datagrams without a valid header
+
+
+private:
+	//! receiver state of one block
+	typedef struct {
+		bool                used;
+		bool                done;            //!< all data present or rebuilt
+		uint32_t            block;
+		int                 kData;           //!< k of the data headers
+		int                 kUsed;           //!< k of the parity headers, 0 if unknown
+		int                 m;               //!< m of the parity headers
+		int                 shardLen;        //!< parity length, 0 if unknown
+		int                 nData;
+		int                 nParity;
+		uint8_t             have[256];
+		uint8_t            *shards;          //!< (k+m) shards of shardMax bytes
+	} Block;
+
+	int
+	sendUDPFecPacket(UDPFecHeader *hdr, const uint8_t *payload, int len);
+
+	Block *
+	getUDPFecBlock(uint32_t block);
+
+	void
+	closeUDPFecBlock(Block *b);
+
+	void
+	decodeUDPFecBlock(Block *b);
+
+	UDP_communication  *udp;
+	int                 k;
+	int                 m;
+	int                 shardMax;        //!< max_msg_len + 2 length bytes
+
+	// sender
+	uint32_t            sendBlock;
+	int                 sendCount;       //!< data packets in the current block
+	int                 sendShardLen;    //!< longest shard of the current block
+	uint8_t            *sendShards;      //!< k shards of shardMax bytes
+	char               *sendBuf;         //!< parity shard being sent
+	double              lossRate;
+	unsigned int        lossSeed;
+
+	// receiver
+	Block               blocks[UDP_FEC_BLOCKS];
+	bool                recvStarted;     //!< a block was opened before
+	uint32_t            recvNewest;      //!< newest block opened
+	char               *recvBuf;
+	uint8_t            *scratch;         //!< m shards for decoding
+	Block              *pendingBlock;    //!< block with rebuilt, undelivered data
+	int                 pending[UDP_FEC_MAX_PARITY];
+	int                 nPending;
+
+};
+
+}
+
+#endif /* UDP_FEC_H_ */
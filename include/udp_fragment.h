@@ -0,0 +1,118 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_fragment.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  header file for udp_fragment.cpp
+
+  ============================================================================*/
+
+#ifndef UDP_FRAGMENT_H_
+#define UDP_FRAGMENT_H_
+
+#include <stdint.h>
+
+#include "udp_communication.h"
+
+#define UDP_FRAG_MAGIC       0x4652   //!< marks a fragment datagram
+#define UDP_FRAG_RECV_LEN    65536    //!< receive buffer size, large enough for GRO
+#define UDP_GSO_MAX_SEGS     64       //!< kernel limit of segments per GSO send
+#define UDP_GSO_MAX_BYTES    65000    //!< stay below the max. IPv4 UDP payload
+
+namespace udp_communication {
+
+//! the header in front of every fragment (host byte order)
+typedef struct {
+	uint16_t            magic;           //!< UDP_FRAG_MAGIC
+	uint16_t            frag_index;      //!< index of this fragment
+	uint16_t            n_frags;         //!< number of fragments of the message
+	uint16_t            reserved;
+	uint32_t            msg_id;          //!< message counter of the sender
+	uint32_t            msg_len;         //!< length of the complete message
+	uint32_t            offset;          //!< offset of this fragment in the message
+} UDPFragHeader;
+
+class UDPFragmenter {
+public:
+	UDPFragmenter();
+
+	virtual ~UDPFragmenter();
+
+	int
+	initUDPFragmenter(UDP_communication *udp,
+			int    max_msg_len,
+			int    frag_size,
+			int    n_slabs,
+			double timeout);
+
+	int
+	setUDPFragmentOffload(int gso, int gro);
+
+	int
+	writeUDPFragmented(char *buf,
+			int   bufLen);
+
+	int
+	readUDPFragmented(char       **msg,
+			UDPEndpoint *peer);
+
+
+	bool                active;          //!< fragmenter initialized or not
+	unsigned long       nMsgsReceived;   //!< completely reassembled messages
+	unsigned long       nMsgsDropped;    //!< incomplete messages dropped
+	unsigned long       nFragsReceived;  //!< valid fragments received
+	unsigned long       nFragsInvalid;   //!< datagrams that were no valid fragment
+
+
+private:
+	enum SlabState { SLAB_FREE, SLAB_ASSEMBLING, SLAB_DELIVERED };
+
+	//! a preallocated reassembly buffer for one message
+	typedef struct {
+		SlabState           state;
+		uint32_t            msg_id;
+		UDPEndpoint         peer;
+		int                 n_frags;
+		int                 n_received;
+		int                 msg_len;
+		uint64_t            deadline_ns;
+		uint64_t           *received;    //!< bitmap of received fragments
+		char               *data;
+	} Slab;
+
+	int
+	processFragment(char *frag, int len, UDPEndpoint *peer);
+
+	UDP_communication  *udp;
+	int                 maxMsgLen;
+	int                 fragSize;        //!< payload bytes per fragment
+	int                 maxFrags;
+	uint64_t            timeoutNs;
+	bool                useGSO;
+	uint32_t            nextMsgId;
+
+	// sending
+	char               *sendBuf;         //!< staging area for all fragments
+	UDPMessage         *sendMsgs;        //!< fragment slots for batched sends
+
+	// receiving
+	Slab               *slabs;
+	int                 nSlabs;
+	int                 bitmapWords;
+	char               *recvBuf;
+	int                 pendingPos;      //!< unprocessed rest of a GRO buffer
+	int                 pendingLen;
+	int                 pendingSegSize;
+	UDPEndpoint         pendingPeer;
+
+};
+
+}
+
+#endif /* UDP_FRAGMENT_H_ */
@@ -0,0 +1,90 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_mailbox.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  header file for udp_mailbox.cpp
+
+  ============================================================================*/
+
+#ifndef UDP_MAILBOX_H_
+#define UDP_MAILBOX_H_
+
+#include <atomic>
+#include <thread>
+#include <stdint.h>
+
+#include "udp_communication.h"
+
+namespace udp_communication {
+
+//! information about the message returned by readUDPMailbox()
+typedef struct {
+	double              age;             //!< time since reception [s]
+	unsigned long       seq;             //!< number of this message since start
+	unsigned long       n_overwritten;   //!< messages replaced before being read
+	bool                is_new;          //!< FALSE if returned before already
+	struct sockaddr_in  addr;            //!< source address
+} UDPMailboxInfo;
+
+class UDPMailbox {
+public:
+	UDPMailbox();
+
+	virtual ~UDPMailbox();
+
+	int
+	startUDPMailbox(UDP_communication *udp,
+			int max_msg_len);
+
+	int
+	stopUDPMailbox(void);
+
+	int
+	readUDPMailbox(char           *buf,
+			int             bufLen,
+			UDPMailboxInfo *info);
+
+
+	bool                active;          //!< receive thread running or not
+
+
+private:
+	//! one buffer of the triple buffer
+	typedef struct {
+		char               *data;
+		int                 len;
+		uint64_t            t_ns;        //!< CLOCK_MONOTONIC reception time
+		unsigned long       seq;
+		struct sockaddr_in  addr;
+	} Slot;
+
+	void
+	receiveLoop(void);
+
+	UDP_communication  *udp;
+	int                 maxMsgLen;
+	int                 wakeupFd;        //!< eventfd to stop the thread
+	std::atomic<bool>   running;
+	std::thread         thread;
+
+	// triple buffer: the writer owns back, the reader owns front, and middle
+	// is exchanged atomically; the FRESH bit marks an unread middle slot
+	Slot                slots[3];
+	std::atomic<int>    middle;
+	int                 back;
+	int                 front;
+	unsigned long       seq;
+	std::atomic<unsigned long> nOverwritten;
+
+};
+
+}
+
+#endif /* UDP_MAILBOX_H_ */
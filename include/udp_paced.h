@@ -0,0 +1,77 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_paced.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  header file for udp_paced.cpp
+
+  ============================================================================*/
+
+#ifndef UDP_PACED_H_
+#define UDP_PACED_H_
+
+#include <stdint.h>
+
+#include "udp_communication.h"
+
+namespace udp_communication {
+
+class UDPPacedSender {
+public:
+	UDPPacedSender();
+
+	virtual ~UDPPacedSender();
+
+	int
+	initUDPPacer(UDP_communication *udp,
+			double rate);
+
+	int
+	setUDPTokenBucket(double bytes_per_s,
+			double burst_bytes);
+
+	int
+	waitUDPPacer(void);
+
+	int
+	writeUDPPaced(char *buf,
+			int   bufLen);
+
+	int
+	writeUDPShaped(char *buf,
+			int   bufLen);
+
+
+	bool                active;          //!< pacer initialized or not
+	unsigned long       nPeriods;        //!< deadlines waited for
+	unsigned long       nDeadlineMisses; //!< deadlines that had passed already
+	unsigned long       nSkippedPeriods; //!< periods dropped to catch up
+	double              maxLateness;     //!< worst wake up delay [s]
+	unsigned long       nShaped;         //!< datagrams delayed by the token bucket
+
+
+private:
+	void
+	sleepUntil(uint64_t t_ns);
+
+	UDP_communication  *udp;
+	uint64_t            periodNs;
+	uint64_t            nextDeadlineNs;
+
+	// token bucket
+	double              bucketRate;      //!< refill rate [bytes/s], 0 if off
+	double              bucketBurst;     //!< bucket size [bytes]
+	double              tokens;
+	uint64_t            lastRefillNs;
+
+};
+
+}
+
+#endif /* UDP_PACED_H_ */
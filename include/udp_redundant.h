@@ -0,0 +1,119 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_redundant.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  header file for udp_redundant.cpp
+
+  ============================================================================*/
+
+#ifndef UDP_REDUNDANT_H_
+#define UDP_REDUNDANT_H_
+
+#include <atomic>
+#include <stdint.h>
+
+#include "udp_communication.h"
+#include "udp_sequenced.h"
+
+#define UDP_REDUNDANT_MAX_PATHS  4        //!< max. number of redundant paths
+#define UDP_REDUNDANT_WINDOW     4096     //!< deduplication window in packets
+#define UDP_REDUNDANT_WORDS      (UDP_REDUNDANT_WINDOW/32)
+
+namespace udp_communication {
+
+//! the header of a redundant datagram: the sequenced header, and the epoch of
+//! the sender, which tells a restarted sender from late copies of old datagrams
+typedef struct {
+	UDPSeqHeader        seq;
+	uint32_t            epoch;           //!< random per sender start, low 24 bits never 0
+	uint32_t            reserved;
+} UDPRedundantHeader;
+
+class UDPRedundantChannel {
+public:
+	UDPRedundantChannel();
+
+	virtual ~UDPRedundantChannel();
+
+	int
+	initUDPRedundant(UDP_communication **paths,
+			int n_paths,
+			int max_streams,
+			int max_msg_len);
+
+	int
+	writeUDPRedundant(int   stream_id,
+			char *buf,
+			int   bufLen);
+
+	int
+	readUDPRedundant(char         *buf,
+			int           bufLen,
+			UDPSeqHeader *hdr,
+			int          *path,
+			int           timeout_ms);
+
+	int
+	readUDPRedundantPath(int           path,
+			char         *buf,
+			int           bufLen,
+			UDPSeqHeader *hdr);
+
+	int
+	resetUDPRedundantStream(int stream_id);
+
+
+	bool                active;          //!< channel initialized or not
+	std::atomic<unsigned long> nDelivered;  //!< first copies delivered
+	std::atomic<unsigned long> nDuplicates; //!< later copies discarded
+	std::atomic<unsigned long> nTooOld;     //!< discarded, older than the window or the epoch
+	std::atomic<unsigned long> nRestarts;   //!< sender restarts seen on any stream
+	std::atomic<unsigned long> nInvalid;    //!< datagrams without a valid header
+	std::atomic<unsigned long> nFirst[UDP_REDUNDANT_MAX_PATHS]; //!< wins per path
+	unsigned long       nSendErrors[UDP_REDUNDANT_MAX_PATHS];   //!< failed sends per path
+
+
+private:
+	int
+	acceptUDPEpoch(int stream_id, uint32_t epoch, uint32_t *gen);
+
+	int
+	acceptUDPSeq(int stream_id, uint32_t seq, uint32_t gen);
+
+	int
+	readUDPRedundantOnce(int           path,
+			char         *buf,
+			int           bufLen,
+			UDPSeqHeader *hdr,
+			int          *len);
+
+	UDP_communication  *paths[UDP_REDUNDANT_MAX_PATHS];
+	int                 nPaths;
+	int                 nextPath;        //!< round robin start of readUDPRedundant
+	int                 maxStreams;
+	int                 maxMsgLen;
+	uint32_t           *nextSeq;         //!< send sequence numbers per stream
+	uint32_t            epoch;           //!< epoch of this sender
+
+	//! per stream epoch state: the current epoch of the sender (32 bits), the
+	//! low 24 bits of the previous one, and a generation counter (8 bits) that
+	//! is incremented with every new epoch
+	std::atomic<uint64_t> *epochs;
+
+	//! per stream window: each word holds a 32 bit tag, i.e., the generation
+	//! (8 bits) and seq/32 (24 bits), and a bitmap of the 32 sequence numbers
+	//! of this tag that were received
+	std::atomic<uint64_t> *window;
+
+};
+
+}
+
+#endif /* UDP_REDUNDANT_H_ */
@@ -0,0 +1,168 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_reliable.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  header file for udp_reliable.cpp
+
+  ============================================================================*/
+
+#ifndef UDP_RELIABLE_H_
+#define UDP_RELIABLE_H_
+
+#include <stdint.h>
+
+#include "udp_communication.h"
+
+#define UDP_REL_MAGIC        0x524C   //!< marks a multiplexed datagram
+#define UDP_REL_MAX_WINDOW   64       //!< max. reliable messages in flight
+#define UDP_REL_MIN_RTO_NS   1000000ULL     //!< min. retransmission time out
+#define UDP_REL_MAX_RTO_NS   1000000000ULL  //!< max. retransmission time out
+#define UDP_REL_INIT_RTO_NS  20000000ULL    //!< time out before the first RTT sample
+
+namespace udp_communication {
+
+enum { UDP_REL_STATE, UDP_REL_DATA, UDP_REL_ACK, UDP_REL_FORWARD };
+
+//! the header in front of every datagram of the channel (host byte order)
+typedef struct {
+	uint16_t            magic;           //!< UDP_REL_MAGIC
+	uint8_t             type;            //!< UDP_REL_STATE, _DATA, _ACK, or _FORWARD
+	uint8_t             reserved;
+	uint32_t            seq;             //!< DATA: sequence number, ACK: next expected
+	uint32_t            base;            //!< DATA/FORWARD: oldest seq the sender still sends
+	uint32_t            len;             //!< payload length
+	uint32_t            session;         //!< random id of the sender's start
+	uint32_t            peerSession;     //!< ACK: session of the acknowledged messages
+} UDPRelHeader;
+
+class UDPReliableChannel {
+public:
+	UDPReliableChannel();
+
+	virtual ~UDPReliableChannel();
+
+	int
+	initUDPReliable(UDP_communication *udp,
+			int max_msg_len,
+			int window,
+			int max_retries);
+
+	int
+	writeUDPUnreliable(char *buf,
+			int   bufLen);
+
+	int
+	writeUDPReliable(char *buf,
+			int   bufLen);
+
+	int
+	readUDPMux(char *buf,
+			int   bufLen,
+			int  *type);
+
+	int
+	serviceUDPReliable(void);
+
+	int
+	getUDPReliablePending(void);
+
+
+	bool                active;          //!< channel initialized or not
+	unsigned long       nStateSent;
+	unsigned long       nStateReceived;
+	unsigned long       nReliableSent;   //!< reliable messages accepted for sending
+	unsigned long       nRetransmits;
+	unsigned long       nAcked;
+	unsigned long       nExpired;        //!< given up after max_retries
+	unsigned long       nQueueFull;      //!< writes rejected since the window was full
+	unsigned long       nDelivered;      //!< reliable messages delivered in order
+	unsigned long       nSkipped;        //!< reliable messages the sender gave up on
+	unsigned long       nDuplicates;
+	unsigned long       nInvalid;        //!< datagrams without a valid header
+	unsigned long       nRestarts;       //!< new sessions of the peer
+	unsigned long       nStale;          //!< datagrams of a previous session
+	double              srtt;            //!< smoothed round trip time [s]
+
+
+private:
+	typedef struct {
+		bool                used;
+		bool                sacked;          //!< selectively acknowledged
+		uint32_t            seq;
+		int                 len;
+		int                 retries;
+		uint64_t            sentNs;          //!< time of the last transmission
+		uint64_t            rtoNs;           //!< time out of this message
+	} SendSlot;
+
+	typedef struct {
+		bool                present;
+		uint32_t            seq;
+		int                 len;
+	} RecvSlot;
+
+	int
+	sendUDPRelPacket(int type, uint32_t seq, const char *buf, int len);
+
+	void
+	transmitUDPSlot(SendSlot *s, uint64_t now);
+
+	void
+	ackUDPReliable(uint32_t next, uint64_t sack, uint64_t now);
+
+	void
+	releaseUDPSlots(void);
+
+	void
+	restartUDPSender(void);
+
+	int
+	receiveUDPData(UDPRelHeader *hdr, const char *data);
+
+	void
+	sendUDPAck(void);
+
+	int
+	acceptUDPSession(uint32_t id, uint32_t *cur, uint32_t *prev);
+
+	UDP_communication  *udp;
+	int                 maxMsgLen;
+	int                 window;
+	int                 maxRetries;
+	char               *recvBuf;         //!< payload of a datagram, if buf is too short
+	int                 recvLen;         //!< max. payload of a datagram
+
+	// sender
+	SendSlot            sendSlots[UDP_REL_MAX_WINDOW];
+	char               *sendData;        //!< window x maxMsgLen message pool
+	uint32_t            sendNext;        //!< next sequence number
+	uint32_t            sendBase;        //!< oldest sequence number not released
+	uint32_t            peerNext;        //!< the peer's last cumulative ack
+	uint64_t            rttvarNs;
+	uint64_t            srttNs;
+	uint64_t            rtoNs;
+	uint64_t            forwardNs;       //!< last FORWARD transmission
+	uint32_t            session;         //!< random id of this start of the channel
+	uint32_t            ackSession;      //!< session of the receiver that acknowledges
+	uint32_t            prevAckSession;
+
+	// receiver
+	RecvSlot            recvSlots[UDP_REL_MAX_WINDOW];
+	char               *recvData;        //!< window x maxMsgLen reorder pool
+	uint32_t            recvNext;        //!< next expected (cumulative ack)
+	uint32_t            deliverNext;     //!< next message to deliver
+	uint32_t            recvSession;     //!< session of the sender, 0 before any data
+	uint32_t            prevRecvSession;
+
+};
+
+}
+
+#endif /* UDP_RELIABLE_H_ */
@@ -0,0 +1,125 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_sequenced.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  header file for udp_sequenced.cpp
+
+  ============================================================================*/
+
+#ifndef UDP_SEQUENCED_H_
+#define UDP_SEQUENCED_H_
+
+#include <atomic>
+#include <stdint.h>
+
+#include "udp_communication.h"
+
+#define UDP_SEQ_MAGIC        0x5351   //!< marks a sequenced datagram
+#define UDP_SEQ_WINDOW       64       //!< duplicate detection window in packets
+#define UDP_SEQ_HIST_BINS    32       //!< log2 latency histogram bins
+#define UDP_SEQ_RESTART      4        //!< consecutive old datagrams that mean a restart
+
+namespace udp_communication {
+
+//! the header in front of every sequenced datagram (host byte order)
+typedef struct {
+	uint16_t            magic;           //!< UDP_SEQ_MAGIC
+	uint16_t            stream_id;       //!< stream of this datagram
+	uint32_t            seq;             //!< sequence number within the stream
+	uint64_t            send_ns;         //!< CLOCK_REALTIME send time [ns]
+} UDPSeqHeader;
+
+//! a snapshot of the link statistics of one stream
+typedef struct {
+	unsigned long       received;        //!< datagrams received (incl. duplicates)
+	unsigned long       lost;            //!< missing sequence numbers
+	unsigned long       reordered;       //!< datagrams arriving after a newer one
+	unsigned long       duplicates;      //!< datagrams received more than once
+	unsigned long       restarts;        //!< sender restarts of the sequence
+	unsigned long       bytes;           //!< payload bytes received
+	double              latency_min;     //!< one-way latency [s]
+	double              latency_max;
+	double              latency_mean;
+	//! latency_hist[i] counts latencies in [2^(i-1), 2^i) us, bin 0 is < 1us
+	unsigned long       latency_hist[UDP_SEQ_HIST_BINS];
+} UDPStreamStats;
+
+class UDPSequencedChannel {
+public:
+	UDPSequencedChannel();
+
+	virtual ~UDPSequencedChannel();
+
+	int
+	initUDPSequenced(UDP_communication *udp,
+			int max_streams,
+			int max_msg_len);
+
+	int
+	writeUDPSequenced(int   stream_id,
+			char *buf,
+			int   bufLen);
+
+	int
+	readUDPSequenced(char         *buf,
+			int           bufLen,
+			UDPSeqHeader *hdr,
+			UDPEndpoint  *peer);
+
+	int
+	getUDPStreamStats(int stream_id,
+			UDPStreamStats *stats);
+
+	int
+	resetUDPStreamStats(int stream_id);
+
+
+	bool                active;          //!< channel initialized or not
+	std::atomic<unsigned long> nInvalid; //!< datagrams without a valid header
+
+
+private:
+	//! lock-free per stream counters: written by the receiving thread only,
+	//! readable from any thread
+	typedef struct {
+		std::atomic<unsigned long> received;
+		std::atomic<unsigned long> lost;
+		std::atomic<unsigned long> reordered;
+		std::atomic<unsigned long> duplicates;
+		std::atomic<unsigned long> restarts;
+		std::atomic<unsigned long> bytes;
+		std::atomic<int64_t>       latency_min_ns;
+		std::atomic<int64_t>       latency_max_ns;
+		std::atomic<int64_t>       latency_sum_ns;
+		std::atomic<unsigned long> latency_hist[UDP_SEQ_HIST_BINS];
+
+		// receiver state
+		bool                       started;
+		uint32_t                   highest;  //!< highest sequence number so far
+		uint64_t                   window;   //!< bit i: highest-i was received
+		uint32_t                   span;     //!< valid bits of window below highest
+		uint32_t                   stale;    //!< run of consecutive too old datagrams
+		uint32_t                   staleSeq; //!< last datagram of that run
+	} Stream;
+
+	void
+	updateStream(Stream *st, UDPSeqHeader *hdr, int len);
+
+	UDP_communication  *udp;
+	int                 maxStreams;
+	int                 maxMsgLen;
+	Stream             *streams;
+	uint32_t           *nextSeq;         //!< send sequence numbers per stream
+
+};
+
+}
+
+#endif /* UDP_SEQUENCED_H_ */
@@ -0,0 +1,104 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_server_group.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  header file for udp_server_group.cpp
+
+  ============================================================================*/
+
+#ifndef UDP_SERVER_GROUP_H_
+#define UDP_SERVER_GROUP_H_
+
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <stdint.h>
+
+#include "udp_communication.h"
+
+namespace udp_communication {
+
+//! how datagrams are distributed over the workers of a server group
+enum UDPSteering {
+	UDP_STEER_FLOW,          //!< kernel hash of the 4-tuple (default)
+	UDP_STEER_SOURCE,        //!< source IP address modulo the number of workers
+	UDP_STEER_CPU            //!< the CPU that received the datagram
+};
+
+//! called in the worker thread with each batch of received datagrams
+typedef std::function<void(int worker, UDPMessage *msgs, int n_msgs)> UDPGroupHandler;
+
+//! a snapshot of the load of one worker
+typedef struct {
+	unsigned long       packets;         //!< datagrams received
+	unsigned long       bytes;           //!< bytes received
+	unsigned long       batches;         //!< handler calls
+	double              busy;            //!< time spent in the handler [s]
+	int                 cpu;             //!< the core the worker is pinned to, or -1
+} UDPWorkerStats;
+
+class UDPServerGroup {
+public:
+	UDPServerGroup();
+
+	virtual ~UDPServerGroup();
+
+	int
+	startUDPServerGroup(int             serverPortNum,
+			char           *serverName,
+			int             n_workers,
+			int             max_msg_len,
+			UDPSteering     steering,
+			const int      *cpus,
+			UDPGroupHandler handler);
+
+	int
+	stopUDPServerGroup(void);
+
+	UDP_communication *
+	getUDPWorkerSocket(int worker);
+
+	int
+	getUDPWorkerStats(int worker,
+			UDPWorkerStats *stats);
+
+
+	bool                active;          //!< workers running or not
+	int                 nWorkers;
+
+
+private:
+	typedef struct {
+		UDP_communication         *udp;
+		std::thread                thread;
+		int                        cpu;
+		std::atomic<unsigned long> packets;
+		std::atomic<unsigned long> bytes;
+		std::atomic<unsigned long> batches;
+		std::atomic<uint64_t>      busy_ns;
+	} Worker;
+
+	int
+	attachUDPSteering(UDPSteering steering);
+
+	void
+	workerLoop(int worker);
+
+	Worker             *workers;
+	int                 maxMsgLen;
+	int                 wakeupFd;        //!< eventfd to stop the threads
+	std::atomic<bool>   running;
+	UDPGroupHandler     handler;
+
+};
+
+}
+
+#endif /* UDP_SERVER_GROUP_H_ */
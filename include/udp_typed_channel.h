@@ -0,0 +1,286 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_typed_channel.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  Typed message channels on top of UDP_communication: a TypedChannel<Msg>
+  sends and receives a plain struct instead of a char buffer. The message
+  lives inside the datagram buffer of the channel, such that it is filled
+  and read in place without any copy. At compile time, the struct is checked
+  to be trivially copyable with a fixed layout, and a schema hash of its type
+  name and size is embedded in every datagram, such that datagrams of a
+  mismatching peer are rejected instead of misinterpreted. The type name is
+  given explicitly with UDPTypeName<Msg> (see below), such that the hash does
+  not depend on the compiler that built the peer.
+
+  The wire format is little endian. On little endian hosts, no conversion
+  takes place. Big endian hosts need a specialization of UDPByteSwap<Msg>
+  that swaps all fields of the message.
+
+  Since the type name enters the schema hash, changing it breaks
+  compatibility, while changing the fields of a message without changing its
+  size does not -- increment the Version parameter in this case.
+
+  ============================================================================*/
+
+#ifndef UDP_TYPED_CHANNEL_H_
+#define UDP_TYPED_CHANNEL_H_
+
+#include <type_traits>
+#include <stdint.h>
+#include <string.h>
+
+#include "udp_communication.h"
+
+#define UDP_TYPED_MAGIC      0x5443   //!< marks a typed datagram
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define UDP_BIG_ENDIAN_HOST  1
+#else
+#define UDP_BIG_ENDIAN_HOST  0
+#endif
+
+namespace udp_communication {
+
+//! the header in front of every typed datagram (little endian)
+typedef struct {
+	uint16_t            magic;           //!< UDP_TYPED_MAGIC
+	uint16_t            reserved;
+	uint32_t            schema;          //!< schema hash of the message type
+} UDPTypedHeader;
+
+//! swaps the bytes of all fields of a message; only needed on big endian
+//! hosts, where it must be specialized for every message type
+template <typename Msg>
+struct UDPByteSwap {
+	static void swap(Msg &msg) {
+		static_assert(sizeof(Msg) == 0,
+			      "big endian host: specialize UDPByteSwap<Msg> for this message");
+	}
+};
+
+//! FNV-1a hash of a string, usable at compile time
+constexpr uint32_t
+udpFnv1a(const char *s, uint32_t h = 2166136261u)
+{
+	return *s == 0 ? h : udpFnv1a(s+1, (h ^ (uint8_t) *s) * 16777619u);
+}
+
+//! the name of a message type on the wire: by default the static member
+//! udpTypeName of the message, e.g.,
+//!   struct JointState { static constexpr const char *udpTypeName = "JointState"; ... };
+//! messages that cannot have members, e.g., structs shared with C code, need a
+//! specialization instead:
+//!   template <> struct UDPTypeName<JointState> { static constexpr const char *name = "JointState"; };
+template <typename Msg>
+struct UDPTypeName {
+	static constexpr const char *name = Msg::udpTypeName;
+};
+
+//! the schema hash of a message type: its name, size, alignment, and version
+template <typename Msg, uint32_t Version>
+constexpr uint32_t
+udpSchemaHash(void)
+{
+	return (udpFnv1a(UDPTypeName<Msg>::name) ^ (uint32_t) sizeof(Msg) * 2654435761u
+		^ (uint32_t) alignof(Msg) * 40503u) + Version;
+}
+
+template <typename Msg, uint32_t Version = 0>
+class TypedChannel {
+	static_assert(std::is_trivially_copyable<Msg>::value,
+		      "TypedChannel messages must be trivially copyable");
+	static_assert(std::is_standard_layout<Msg>::value,
+		      "TypedChannel messages must have standard layout");
+	static_assert(!std::is_pointer<Msg>::value,
+		      "TypedChannel messages must not be pointers");
+	static_assert(alignof(Msg) <= sizeof(UDPTypedHeader),
+		      "TypedChannel messages must not be aligned to more than 8 bytes");
+	static_assert(sizeof(UDPTypedHeader) + sizeof(Msg) <= UDP_MAX_PAYLOAD,
+		      "TypedChannel messages must fit into a single datagram");
+
+public:
+	static constexpr uint32_t schema = udpSchemaHash<Msg, Version>();
+
+	TypedChannel(UDP_communication *udp)
+	{
+		this->udp  = udp;
+		nRejected  = 0;
+		sendPacket.hdr.magic    = toWire16(UDP_TYPED_MAGIC);
+		sendPacket.hdr.reserved = 0;
+		sendPacket.hdr.schema   = toWire32(schema);
+		memset(&sendPacket.msg, 0, sizeof(Msg));
+		hdr = sendPacket.hdr;
+	}
+
+	//! the outgoing message, to be filled in place before send()
+	Msg &
+	message(void)
+	{
+		return sendPacket.msg;
+	}
+
+	//! sends message(); returns TRUE if all OK, otherwise FALSE
+	int
+	send(void)
+	{
+		return sendMessage(NULL);
+	}
+
+	//! sends message() to the given peer; returns TRUE if all OK, otherwise FALSE
+	int
+	sendTo(const UDPEndpoint *peer)
+	{
+		return sendMessage(peer);
+	}
+
+	//! sends msg directly from the caller's struct, gathered behind the header
+	int
+	send(const Msg &msg)
+	{
+#if UDP_BIG_ENDIAN_HOST
+		// the message needs to be converted, which the caller's struct cannot be
+		sendPacket.msg = msg;
+		return sendMessage(NULL);
+#else
+		struct iovec iov[2];
+
+		iov[0].iov_base = &hdr;
+		iov[0].iov_len  = sizeof(UDPTypedHeader);
+		iov[1].iov_base = (void *) &msg;
+		iov[1].iov_len  = sizeof(Msg);
+
+		return udp->writeUDPSocketV(iov, 2) == packetLen;
+#endif
+	}
+
+	//! receives the next valid message; the returned pointer stays valid until
+	//! the next receive() -- returns NULL on error or if no message is
+	//! available on a non-blocking socket
+	const Msg *
+	receive(UDPEndpoint *peer)
+	{
+		int n;
+
+		while (TRUE) {
+			n = udp->readUDPSocketFrom((char *) &recvPacket, sizeof(Packet), peer);
+			if (n <= 0)
+				return NULL;
+
+			if (n != packetLen ||
+			    fromWire16(recvPacket.hdr.magic) != UDP_TYPED_MAGIC ||
+			    fromWire32(recvPacket.hdr.schema) != schema) {
+				++nRejected;
+				continue;
+			}
+			break;
+		}
+
+#if UDP_BIG_ENDIAN_HOST
+		UDPByteSwap<Msg>::swap(recvPacket.msg);
+#endif
+
+		return &recvPacket.msg;
+	}
+
+	//! receives the next valid message directly into msg, without a copy;
+	//! returns TRUE if a message was received, otherwise FALSE, in which case
+	//! the content of msg is undefined
+	int
+	receive(Msg *msg, UDPEndpoint *peer)
+	{
+		UDPTypedHeader hdr;
+		struct iovec   iov[2];
+		int            n;
+
+		iov[0].iov_base = &hdr;
+		iov[0].iov_len  = sizeof(UDPTypedHeader);
+		iov[1].iov_base = msg;
+		iov[1].iov_len  = sizeof(Msg);
+
+		while (TRUE) {
+			n = udp->readUDPSocketV(iov, 2, peer);
+			if (n <= 0)
+				return FALSE;
+
+			if (n != packetLen ||
+			    fromWire16(hdr.magic) != UDP_TYPED_MAGIC ||
+			    fromWire32(hdr.schema) != schema) {
+				++nRejected;
+				continue;
+			}
+			break;
+		}
+
+#if UDP_BIG_ENDIAN_HOST
+		UDPByteSwap<Msg>::swap(*msg);
+#endif
+
+		return TRUE;
+	}
+
+
+	unsigned long       nRejected;       //!< datagrams of wrong size or schema
+
+
+private:
+	//! the datagram layout; the alignment check keeps padding out of the
+	//! front of msg, but Packet may have trailing padding, which is not sent
+	struct Packet {
+		UDPTypedHeader      hdr;
+		Msg                 msg;
+	};
+
+	//! the length of a datagram on the wire
+	static constexpr int packetLen = (int) (sizeof(UDPTypedHeader) + sizeof(Msg));
+
+	int
+	sendMessage(const UDPEndpoint *peer)
+	{
+		int n;
+
+		// the message is converted in place, and restored after sending
+#if UDP_BIG_ENDIAN_HOST
+		UDPByteSwap<Msg>::swap(sendPacket.msg);
+#endif
+
+		if (peer == NULL)
+			n = udp->writeUDPSocket((char *) &sendPacket, packetLen);
+		else
+			n = udp->writeUDPSocketTo((char *) &sendPacket, packetLen, peer);
+
+#if UDP_BIG_ENDIAN_HOST
+		UDPByteSwap<Msg>::swap(sendPacket.msg);
+#endif
+
+		return n == packetLen;
+	}
+
+	static uint16_t
+	toWire16(uint16_t v) { return UDP_BIG_ENDIAN_HOST ? __builtin_bswap16(v) : v; }
+
+	static uint32_t
+	toWire32(uint32_t v) { return UDP_BIG_ENDIAN_HOST ? __builtin_bswap32(v) : v; }
+
+	static uint16_t
+	fromWire16(uint16_t v) { return toWire16(v); }
+
+	static uint32_t
+	fromWire32(uint32_t v) { return toWire32(v); }
+
+	UDP_communication  *udp;
+	UDPTypedHeader      hdr;             //!< the header for send(const Msg &)
+	Packet              sendPacket;
+	Packet              recvPacket;
+
+};
+
+}
+
+#endif /* UDP_TYPED_CHANNEL_H_ */
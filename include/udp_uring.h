@@ -0,0 +1,100 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_uring.h
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  header file for udp_uring.cpp
+
+  ============================================================================*/
+
+#ifndef UDP_URING_H_
+#define UDP_URING_H_
+
+#include <sys/socket.h>
+#include <linux/io_uring.h>
+
+#include "udp_communication.h"
+
+#define UDP_URING_ENTRIES    64     //!< size of the submission queue
+#define UDP_URING_BGID       1      //!< id of the provided buffer group
+#define UDP_URING_RECV_TAG   1      //!< user_data of the multishot recvmsg
+#define UDP_URING_CANCEL_TAG 2      //!< user_data of its cancellation
+
+namespace udp_communication {
+
+class UDPUring {
+public:
+	UDPUring();
+
+	virtual ~UDPUring();
+
+	int
+	initUDPUring(UDP_communication *udp,
+			int n_buffers,
+			int buf_len);
+
+	int
+	reapUDPUring(UDPMessage *msgs,
+			int         n_msgs,
+			int         wait);
+
+	int
+	closeUDPUring(void);
+
+
+	bool                active;          //!< io_uring engine active or not
+
+
+private:
+	int
+	armUDPUring(void);
+
+	void
+	cancelUDPUring(void);
+
+	void
+	recycleUDPUringBuffer(int bid);
+
+	int                 ringFd;          //!< io_uring file descriptor
+	int                 sFd;             //!< socket file descriptor
+
+	// submission queue
+	void               *sqRing;          //!< mmap'ed submission ring
+	size_t              sqRingSize;
+	unsigned           *sqHead;
+	unsigned           *sqTail;
+	unsigned           *sqMask;
+	unsigned           *sqArray;
+	struct io_uring_sqe *sqes;           //!< mmap'ed submission entries
+	size_t              sqesSize;
+
+	// completion queue
+	void               *cqRing;          //!< mmap'ed completion ring
+	size_t              cqRingSize;
+	unsigned           *cqHead;
+	unsigned           *cqTail;
+	unsigned           *cqMask;
+	struct io_uring_cqe *cqes;
+
+	// provided buffer ring
+	struct io_uring_buf_ring *bufRing;   //!< ring shared with the kernel
+	size_t              bufRingSize;
+	char               *bufBase;         //!< the receive buffers themselves
+	int                 nBuffers;        //!< number of buffers (power of 2)
+	int                 bufLen;          //!< length of each buffer
+	unsigned short      bufTail;         //!< local copy of the buffer ring tail
+
+	struct msghdr       recvHdr;         //!< template for multishot recvmsg
+	bool                armed;           //!< multishot receive is pending
+
+};
+
+}
+
+#endif /* UDP_URING_H_ */
@@ -0,0 +1,838 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    comm_async.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  A C++20 coroutine interface on top of the epoll CommReactor. A single
+  threaded CommExecutor runs many coroutines that each look like sequential
+  blocking code, e.g.,
+
+    CommTask<void> serve(AsyncUDP &sock) {
+      char buf[1500];
+      for (;;) {
+        int n = co_await sock.receive(buf, sizeof(buf), 100);
+        if (n == 0) continue;   // time out
+        if (n < 0) break;       // error
+        ...
+      }
+    }
+
+  but are suspended while their endpoint has no data, such that hundreds of
+  sockets or serial ports are served from one thread without a thread per
+  endpoint and without polling.
+
+  Endpoints are registered once, edge-triggered. An awaitable first tries its
+  read without suspending; only if no data is available, the coroutine is
+  parked on the fd (one waiter per fd) and optionally on a timer. Timers are a
+  min-heap with lazy cancellation. Endpoints must outlive the coroutines that
+  wait on them, and coroutines that are still suspended when the executor is
+  destroyed are not resumed.
+
+  ============================================================================*/
+
+
+#include <iostream>
+#include <cstdlib>
+#include "time.h"
+#include "errno.h"
+
+#include "comm_async.h"
+
+// local variables
+
+// global variables
+
+// local functions
+
+namespace comm_reactor {
+
+//! a coroutine that starts immediately and frees itself when done
+struct CommDetached {
+  struct promise_type {
+    CommDetached        get_return_object() { return CommDetached(); }
+    std::suspend_never  initial_suspend() noexcept { return {}; }
+    std::suspend_never  final_suspend() noexcept { return {}; }
+    void                return_void() {}
+    void                unhandled_exception() { std::terminate(); }
+  };
+};
+
+static CommDetached
+driveTask(CommExecutor *ex, CommTask<void> task)
+{
+  co_await task;
+  --ex->n_tasks_;
+}
+
+static uint64_t
+monotonicTimeNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+ \note  CommExecutor
+ \date  Oct 2026
+
+ \remarks
+
+ Creates the executor and its reactor
+
+
+ *******************************************************************************
+ Function Parameters: [in]=input,[out]=output
+
+ none
+
+ ******************************************************************************/
+CommExecutor::
+CommExecutor()
+{
+  n_tasks_       = 0;
+  next_timer_id_ = 1;
+  running_       = false;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+ \note  ~CommExecutor
+ \date  Oct 2026
+
+ \remarks
+
+ Destroys the executor. Suspended coroutines are not resumed.
+
+
+ *******************************************************************************
+ Function Parameters: [in]=input,[out]=output
+
+ none
+
+ ******************************************************************************/
+CommExecutor::
+~CommExecutor()
+{
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  spawn
+\date  Oct 2026
+
+\remarks
+
+starts a task, which runs until its first suspension, and is afterwards
+resumed by the executor. The task frame is freed when the task returns.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     task : the coroutine to run
+
+******************************************************************************/
+void CommExecutor::
+spawn(CommTask<void> task)
+{
+  ++n_tasks_;
+  driveTask(this, std::move(task));
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  deadlineIn
+\date  Oct 2026
+
+\remarks
+
+converts a relative time out into an absolute deadline on CLOCK_MONOTONIC,
+e.g., for AsyncSerial::readExact()
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     timeout_ms : time out in ms from now
+
+returns the deadline in ns
+
+******************************************************************************/
+uint64_t CommExecutor::
+deadlineIn(int timeout_ms)
+{
+  return monotonicTimeNs() + (uint64_t) timeout_ms * 1000000ULL;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  addEndpoint
+\date  Oct 2026
+
+\remarks
+
+registers a file descriptor edge-triggered with the reactor, such that
+awaitables can park on it with waitFd()
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     fd : file descriptor, in non-blocking mode
+
+returns true if all OK, otherwise false
+
+******************************************************************************/
+int CommExecutor::
+addEndpoint(int fd)
+{
+  if (fd < 0)
+    return false;
+
+  if ((size_t) fd >= endpoints_.size()) {
+    endpoints_.resize(fd + 1, false);
+    waiters_.resize(fd + 1, NULL);
+  }
+
+  if (endpoints_[fd]) {
+    printf("Error: fd %d is already an endpoint of the executor\n",fd);
+    return false;
+  }
+
+  if (!reactor_.addFd(fd, EPOLLIN, [this](int fd, unsigned int /* events */) { onFdReady(fd); }, true))
+    return false;
+
+  endpoints_[fd] = true;
+  waiters_[fd]   = NULL;
+
+  return true;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  removeEndpoint
+\date  Oct 2026
+
+\remarks
+
+unregisters a file descriptor. A coroutine still waiting on it stays
+suspended until its time out, if any.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     fd : file descriptor
+
+returns true if all OK, otherwise false
+
+******************************************************************************/
+int CommExecutor::
+removeEndpoint(int fd)
+{
+  if (fd < 0 || (size_t) fd >= endpoints_.size() || !endpoints_[fd])
+    return false;
+
+  endpoints_[fd] = false;
+  waiters_[fd]   = NULL;
+
+  return reactor_.removeFd(fd);
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  waitFd
+\date  Oct 2026
+
+\remarks
+
+parks a waiter on its file descriptor until the fd becomes readable
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     w : the waiter, with fd_ and handle_ set
+
+returns true if all OK, otherwise false
+
+******************************************************************************/
+int CommExecutor::
+waitFd(CommWaiter *w)
+{
+  int fd = w->fd_;
+
+  if (fd < 0 || (size_t) fd >= endpoints_.size() || !endpoints_[fd]) {
+    printf("Error: fd %d is not an endpoint of the executor\n",fd);
+    return false;
+  }
+
+  if (waiters_[fd] != NULL) {
+    printf("Error: another coroutine already waits on fd %d\n",fd);
+    return false;
+  }
+
+  waiters_[fd] = w;
+
+  return true;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  armTimer
+\date  Oct 2026
+
+\remarks
+
+resumes a waiter with onTimeout() at the given deadline, unless it
+completed before
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     w           : the waiter, with handle_ set
+\param[in]     deadline_ns : absolute deadline on CLOCK_MONOTONIC
+
+******************************************************************************/
+void CommExecutor::
+armTimer(CommWaiter *w, uint64_t deadline_ns)
+{
+  Timer t;
+
+  t.deadline   = deadline_ns;
+  t.id         = next_timer_id_++;
+  w->timer_id_ = t.id;
+  armed_[t.id] = w;
+  timers_.push(t);
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  cancelWait
+\date  Oct 2026
+
+\remarks
+
+removes a waiter from its fd and its timer. The timer stays in the heap
+and is discarded when it expires.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     w : the waiter
+
+******************************************************************************/
+void CommExecutor::
+cancelWait(CommWaiter *w)
+{
+  if (w->timer_id_ != 0) {
+    armed_.erase(w->timer_id_);
+    w->timer_id_ = 0;
+  }
+
+  if (w->fd_ >= 0 && (size_t) w->fd_ < waiters_.size() && waiters_[w->fd_] == w)
+    waiters_[w->fd_] = NULL;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  onFdReady
+\date  Oct 2026
+
+\remarks
+
+reactor callback: lets the waiter of the fd try its operation, and resumes
+it if done
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     fd : the ready file descriptor
+
+******************************************************************************/
+void CommExecutor::
+onFdReady(int fd)
+{
+  CommWaiter *w;
+
+  if ((size_t) fd >= waiters_.size() || (w = waiters_[fd]) == NULL)
+    return;  // data stays queued for the next await
+
+  if (!w->tryComplete())
+    return;
+
+  cancelWait(w);
+  w->handle_.resume();
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  fireTimers
+\date  Oct 2026
+
+\remarks
+
+resumes all waiters whose deadline has passed
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+returns the number of resumed coroutines
+
+******************************************************************************/
+int CommExecutor::
+fireTimers()
+{
+  uint64_t    now = monotonicTimeNs();
+  int         n_fired = 0;
+  CommWaiter *w;
+
+  while (!timers_.empty() && timers_.top().deadline <= now) {
+    std::unordered_map<uint64_t, CommWaiter *>::iterator it = armed_.find(timers_.top().id);
+    timers_.pop();
+
+    // cancelled timer
+    if (it == armed_.end())
+      continue;
+
+    w = it->second;
+    cancelWait(w);
+    w->onTimeout();
+    w->handle_.resume();
+    ++n_fired;
+  }
+
+  return n_fired;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  stepExecutor
+\date  Oct 2026
+
+\remarks
+
+waits for ready endpoints or the next timer, and resumes the coroutines
+that can continue. This allows to embed the executor in an existing loop.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     max_wait_ms : max. wait time in ms, 0 to only poll, -1 to
+                             wait until an endpoint or timer is ready
+
+returns the number of resumed coroutines, or -1 on error
+
+******************************************************************************/
+int CommExecutor::
+stepExecutor(int max_wait_ms)
+{
+  int      wait_ms = max_wait_ms;
+  int      n_ready;
+  uint64_t now;
+  uint64_t next_ms;
+
+  // drop cancelled timers at the top, such that they do not shorten the wait
+  while (!timers_.empty() && armed_.find(timers_.top().id) == armed_.end())
+    timers_.pop();
+
+  if (!timers_.empty()) {
+    now = monotonicTimeNs();
+    if (timers_.top().deadline <= now)
+      next_ms = 0;
+    else  // round up, epoll_wait has ms resolution
+      next_ms = (timers_.top().deadline - now + 999999ULL) / 1000000ULL;
+    if (wait_ms < 0 || next_ms < (uint64_t) wait_ms)
+      wait_ms = (int) next_ms;
+  }
+
+  if ((n_ready = reactor_.dispatchEvents(wait_ms)) == -1)
+    return -1;
+
+  return n_ready + fireTimers();
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  runExecutor
+\date  Oct 2026
+
+\remarks
+
+runs until all spawned tasks have returned, or stopExecutor() is called
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+returns true if stopped regularly, false on error
+
+******************************************************************************/
+int CommExecutor::
+runExecutor()
+{
+  running_ = true;
+
+  while (running_ && n_tasks_ > 0) {
+    if (stepExecutor(-1) == -1) {
+      running_ = false;
+      return false;
+    }
+  }
+
+  running_ = false;
+
+  return true;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  stopExecutor
+\date  Oct 2026
+
+\remarks
+
+terminates runExecutor(); can be called from a coroutine or another thread
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+******************************************************************************/
+void CommExecutor::
+stopExecutor()
+{
+  running_ = false;
+  reactor_.stopReactor();
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+ \note  AsyncUDP
+ \date  Oct 2026
+
+ \remarks
+
+ Switches the socket to non-blocking mode and registers it with the executor
+
+
+ *******************************************************************************
+ Function Parameters: [in]=input,[out]=output
+
+ \param[in]     ex  : the executor
+ \param[in]     udp : an active server or connected UDP socket
+
+ ******************************************************************************/
+AsyncUDP::
+AsyncUDP(CommExecutor &ex, udp_communication::UDP_communication *udp) : ex_(ex), udp_(udp)
+{
+  udp_->setUDPNonBlocking(true);
+  if (!ex_.addEndpoint(udp_->getUDPSocketFd()))
+    printf("Error: could not add UDP socket to the executor\n");
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+ \note  ~AsyncUDP
+ \date  Oct 2026
+
+ \remarks
+
+ Unregisters the socket. The socket is not closed.
+
+
+ *******************************************************************************
+ Function Parameters: [in]=input,[out]=output
+
+ none
+
+ ******************************************************************************/
+AsyncUDP::
+~AsyncUDP()
+{
+  ex_.removeEndpoint(udp_->getUDPSocketFd());
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  receive
+\date  Oct 2026
+
+\remarks
+
+awaitable receive of the next datagram:
+
+  int n = co_await sock.receive(buf, sizeof(buf), timeout_ms);
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[out]    buf        : data buffer
+\param[in]     bufLen     : length of data buffer
+\param[in]     timeout_ms : time out in ms, 0 to only poll, -1 to wait forever
+
+the awaited result is the number of bytes received, 0 on time out, or -1
+on a socket error or if another coroutine already waits on the socket
+
+******************************************************************************/
+AsyncUDP::ReceiveAwaitable AsyncUDP::
+receive(char *buf, int bufLen, int timeout_ms)
+{
+  return ReceiveAwaitable(ex_, udp_, buf, bufLen, NULL, timeout_ms);
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  receiveFrom
+\date  Oct 2026
+
+\remarks
+
+like receive(), and returns the sender as in readUDPSocketFrom()
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[out]    buf        : data buffer
+\param[in]     bufLen     : length of data buffer
+\param[out]    peer       : address and port of the sender
+\param[in]     timeout_ms : time out in ms, 0 to only poll, -1 to wait forever
+
+the awaited result is the number of bytes received, 0 on time out, or -1
+on a socket error or if another coroutine already waits on the socket
+
+******************************************************************************/
+AsyncUDP::ReceiveAwaitable AsyncUDP::
+receiveFrom(char *buf, int bufLen, udp_communication::UDPEndpoint *peer, int timeout_ms)
+{
+  return ReceiveAwaitable(ex_, udp_, buf, bufLen, peer, timeout_ms);
+}
+
+AsyncUDP::ReceiveAwaitable::
+ReceiveAwaitable(CommExecutor &ex, udp_communication::UDP_communication *udp,
+		 char *buf, int bufLen, udp_communication::UDPEndpoint *peer,
+		 int timeout_ms)
+  : CommWaiter(ex, udp->getUDPSocketFd()), udp_(udp), buf_(buf), buf_len_(bufLen),
+    peer_(peer), timeout_ms_(timeout_ms), result_(0)
+{
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  await_ready
+\date  Oct 2026
+
+\remarks
+
+tries the read first, such that a coroutine only suspends on an empty
+socket. This also drains datagrams that arrived while no one was waiting,
+as the edge-triggered reactor does not report them again.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+returns true if the coroutine does not need to suspend
+
+******************************************************************************/
+bool AsyncUDP::ReceiveAwaitable::
+await_ready()
+{
+  return tryComplete() || timeout_ms_ == 0;
+}
+
+bool AsyncUDP::ReceiveAwaitable::
+await_suspend(std::coroutine_handle<> h)
+{
+  handle_ = h;
+
+  // another coroutine waits on the socket: not a time out
+  if (!ex_.waitFd(this)) {
+    result_ = -1;
+    return false;
+  }
+
+  if (timeout_ms_ > 0)
+    ex_.armTimer(this, CommExecutor::deadlineIn(timeout_ms_));
+
+  return true;
+}
+
+bool AsyncUDP::ReceiveAwaitable::
+tryComplete()
+{
+  result_ = udp_->readUDPSocketFrom(buf_, buf_len_, peer_);
+
+  // a socket error completes the receive with -1, as the edge-triggered
+  // reactor would not report the socket again
+  if (result_ < 0)
+    result_ = -1;
+
+  return result_ != 0;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+ \note  AsyncSerial
+ \date  Oct 2026
+
+ \remarks
+
+ Registers the serial port with the executor
+
+
+ *******************************************************************************
+ Function Parameters: [in]=input,[out]=output
+
+ \param[in]     ex     : the executor
+ \param[in]     serial : an active serial port
+
+ ******************************************************************************/
+AsyncSerial::
+AsyncSerial(CommExecutor &ex, serial_communication::SerialCommunication *serial)
+  : ex_(ex), serial_(serial)
+{
+  if (!ex_.addEndpoint(serial_->getSerialFd()))
+    printf("Error: could not add serial port to the executor\n");
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+ \note  ~AsyncSerial
+ \date  Oct 2026
+
+ \remarks
+
+ Unregisters the serial port. The port is not closed.
+
+
+ *******************************************************************************
+ Function Parameters: [in]=input,[out]=output
+
+ none
+
+ ******************************************************************************/
+AsyncSerial::
+~AsyncSerial()
+{
+  ex_.removeEndpoint(serial_->getSerialFd());
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  readExact
+\date  Oct 2026
+
+\remarks
+
+awaitable read of exactly n_bytes, e.g., a complete frame of a sensor:
+
+  int n = co_await port.readExact(buf, 32, CommExecutor::deadlineIn(5));
+
+Only as many bytes as checkSerial() reports are read at a time, such that
+the read never blocks, independent of the mode of the port.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[out]    buf         : data buffer
+\param[in]     n_bytes     : number of bytes to read
+\param[in]     deadline_ns : absolute deadline on CLOCK_MONOTONIC, 0 for none
+
+the awaited result is the number of bytes read, which is less than n_bytes
+if the deadline passed, or -1 on a read error or if another coroutine
+already waits on the port
+
+******************************************************************************/
+AsyncSerial::ReadAwaitable AsyncSerial::
+readExact(char *buf, int n_bytes, uint64_t deadline_ns)
+{
+  return ReadAwaitable(ex_, serial_, buf, n_bytes, deadline_ns);
+}
+
+AsyncSerial::ReadAwaitable::
+ReadAwaitable(CommExecutor &ex, serial_communication::SerialCommunication *serial,
+	      char *buf, int n_bytes, uint64_t deadline_ns)
+  : CommWaiter(ex, serial->getSerialFd()), serial_(serial), buf_(buf), n_bytes_(n_bytes),
+    n_read_(0), deadline_ns_(deadline_ns)
+{
+}
+
+bool AsyncSerial::ReadAwaitable::
+await_ready()
+{
+  return tryComplete();
+}
+
+bool AsyncSerial::ReadAwaitable::
+await_suspend(std::coroutine_handle<> h)
+{
+  handle_ = h;
+
+  if (deadline_ns_ != 0 && deadline_ns_ <= monotonicTimeNs())
+    return false;
+
+  // another coroutine waits on the port: not a passed deadline
+  if (!ex_.waitFd(this)) {
+    n_read_ = -1;
+    return false;
+  }
+
+  if (deadline_ns_ != 0)
+    ex_.armTimer(this, deadline_ns_);
+
+  return true;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  tryComplete
+\date  Oct 2026
+
+\remarks
+
+reads what is available, up to the missing number of bytes; a read error
+completes the read with -1
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+returns true if all n_bytes were read, or on error
+
+******************************************************************************/
+bool AsyncSerial::ReadAwaitable::
+tryComplete()
+{
+  int n_avail;
+  int n;
+
+  while (n_read_ < n_bytes_) {
+    if ((n_avail = serial_->checkSerial()) <= 0)
+      break;
+    if (n_avail > n_bytes_ - n_read_)
+      n_avail = n_bytes_ - n_read_;
+    if ((n = serial_->readSerial(n_avail, buf_ + n_read_)) < 0) {
+      n_read_ = -1;
+      return true;
+    }
+    if (n == 0)
+      break;
+    n_read_ += n;
+  }
+
+  return n_read_ >= n_bytes_;
+}
+
+}
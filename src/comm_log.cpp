@@ -0,0 +1,506 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    comm_log.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  A lock-free event log for the error and state messages of the communication
+  hot paths. Instead of a printf, which may block on terminal I/O inside a
+  real-time loop, logCommEvent() writes a binary record (code, errno, time
+  stamp, two arguments) into a ring of the calling thread and increments a
+  counter of the event code -- no lock, no system call, no allocation after
+  the first event of a thread.
+
+  Each thread owns a single-producer/single-consumer ring. A background drain
+  thread formats the records of all rings into the messages that were
+  printed before, and writes them to stdout or another stream. The drain
+  thread is started with the first event, unless it was started explicitly
+  or switched off with setCommLogOutput(). If a ring is full, events are not
+  printed, but still counted.
+
+  The counters of all event codes can be read at any time, e.g., to monitor
+  a link or to raise an alarm after too many errors.
+
+  ============================================================================*/
+
+
+#include <iostream>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "string.h"
+#include "time.h"
+#include "unistd.h"
+
+#include "comm_log.h"
+
+namespace comm_log {
+
+// local variables
+
+//! the ring of one thread
+struct CommLogRing {
+  CommEvent              events[COMM_LOG_RING_SIZE];
+  std::atomic<uint32_t>  head;     //!< next write, owned by the logging thread
+  std::atomic<uint32_t>  tail;     //!< next read, owned by the drain
+  std::atomic<int>       in_use;   //!< claimed by a living thread
+  uint16_t               index;    //!< slot in rings[]
+};
+
+//! releases the ring when its thread terminates, such that it can be reused
+struct CommLogThread {
+  CommLogRing *ring_;
+  CommLogThread() : ring_(NULL) {}
+  ~CommLogThread() { if (ring_ != NULL) ring_->in_use.store(0, std::memory_order_release); }
+};
+
+//! how an event is printed; the format receives arg0 and arg1
+struct CommEventFormat {
+  const char *name;
+  const char *format;
+};
+
+static const CommEventFormat event_formats[COMM_EV_N_CODES] = {
+  {"UDP_NOT_ACTIVE",          "Socket not initialized"},
+  {"UDP_NOT_SERVER",          "This is not a server socket"},
+  {"UDP_READ_ERROR",          "Error when reading from socket %lld"},
+  {"UDP_WRITE_ERROR",         "Error: could not write to socket %lld"},
+  {"UDP_POLL_ERROR",          "Error: poll failed"},
+  {"UDP_GSO_FAILED",          "Error: segmentation offload failed on socket %lld -- disabled"},
+  {"UDP_BUFFER_ERROR",        "Error: couldn't set socket buffer size of socket %lld"},
+  {"UDP_BUFFER_LOW",          "Warning: socket buffer is %lld instead of %lld bytes -- raise net.core.rmem_max/wmem_max"},
+  {"CHANNEL_NOT_ACTIVE",      "Channel not initialized"},
+  {"CHANNEL_INVALID_LENGTH",  "Error: invalid message length %lld (max. %lld)"},
+  {"CHANNEL_INVALID_STREAM",  "Error: invalid stream id or path %lld"},
+  {"FEC_SINGULAR",            "Error: singular FEC matrix"},
+  {"SERIAL_NOT_ACTIVE",       "Serial port not active"},
+  {"SERIAL_READ_ERROR",       "Error when reading %2$lld bytes from serial port %1$lld"},
+  {"SERIAL_WRITE_ERROR",      "Error when writing %2$lld bytes to serial port %1$lld"},
+  {"ECAT_NOT_ACTIVE",         "Ethercat is not active"},
+  {"ECAT_WKC_LOW",            "WARNING : work counter %lld < %lld expected"},
+  {"ECAT_SLAVE_SAFEOP_ERROR", "ERROR : slave %lld is in SAFE_OP + ERROR, attempting ack."},
+  {"ECAT_SLAVE_SAFEOP",       "WARNING : slave %lld is in SAFE_OP, change to OPERATIONAL."},
+  {"ECAT_SLAVE_RECONFIGURED", "MESSAGE : slave %lld reconfigured"},
+  {"ECAT_SLAVE_LOST",         "ERROR : slave %lld lost"},
+  {"ECAT_SLAVE_RECOVERED",    "MESSAGE : slave %lld recovered"},
+  {"ECAT_SLAVE_FOUND",        "MESSAGE : slave %lld found"},
+  {"ECAT_OPERATIONAL",        "OK : all slaves resumed OPERATIONAL."},
+};
+
+static CommLogRing                *rings[COMM_LOG_MAX_THREADS];
+static std::atomic<int>            n_rings(0);
+static std::atomic<unsigned long>  event_counts[COMM_EV_N_CODES];
+static std::atomic<unsigned long>  events_lost(0);
+static thread_local CommLogThread  this_thread;
+
+static std::mutex                  drain_mutex;    //!< serializes the consumers
+static std::mutex                  thread_mutex;   //!< serializes start and stop of drain_thread
+static FILE                       *output = stdout;
+static std::atomic<bool>           auto_drain(true);
+static std::atomic<bool>           draining(false);
+static std::thread                 drain_thread;
+static int                         drain_period_ms = COMM_LOG_PERIOD_MS;
+
+// local functions
+
+static void
+drainLoop(void);
+
+static uint64_t
+monotonicTimeNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+//! stops the drain thread at program exit, and prints what is left
+static struct CommLogShutdown {
+  ~CommLogShutdown() { stopCommLogDrain(); }
+} log_shutdown;
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  claimRing
+\date  Oct 2026
+
+\remarks
+
+gives the calling thread a ring: an empty ring of a terminated thread is
+reused, otherwise a new one is allocated
+
+returns the ring, or NULL if COMM_LOG_MAX_THREADS rings are in use
+
+******************************************************************************/
+static CommLogRing *
+claimRing(void)
+{
+  CommLogRing *r;
+  int          n;
+  int          expected;
+
+  // reuse a ring that was released and drained
+  n = n_rings.load(std::memory_order_acquire);
+  for (int i=0; i<n && i<COMM_LOG_MAX_THREADS; ++i) {
+    expected = 0;
+    r = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+    if (r == NULL || r->head.load() != r->tail.load())
+      continue;
+    if (r->in_use.compare_exchange_strong(expected, 1, std::memory_order_acq_rel))
+      return r;
+  }
+
+  if ((n = n_rings.fetch_add(1, std::memory_order_acq_rel)) >= COMM_LOG_MAX_THREADS) {
+    n_rings.fetch_sub(1, std::memory_order_acq_rel);
+    return NULL;
+  }
+
+  r = new CommLogRing;
+  r->head.store(0);
+  r->tail.store(0);
+  r->in_use.store(1);
+  r->index = n;
+
+  // the drain skips the slot until the ring is published
+  __atomic_store_n(&rings[n], r, __ATOMIC_RELEASE);
+
+  return r;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  initCommLogThread
+\date  Oct 2026
+
+\remarks
+
+prepares the ring of the calling thread, such that even its first event does
+not allocate memory. Real-time threads should call this during their setup.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+returns true if all OK, otherwise false
+
+******************************************************************************/
+int
+initCommLogThread(void)
+{
+  if (this_thread.ring_ == NULL && (this_thread.ring_ = claimRing()) == NULL)
+    return false;
+
+  if (auto_drain.load(std::memory_order_relaxed) &&
+      !draining.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(thread_mutex);
+    if (auto_drain.load() && !draining.load()) {
+      draining.store(true, std::memory_order_release);
+      drain_thread = std::thread(drainLoop);
+    }
+  }
+
+  return true;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  logCommEvent
+\date  Oct 2026
+
+\remarks
+
+records an event in the ring of the calling thread; lock-free and without a
+system call, to be used instead of printf on hot paths
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     code : a CommEventCode
+\param[in]     err  : errno, or 0
+\param[in]     arg0 : first argument of the event
+\param[in]     arg1 : second argument of the event
+
+******************************************************************************/
+void
+logCommEvent(int code, int err, int64_t arg0, int64_t arg1)
+{
+  CommLogRing *r;
+  CommEvent   *ev;
+  uint32_t     head;
+
+  if (code < 0 || code >= COMM_EV_N_CODES)
+    return;
+
+  event_counts[code].fetch_add(1, std::memory_order_relaxed);
+
+  if ((r = this_thread.ring_) == NULL) {
+    initCommLogThread();
+    if ((r = this_thread.ring_) == NULL) {
+      events_lost.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+
+  head = r->head.load(std::memory_order_relaxed);
+  if (head - r->tail.load(std::memory_order_acquire) >= COMM_LOG_RING_SIZE) {
+    events_lost.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  ev = &r->events[head & (COMM_LOG_RING_SIZE - 1)];
+  ev->t_ns    = monotonicTimeNs();
+  ev->code    = code;
+  ev->thread  = r->index;
+  ev->err     = err;
+  ev->args[0] = arg0;
+  ev->args[1] = arg1;
+
+  r->head.store(head + 1, std::memory_order_release);
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  drainCommLog
+\date  Oct 2026
+
+\remarks
+
+formats and prints the events of all rings; called by the drain thread, or
+by the application if the drain thread is switched off
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+returns the number of events that were taken from the rings
+
+******************************************************************************/
+int
+drainCommLog(void)
+{
+  std::lock_guard<std::mutex> lock(drain_mutex);
+  CommLogRing *r;
+  CommEvent   *ev;
+  uint32_t     tail, head;
+  int          n_drained = 0;
+  int          n = n_rings.load(std::memory_order_acquire);
+
+  for (int i=0; i<n && i<COMM_LOG_MAX_THREADS; ++i) {
+    if ((r = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE)) == NULL)
+      continue;
+
+    tail = r->tail.load(std::memory_order_relaxed);
+    head = r->head.load(std::memory_order_acquire);
+
+    for (; tail != head; ++tail, ++n_drained) {
+      ev = &r->events[tail & (COMM_LOG_RING_SIZE - 1)];
+      if (output == NULL)
+	continue;
+      fprintf(output, event_formats[ev->code].format,
+	      (long long) ev->args[0], (long long) ev->args[1]);
+      if (ev->err != 0)
+	fprintf(output, " (errno=%d: %s)", ev->err, strerror(ev->err));
+      fprintf(output, "\n");
+    }
+
+    r->tail.store(tail, std::memory_order_release);
+  }
+
+  if (n_drained > 0 && output != NULL)
+    fflush(output);
+
+  return n_drained;
+}
+
+static void
+drainLoop(void)
+{
+  while (draining.load(std::memory_order_acquire)) {
+    drainCommLog();
+    usleep(drain_period_ms * 1000);
+  }
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  startCommLogDrain
+\date  Oct 2026
+
+\remarks
+
+starts the drain thread, which prints the logged events periodically
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     period_ms : drain period in ms
+
+returns true if all OK, otherwise false
+
+******************************************************************************/
+int
+startCommLogDrain(int period_ms)
+{
+  std::lock_guard<std::mutex> lock(thread_mutex);
+
+  if (period_ms <= 0)
+    return false;
+
+  drain_period_ms = period_ms;
+  auto_drain.store(true);
+
+  if (!draining.load()) {
+    draining.store(true, std::memory_order_release);
+    drain_thread = std::thread(drainLoop);
+  }
+
+  return true;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  stopCommLogDrain
+\date  Oct 2026
+
+\remarks
+
+stops the drain thread, and prints the events that are left. The drain
+thread is not started automatically anymore until startCommLogDrain().
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+******************************************************************************/
+void
+stopCommLogDrain(void)
+{
+  std::lock_guard<std::mutex> lock(thread_mutex);
+
+  // no event may start a new thread while the old one is joined
+  auto_drain.store(false);
+  draining.store(false, std::memory_order_release);
+  if (drain_thread.joinable())
+    drain_thread.join();
+
+  drainCommLog();
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  setCommLogOutput
+\date  Oct 2026
+
+\remarks
+
+selects where the drain prints the events, and whether the drain thread is
+started automatically with the first event
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     out        : output stream, or NULL to only count events
+\param[in]     auto_start : start the drain thread with the first event; if
+                            false, the application calls drainCommLog()
+
+******************************************************************************/
+void
+setCommLogOutput(FILE *out, bool auto_start)
+{
+  std::lock_guard<std::mutex> lock(drain_mutex);
+
+  output = out;
+  auto_drain.store(auto_start);
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  getCommEventCount
+\date  Oct 2026
+
+\remarks
+
+returns how often an event was logged, including events that were lost;
+can be called from any thread
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     code : a CommEventCode
+
+******************************************************************************/
+unsigned long
+getCommEventCount(int code)
+{
+  if (code < 0 || code >= COMM_EV_N_CODES)
+    return 0;
+
+  return event_counts[code].load(std::memory_order_relaxed);
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  getCommEventsLost
+\date  Oct 2026
+
+\remarks
+
+returns the number of events that were counted, but not printed since a
+ring was full
+
+******************************************************************************/
+unsigned long
+getCommEventsLost(void)
+{
+  return events_lost.load(std::memory_order_relaxed);
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  resetCommEventCounts
+\date  Oct 2026
+
+\remarks
+
+sets all event counters to zero
+
+******************************************************************************/
+void
+resetCommEventCounts(void)
+{
+  for (int i=0; i<COMM_EV_N_CODES; ++i)
+    event_counts[i].store(0, std::memory_order_relaxed);
+  events_lost.store(0, std::memory_order_relaxed);
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  getCommEventName
+\date  Oct 2026
+
+\remarks
+
+returns the name of an event code, e.g., "UDP_READ_ERROR"
+
+******************************************************************************/
+const char *
+getCommEventName(int code)
+{
+  if (code < 0 || code >= COMM_EV_N_CODES)
+    return "UNKNOWN";
+
+  return event_formats[code].name;
+}
+
+}
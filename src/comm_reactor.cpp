@@ -0,0 +1,372 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    comm_reactor.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  An epoll based reactor that waits on many UDP sockets, serial ports, or
+  other file descriptors at once, and dispatches a callback only for those
+  that have data ready. This replaces polling every endpoint with
+  checkUDPSocket() or checkSerial() in a sleep loop.
+
+  In edge-triggered mode, a callback is only invoked when new data arrives,
+  and it needs to read until the endpoint is empty (i.e., until a read returns
+  EAGAIN); UDP sockets registered this way are switched to non-blocking mode.
+
+  ============================================================================*/
+
+
+#include <iostream>
+#include <cstdlib>
+#include "unistd.h"
+#include "errno.h"
+#include "sys/eventfd.h"
+
+#include "comm_reactor.h"
+
+// local variables
+
+// global variables
+
+// local functions
+
+namespace comm_reactor {
+
+/*!*****************************************************************************
+ *******************************************************************************
+ \note  CommReactor
+ \date  Oct 2026
+
+ \remarks
+
+ Creates the epoll instance and the wakeup event used by stopReactor()
+
+
+ *******************************************************************************
+ Function Parameters: [in]=input,[out]=output
+
+ none
+
+ ******************************************************************************/
+CommReactor::
+CommReactor()
+{
+  struct epoll_event ev;
+
+  active_    = false;
+  running_   = false;
+  wakeup_fd_ = -1;
+
+  if ((epoll_fd_ = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+    printf("Error: could not create epoll instance (errno=%d)\n",errno);
+    return;
+  }
+
+  if ((wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+    printf("Error: could not create wakeup event (errno=%d)\n",errno);
+    close(epoll_fd_);
+    return;
+  }
+
+  // the wakeup event is marked by a NULL handler
+  ev.events   = EPOLLIN;
+  ev.data.ptr = NULL;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &ev);
+
+  active_ = true;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+ \note  ~CommReactor
+ \date  Oct 2026
+
+ \remarks
+
+ Closes the epoll instance. The registered endpoints are not closed.
+
+
+ *******************************************************************************
+ Function Parameters: [in]=input,[out]=output
+
+ none
+
+ ******************************************************************************/
+CommReactor::
+~CommReactor()
+{
+  for (size_t i=0; i<handlers_.size(); ++i)
+    delete handlers_[i];
+  for (size_t i=0; i<removed_.size(); ++i)
+    delete removed_[i];
+
+  if (active_) {
+    close(wakeup_fd_);
+    close(epoll_fd_);
+  }
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  addFd
+\date  Oct 2026
+
+\remarks
+
+registers a file descriptor with the reactor
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     fd             : file descriptor
+\param[in]     events         : epoll events of interest, e.g., EPOLLIN
+\param[in]     callback       : called with fd and the ready events
+\param[in]     edge_triggered : true for edge-triggered notification
+
+returns true if all OK, otherwise false
+
+******************************************************************************/
+int CommReactor::
+addFd(int fd, unsigned int events, CommCallback callback, bool edge_triggered)
+{
+  struct epoll_event ev;
+  Handler           *h;
+
+  if (!active_ || fd < 0)
+    return false;
+
+  h = new Handler;
+  h->fd       = fd;
+  h->callback = callback;
+  h->removed  = false;
+
+  ev.events   = events | (edge_triggered ? (uint32_t) EPOLLET : 0);
+  ev.data.ptr = h;
+
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == -1) {
+    printf("Error: could not register fd %d with epoll (errno=%d)\n",fd,errno);
+    delete h;
+    return false;
+  }
+
+  handlers_.push_back(h);
+
+  return true;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  addUDPSocket
+\date  Oct 2026
+
+\remarks
+
+registers a UDP socket for read events
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     udp            : an active UDP socket
+\param[in]     callback       : called when data is ready
+\param[in]     edge_triggered : true for edge-triggered notification; the
+                                socket is then switched to non-blocking mode
+
+returns true if all OK, otherwise false
+
+******************************************************************************/
+int CommReactor::
+addUDPSocket(udp_communication::UDP_communication *udp,
+	     CommCallback callback,
+	     bool edge_triggered)
+{
+  if (edge_triggered)
+    udp->setUDPNonBlocking(true);
+
+  return addFd(udp->getUDPSocketFd(), EPOLLIN, callback, edge_triggered);
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  addSerialPort
+\date  Oct 2026
+
+\remarks
+
+registers a serial port for read events
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     serial         : an active serial port
+\param[in]     callback       : called when data is ready
+\param[in]     edge_triggered : true for edge-triggered notification
+
+returns true if all OK, otherwise false
+
+******************************************************************************/
+int CommReactor::
+addSerialPort(serial_communication::SerialCommunication *serial,
+	      CommCallback callback,
+	      bool edge_triggered)
+{
+  return addFd(serial->getSerialFd(), EPOLLIN, callback, edge_triggered);
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  removeFd
+\date  Oct 2026
+
+\remarks
+
+unregisters a file descriptor. This is safe to call from within a callback.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     fd : file descriptor
+
+returns true if all OK, otherwise false
+
+******************************************************************************/
+int CommReactor::
+removeFd(int fd)
+{
+  for (size_t i=0; i<handlers_.size(); ++i) {
+    if (handlers_[i]->fd == fd) {
+      epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, NULL);
+      handlers_[i]->removed = true;
+      removed_.push_back(handlers_[i]);
+      handlers_.erase(handlers_.begin() + i);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  dispatchEvents
+\date  Oct 2026
+
+\remarks
+
+waits for ready endpoints and invokes their callbacks
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     timeout_ms : max. wait time in ms, 0 to only poll, -1 to
+                            wait forever
+
+returns the number of callbacks invoked, or -1 on error
+
+******************************************************************************/
+int CommReactor::
+dispatchEvents(int timeout_ms)
+{
+  struct epoll_event events[COMM_REACTOR_MAX_EVENTS];
+  int                n_events;
+  int                n_dispatched = 0;
+  uint64_t           count;
+  Handler           *h;
+
+  if (!active_)
+    return -1;
+
+  n_events = epoll_wait(epoll_fd_, events, COMM_REACTOR_MAX_EVENTS, timeout_ms);
+  if (n_events == -1) {
+    if (errno == EINTR)
+      return 0;
+    printf("Error when waiting for epoll events (errno=%d)\n",errno);
+    return -1;
+  }
+
+  for (int i=0; i<n_events; ++i) {
+    h = (Handler *) events[i].data.ptr;
+
+    if (h == NULL) {
+      if (read(wakeup_fd_, &count, sizeof(count)) < 0)
+	count = 0;
+      continue;
+    }
+
+    // a previous callback of this round may have removed this handler
+    if (h->removed)
+      continue;
+
+    h->callback(h->fd, events[i].events);
+    ++n_dispatched;
+  }
+
+  for (size_t i=0; i<removed_.size(); ++i)
+    delete removed_[i];
+  removed_.clear();
+
+  return n_dispatched;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  runReactor
+\date  Oct 2026
+
+\remarks
+
+dispatches events until stopReactor() is called
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+returns true if stopped regularly, false on error
+
+******************************************************************************/
+int CommReactor::
+runReactor()
+{
+  running_ = true;
+
+  while (running_) {
+    if (dispatchEvents(-1) == -1) {
+      running_ = false;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+\note  stopReactor
+\date  Oct 2026
+
+\remarks
+
+terminates runReactor(); can be called from a callback or another thread
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+******************************************************************************/
+void CommReactor::
+stopReactor()
+{
+  uint64_t one = 1;
+
+  running_ = false;
+  if (active_ && write(wakeup_fd_, &one, sizeof(one)) < 0)
+    printf("Error: could not wake up reactor (errno=%d)\n",errno);
+}
+
+}
@@ -18,6 +18,7 @@
 #include <iostream>
 #include <cstdlib>
 #include "ethercat_communication.h"
+#include "comm_log.h"
 
 // local variables 
 
@@ -25,6 +26,8 @@
 
 // local functions
 
+using namespace comm_log;
+
 namespace ethercat_communication {
 
 /*!*****************************************************************************
@@ -86,7 +89,9 @@ EthercatCommunication::
    
 \remarks 
 
-Function to check ethercat operations (copied from SOEM examples).
+Function to check ethercat operations (copied from SOEM examples). State
+changes are reported through the comm_log event ring, since this runs inside
+the real-time loop.
 
 *******************************************************************************
 Function Parameters: [in]=input,[out]=output
@@ -101,10 +106,8 @@ EthercatCommunication::CheckEthercat( void *time_fptr )
 
   if( active_ && ((wkc_ < expectedWKC_) || ec_group[currentgroup_].docheckstate)) {
     
-    if (needlf_) {
-      needlf_ = FALSE;
-      printf("\n");
-    }
+    if (wkc_ < expectedWKC_)
+      logCommEvent(COMM_EV_ECAT_WKC_LOW, 0, wkc_, expectedWKC_);
     
     // one ore more slaves are not responding 
     ec_group[currentgroup_].docheckstate = FALSE;
@@ -116,13 +119,13 @@ EthercatCommunication::CheckEthercat( void *time_fptr )
 	
 	if (ec_slave[slave].state == (EC_STATE_SAFE_OP + EC_STATE_ERROR)) {
 	  
-	  printf("ERROR : slave %d is in SAFE_OP + ERROR, attempting ack.\n", slave);
+	  logCommEvent(COMM_EV_ECAT_SLAVE_SAFEOP_ERROR, 0, slave);
 	  ec_slave[slave].state = (EC_STATE_SAFE_OP + EC_STATE_ACK);
 	  ec_writestate(slave);
 	  
 	} else if (ec_slave[slave].state == EC_STATE_SAFE_OP) {
 	  
-	  printf("WARNING : slave %d is in SAFE_OP, change to OPERATIONAL.\n", slave);
+	  logCommEvent(COMM_EV_ECAT_SLAVE_SAFEOP, 0, slave);
 	  ec_slave[slave].state = EC_STATE_OPERATIONAL;
 	  ec_writestate(slave);
 	  
@@ -130,7 +133,7 @@ EthercatCommunication::CheckEthercat( void *time_fptr )
 	  
 	  if (ec_reconfig_slave(slave, EC_TIMEOUTMON)) {
 	    ec_slave[slave].islost = FALSE;
-	    printf("MESSAGE : slave %d reconfigured\n",slave);
+	    logCommEvent(COMM_EV_ECAT_SLAVE_RECONFIGURED, 0, slave);
 	  }
 	  
 	} else if(!ec_slave[slave].islost) {
@@ -139,7 +142,7 @@ EthercatCommunication::CheckEthercat( void *time_fptr )
 	  ec_statecheck(slave, EC_STATE_OPERATIONAL, EC_TIMEOUTRET);
 	  if (ec_slave[slave].state == EC_STATE_NONE) {
 	    ec_slave[slave].islost = TRUE;
-	    printf("ERROR : slave %d lost\n",slave);
+	    logCommEvent(COMM_EV_ECAT_SLAVE_LOST, 0, slave);
 	  }
 	  
 	}
@@ -152,13 +155,13 @@ EthercatCommunication::CheckEthercat( void *time_fptr )
 	  
 	  if (ec_recover_slave(slave, EC_TIMEOUTMON)) {
 	    ec_slave[slave].islost = FALSE;
-	    printf("MESSAGE : slave %d recovered\n",slave);
+	    logCommEvent(COMM_EV_ECAT_SLAVE_RECOVERED, 0, slave);
 	  }
 	  
 	} else {
 	  
 	  ec_slave[slave].islost = FALSE;
-	  printf("MESSAGE : slave %d found\n",slave);
+	  logCommEvent(COMM_EV_ECAT_SLAVE_FOUND, 0, slave);
 	  
 	}
 	
@@ -167,7 +170,7 @@ EthercatCommunication::CheckEthercat( void *time_fptr )
     }
     
     if(!ec_group[currentgroup_].docheckstate){
-      printf("OK : all slaves resumed OPERATIONAL.\n");
+      logCommEvent(COMM_EV_ECAT_OPERATIONAL, 0);
     } else {
       return FALSE;
     }
@@ -340,7 +343,7 @@ RunEthercat()
     
   } else {
 
-    printf("Ethercat on interface >%s< is not active\n",ifname_);
+    logCommEvent(COMM_EV_ECAT_NOT_ACTIVE, 0);
     return FALSE;
 
   }
@@ -376,7 +379,7 @@ SendEthercat()
     
   } else {
 
-    printf("Ethercat on interface >%s< is not active\n",ifname_);
+    logCommEvent(COMM_EV_ECAT_NOT_ACTIVE, 0);
     return FALSE;
 
   }
@@ -433,7 +436,7 @@ ReceiveEthercat()
     
   } else {
 
-    printf("Ethercat on interface >%s< is not active\n",ifname_);
+    logCommEvent(COMM_EV_ECAT_NOT_ACTIVE, 0);
     return FALSE;
 
   }
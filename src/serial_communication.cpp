@@ -20,8 +20,10 @@
 #include "fcntl.h"
 #include "sys/ioctl.h"
 #include "unistd.h"
+#include "errno.h"
 
 #include "serial_communication.h"
+#include "comm_log.h"
 
 // local variables 
 
@@ -29,6 +31,8 @@
 
 // local functions
 
+using namespace comm_log;
+
 namespace serial_communication {
 
 /*!*****************************************************************************
@@ -169,10 +173,18 @@ returns the number of bytes actually read
 int SerialCommunication::
 readSerial(int n_bytes, char *buffer) 
 {
-  if (!active_)
+  int n;
+
+  if (!active_) {
+    logCommEvent(COMM_EV_SERIAL_NOT_ACTIVE, 0);
     return false;
+  }
   
-  return read(fd_, buffer, (size_t) n_bytes);
+  n = read(fd_, buffer, (size_t) n_bytes);
+  if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+    logCommEvent(COMM_EV_SERIAL_READ_ERROR, errno, fd_, n_bytes);
+
+  return n;
 }
 
 /*!*****************************************************************************
@@ -196,10 +208,18 @@ returns the number of bytes actually written
 int SerialCommunication::
 writeSerial(int n_bytes, char *buffer) 
 {
-  if (!active_)
+  int n;
+
+  if (!active_) {
+    logCommEvent(COMM_EV_SERIAL_NOT_ACTIVE, 0);
     return false;
+  }
+
+  n = write(fd_, buffer, (size_t) n_bytes);
+  if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+    logCommEvent(COMM_EV_SERIAL_WRITE_ERROR, errno, fd_, n_bytes);
 
-  return write(fd_, buffer, (size_t) n_bytes);
+  return n;
 }
 
 /*!*****************************************************************************
@@ -232,4 +252,30 @@ checkSerial()
   return n_bytes;
 }
 
+/*!*****************************************************************************
+ *******************************************************************************
+\note  getSerialFd
+\date  Oct 2026
+   
+\remarks 
+
+        returns the file descriptor of the serial port, e.g., for epoll
+
+ *******************************************************************************
+ Function Parameters: [in]=input,[out]=output
+
+ none
+
+     returns the file descriptor, or -1 if the port is not active
+
+ ******************************************************************************/
+int SerialCommunication::
+getSerialFd() 
+{
+  if (!active_)
+    return -1;
+
+  return fd_;
+}
+
 }
@@ -0,0 +1,578 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    shm_communication.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  A shared memory transport for processes on the same host. It implements
+  the UDPTransport interface of UDP_communication (the plain read, write,
+  check, and setup calls), such that code written against UDPTransport runs
+  on either transport. The batched, vectored, and addressed (To) variants,
+  and everything built on them, e.g., the channels, remain UDP only.
+
+  Server and client of a port map the same POSIX shared memory segment
+  (/comm_shm_<port>), which holds one message ring per direction. The rings
+  are bounded multi-producer/multi-consumer queues (D. Vyukov's algorithm), so
+  several clients can write to one server. On multi-core hosts, a blocking
+  read busy-waits for SHM_SPIN_NS, which gives sub-microsecond latencies when
+  messages arrive at a high rate, and then sleeps on a futex that every write
+  bumps.
+
+  As with UDP, messages are dropped if the receiver does not keep up, and
+  replies of the server go to whichever client reads first.
+
+  ============================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+#include "unistd.h"
+#include "string.h"
+#include "errno.h"
+#include "fcntl.h"
+#include "time.h"
+#include "limits.h"
+#include "arpa/inet.h"
+#include "sys/mman.h"
+#include "sys/syscall.h"
+#include "linux/futex.h"
+
+// my utilities library
+#include "utility.h"
+
+#include "shm_communication.h"
+
+#define SHM_READY 2
+
+namespace udp_communication {
+
+  static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+		std::atomic<uint32_t>::is_always_lock_free,
+		"shared memory rings need lock-free atomics");
+  static_assert((SHM_N_SLOTS & (SHM_N_SLOTS-1)) == 0,
+		"SHM_N_SLOTS must be a power of 2");
+
+  static uint64_t
+  monotonicTimeNs(void)
+  {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+
+  static inline void
+  cpuRelax(void)
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+  }
+
+  // appends a message to the ring; returns FALSE if the ring is full
+  static int
+  enqueueSHM(SHMRing *r, const char *buf, int len)
+  {
+    uint64_t pos = r->head.load(std::memory_order_relaxed);
+    SHMSlot *slot;
+    int64_t  diff;
+
+    while (TRUE) {
+      slot = &r->slots[pos & (SHM_N_SLOTS-1)];
+      diff = (int64_t) (slot->seq.load(std::memory_order_acquire) - pos);
+      if (diff == 0) {
+	if (r->head.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed))
+	  break;
+      } else if (diff < 0) {
+	return FALSE;
+      } else {
+	pos = r->head.load(std::memory_order_relaxed);
+      }
+    }
+
+    memcpy(slot->data, buf, len);
+    slot->len = len;
+    slot->seq.store(pos+1, std::memory_order_release);
+
+    // wake up sleeping readers
+    r->futex.fetch_add(1);
+    if (r->waiters.load() > 0)
+      syscall(SYS_futex, &r->futex, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+
+    return TRUE;
+  }
+
+  // removes the oldest message from the ring; returns its length (truncated
+  // to bufLen), or ERROR if the ring is empty
+  static int
+  dequeueSHM(SHMRing *r, char *buf, int bufLen)
+  {
+    uint64_t pos = r->tail.load(std::memory_order_relaxed);
+    SHMSlot *slot;
+    int64_t  diff;
+    int      len;
+
+    while (TRUE) {
+      slot = &r->slots[pos & (SHM_N_SLOTS-1)];
+      diff = (int64_t) (slot->seq.load(std::memory_order_acquire) - (pos+1));
+      if (diff == 0) {
+	if (r->tail.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed))
+	  break;
+      } else if (diff < 0) {
+	return ERROR;
+      } else {
+	pos = r->tail.load(std::memory_order_relaxed);
+      }
+    }
+
+    len = slot->len < (uint32_t) bufLen ? slot->len : bufLen;
+    memcpy(buf, slot->data, len);
+    slot->seq.store(pos + SHM_N_SLOTS, std::memory_order_release);
+
+    return len;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Constructor
+\date  Oct 2026
+
+\remarks
+
+The transport is inactive until makeUDPServer() or makeUDPClient() was called.
+
+  ******************************************************************************/
+  SHM_communication::
+  SHM_communication()
+  {
+    active    = FALSE;
+    is_server = FALSE;
+    non_block = FALSE;
+    segment   = NULL;
+    rxRing    = NULL;
+    txRing    = NULL;
+    nDropped  = 0;
+    shmName[0] = '\0';
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Destructor
+\date  Oct 2026
+
+\remarks
+
+Unmaps the shared memory segment.
+
+  ******************************************************************************/
+  SHM_communication::
+  ~SHM_communication()
+  {
+    if (active)
+      closeUDPSocket();
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  openSHMSegment
+\date  Oct 2026
+
+\remarks
+
+Creates or opens the shared memory segment of a port. Whoever comes first
+initializes the rings.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     portNum         : the port that names the segment
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int SHM_communication::
+  openSHMSegment(int portNum)
+  {
+    int      fd;
+    uint32_t expected = 0;
+    uint64_t t_timeout;
+
+    this->portNum = portNum;
+    snprintf(shmName, sizeof(shmName), "/comm_shm_%d", portNum);
+
+    if ((fd = shm_open(shmName, O_CREAT | O_RDWR, 0666)) == ERROR) {
+      printf("Error: could not open shared memory %s (errno=%d)\n",shmName,errno);
+      return FALSE;
+    }
+
+    // a new segment is zero filled, i.e., in state 0
+    if (ftruncate(fd, sizeof(SHMSegment)) == ERROR) {
+      printf("Error: could not size shared memory %s (errno=%d)\n",shmName,errno);
+      close(fd);
+      return FALSE;
+    }
+
+    segment = (SHMSegment *) mmap(NULL, sizeof(SHMSegment), PROT_READ | PROT_WRITE,
+				  MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED) {
+      printf("Error: could not map shared memory %s (errno=%d)\n",shmName,errno);
+      segment = NULL;
+      return FALSE;
+    }
+
+    if (segment->state.compare_exchange_strong(expected, 1)) {
+      SHMRing *rings[2] = { &segment->to_server, &segment->to_client };
+
+      for (int r=0; r<2; ++r) {
+	rings[r]->head.store(0);
+	rings[r]->tail.store(0);
+	rings[r]->futex.store(0);
+	rings[r]->waiters.store(0);
+	for (uint64_t i=0; i<SHM_N_SLOTS; ++i)
+	  rings[r]->slots[i].seq.store(i);
+      }
+      segment->n_slots   = SHM_N_SLOTS;
+      segment->slot_size = SHM_SLOT_SIZE;
+      segment->state.store(SHM_READY, std::memory_order_release);
+    } else {
+      t_timeout = monotonicTimeNs() + 1000000000ULL;
+      while (segment->state.load(std::memory_order_acquire) != SHM_READY) {
+	if (monotonicTimeNs() > t_timeout) {
+	  printf("Error: shared memory %s was never initialized\n",shmName);
+	  munmap(segment, sizeof(SHMSegment));
+	  segment = NULL;
+	  return FALSE;
+	}
+	usleep(1000);
+      }
+    }
+
+    if (segment->n_slots != SHM_N_SLOTS || segment->slot_size != SHM_SLOT_SIZE) {
+      printf("Error: shared memory %s has a different layout\n",shmName);
+      munmap(segment, sizeof(SHMSegment));
+      segment = NULL;
+      return FALSE;
+    }
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  makeUDPServer
+\date  Oct 2026
+
+\remarks
+
+Opens the shared memory segment of a port as server: reads the messages of
+the clients, and writes replies to them.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     serverPortNum     : which port to use
+\param[in]     serverName        : ignored, the peers are always on this host
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int SHM_communication::
+  makeUDPServer(int serverPortNum, char * /* serverName */)
+  {
+    if (active) {
+      printf("shared memory is already active\n");
+      return FALSE;
+    }
+
+    if (!openSHMSegment(serverPortNum))
+      return FALSE;
+
+    rxRing    = &segment->to_server;
+    txRing    = &segment->to_client;
+    is_server = TRUE;
+    active    = TRUE;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  makeUDPClient
+\date  Oct 2026
+
+\remarks
+
+Opens the shared memory segment of a port as client: writes to the server,
+and reads its replies.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     socketPortNum     : which port to use
+\param[in]     clientName        : ignored, the peers are always on this host
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int SHM_communication::
+  makeUDPClient(int socketPortNum, char * /* clientName */)
+  {
+    if (active) {
+      printf("shared memory is already active\n");
+      return FALSE;
+    }
+
+    if (!openSHMSegment(socketPortNum))
+      return FALSE;
+
+    rxRing    = &segment->to_client;
+    txRing    = &segment->to_server;
+    is_server = FALSE;
+    active    = TRUE;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  closeUDPSocket
+\date  Oct 2026
+
+\remarks
+
+Unmaps the segment. The server also removes its name, such that the next
+server starts with empty rings.
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int SHM_communication::
+  closeUDPSocket(void)
+  {
+    if (!active) {
+      printf("shared memory not initialized\n");
+      return FALSE;
+    }
+
+    active = FALSE;
+    if (is_server)
+      shm_unlink(shmName);
+
+    if (munmap(segment, sizeof(SHMSegment)) == ERROR)
+      return FALSE;
+    segment = NULL;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  writeUDPSocket
+\date  Oct 2026
+
+\remarks
+
+Appends a message to the ring of the peer. If the ring is full, the message
+is dropped and counted in nDropped.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     buf             : data buffer
+\param[in]     bufLen          : length of data buffer
+
+returns the number of bytes written, or FALSE if the message was dropped
+
+  ******************************************************************************/
+  int SHM_communication::
+  writeUDPSocket(char *buf,
+		 int   bufLen)
+  {
+    if (!active) {
+      printf("shared memory not initialized\n");
+      return FALSE;
+    }
+
+    if (bufLen < 0 || bufLen > SHM_SLOT_SIZE) {
+      printf("Error: message too long for shared memory slot\n");
+      return FALSE;
+    }
+
+    if (!enqueueSHM(txRing, buf, bufLen)) {
+      ++nDropped;
+      return FALSE;
+    }
+
+    return bufLen;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPSocketFrom
+\date  Oct 2026
+
+\remarks
+
+Reads the next message. In blocking mode, waits until a message arrives,
+first busy-waiting and then sleeping on the futex of the ring.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     bufLen          : length of data buffer
+\param[out]    buf             : data buffer
+\param[out]    peer            : the loopback address and the port of the
+                                 segment -- pass NULL if not needed
+
+returns the number of bytes received, 0 if no message is available in
+non-blocking mode, or ERROR
+
+  ******************************************************************************/
+  int SHM_communication::
+  readUDPSocketFrom(char        *buf,
+		    int          bufLen,
+		    UDPEndpoint *peer)
+  {
+    uint64_t t_spin = 0;
+    uint32_t futex;
+    int      n;
+
+    if (!active) {
+      printf("shared memory not initialized\n");
+      return ERROR;
+    }
+
+    if (peer != NULL) {
+      peer->addr = htonl(INADDR_LOOPBACK);
+      peer->port = htons(portNum);
+    }
+
+    while ((n = dequeueSHM(rxRing, buf, bufLen)) == ERROR) {
+
+      if (non_block)
+	return 0;
+
+      // busy waiting only helps if the writer runs on another core
+      if (t_spin == 0)
+	t_spin = monotonicTimeNs() + (sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SHM_SPIN_NS : 0);
+
+      if (monotonicTimeNs() < t_spin) {
+	cpuRelax();
+	continue;
+      }
+
+      // register as sleeper, and check once more before sleeping, such
+      // that a concurrent write either is seen or wakes us up
+      futex = rxRing->futex.load();
+      rxRing->waiters.fetch_add(1);
+      if ((n = dequeueSHM(rxRing, buf, bufLen)) != ERROR) {
+	rxRing->waiters.fetch_sub(1);
+	break;
+      }
+      syscall(SYS_futex, &rxRing->futex, FUTEX_WAIT, futex, NULL, NULL, 0);
+      rxRing->waiters.fetch_sub(1);
+    }
+
+    return n;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPSocket
+\date  Oct 2026
+
+\remarks
+
+Reads the next message, as readUDPSocketFrom().
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     bufLen          : length of data buffer
+\param[out]    buf             : data buffer
+\param[out]    inetAddr        : set to the loopback address -- pass NULL if
+                                 not needed
+
+returns the number of bytes received
+
+  ******************************************************************************/
+  int SHM_communication::
+  readUDPSocket(char *buf,
+		int   bufLen,
+		char *inetAddr)
+  {
+    int n;
+
+    // errors are reported as no data, as by UDP_communication
+    if ((n = readUDPSocketFrom(buf,bufLen,NULL)) == ERROR)
+      return FALSE;
+    if (n > 0 && inetAddr != NULL)
+      strcpy(inetAddr,"127.0.0.1");
+
+    return n;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  checkUDPSocket
+\date  Oct 2026
+
+\remarks
+
+checks for available data
+
+returns the length of the next message, or 0 if there is none
+
+  ******************************************************************************/
+  int SHM_communication::
+  checkUDPSocket(void)
+  {
+    uint64_t pos;
+    SHMSlot *slot;
+
+    if (!active) {
+      printf("shared memory not initialized\n");
+      return FALSE;
+    }
+
+    pos  = rxRing->tail.load(std::memory_order_relaxed);
+    slot = &rxRing->slots[pos & (SHM_N_SLOTS-1)];
+    if (slot->seq.load(std::memory_order_acquire) != pos+1)
+      return 0;
+
+    return slot->len;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  setUDPNonBlocking
+\date  Oct 2026
+
+\remarks
+
+Set (or unsets) the blocking status of reads.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param [in]   do_not_block: FALSE for blocking reads, TRUE for non blocking
+
+  ******************************************************************************/
+  void SHM_communication::
+  setUDPNonBlocking(int do_not_block)
+  {
+    if (!active) {
+      printf("shared memory not initialized\n");
+      return;
+    }
+
+    non_block = do_not_block;
+  }
+
+} // end of namespace
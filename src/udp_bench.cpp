@@ -0,0 +1,567 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_bench.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  benchmark of the UDP transport over loopback: round trip latency
+  percentiles from ping-pong exchanges, the raw send and receive rates when
+  sending as fast as possible, and the max. sustainable rate, i.e., the
+  highest paced rate whose loss stays below BENCH_MAX_LOSS_PCT, for
+  different payload sizes, each with blocking, non-blocking, and batched
+  socket I/O. Results are printed as CSV, one line per mode and payload size,
+  such that runs can be compared automatically. The CSV goes to the file
+  given on the command line, or to stdout, in which case all other output,
+  e.g., of the socket setup, is moved to stderr.
+
+  ============================================================================*/
+
+// global headers
+#include <iostream>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <sched.h>
+#include <unistd.h>
+
+/* local headers */
+#include "utility.h"
+#include "udp_communication.h"
+#include "udp_paced.h"
+
+#define BENCHPORT         55012
+#define BENCH_BATCH       16        //!< packets per burst in batched mode
+#define BENCH_MAX_PAYLOAD 8192
+#define BENCH_QUIT_LEN    1         //!< a datagram of this length stops the peer
+#define BENCH_BURST_BYTES 65536     //!< limit of a burst, to stay below the socket buffer
+#define BENCH_TIMEOUT_MS  100       //!< a reply missing for this long is lost
+#define BENCH_PACE_HZ     10000     //!< max. wake ups per second of the paced sender
+#define BENCH_SEARCH_STEPS 6        //!< bisections of the sustainable rate
+#define BENCH_MAX_LOSS_PCT 0.1      //!< max. loss of a sustainable rate
+
+enum { MODE_BLOCKING, MODE_NONBLOCKING, MODE_BATCHED, N_MODES };
+static const char *mode_names[N_MODES] = { "blocking", "nonblocking", "batched" };
+
+static const int payload_sizes[] = { 16, 64, 256, 1024, 4096, 8192 };
+
+using namespace std;
+using namespace udp_communication;
+
+/* local functions */
+
+static uint64_t
+timeNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+ \note  LatencyHistogram
+ \date  Oct 2026
+
+ \remarks
+
+ A log-linear (HDR style) histogram of nanosecond values: every power of 2
+ range is split into 64 linear bins, which bounds the relative error of any
+ reported percentile to below 1/64.
+
+ ******************************************************************************/
+#define HIST_SUB_BITS  7
+#define HIST_HALF      (1 << (HIST_SUB_BITS-1))
+#define HIST_MAX_BITS  40
+#define HIST_N_BINS    ((HIST_MAX_BITS - HIST_SUB_BITS + 2) * HIST_HALF)
+
+class LatencyHistogram {
+public:
+  LatencyHistogram() { reset(); }
+
+  void
+  reset() {
+    memset(counts_, 0, sizeof(counts_));
+    total_ = 0;
+    max_   = 0;
+  }
+
+  void
+  record(uint64_t v) {
+    int bucket = 0;
+
+    if (v >= (1ULL << HIST_MAX_BITS))
+      v = (1ULL << HIST_MAX_BITS) - 1;
+    if (v >= (1ULL << HIST_SUB_BITS))
+      bucket = 63 - __builtin_clzll(v) - HIST_SUB_BITS + 1;
+
+    ++counts_[bucket*HIST_HALF + (v >> bucket)];
+    ++total_;
+    if (v > max_)
+      max_ = v;
+  }
+
+  // the highest value that falls into the same bin as the p-quantile
+  uint64_t
+  percentile(double p) {
+    uint64_t target = (uint64_t) (p * total_ + 0.5);
+    uint64_t cum = 0;
+    int      bucket;
+
+    if (target < 1)
+      target = 1;
+
+    for (int i=0; i<HIST_N_BINS; ++i) {
+      cum += counts_[i];
+      if (cum >= target) {
+	bucket = i < 2*HIST_HALF ? 0 : i/HIST_HALF - 1;
+	uint64_t v = ((uint64_t) (i - bucket*HIST_HALF) << bucket) + (1ULL << bucket) - 1;
+	return v < max_ ? v : max_;
+      }
+    }
+
+    return max_;
+  }
+
+  uint64_t total() { return total_; }
+  uint64_t max()   { return max_; }
+
+private:
+  uint64_t counts_[HIST_N_BINS];
+  uint64_t total_;
+  uint64_t max_;
+};
+
+/*!*****************************************************************************
+ *******************************************************************************
+ \note  readPacket
+ \date  Oct 2026
+
+ \remarks
+
+ reads one packet in the given mode; the non-blocking mode busy-polls for
+ at most BENCH_TIMEOUT_MS, and returns 0 if nothing arrived
+
+ ******************************************************************************/
+static int
+readPacket(UDP_communication *udp, int mode, char *buf, int len)
+{
+  uint64_t t_end;
+  int      n;
+
+  if (mode == MODE_NONBLOCKING) {
+    t_end = timeNs() + BENCH_TIMEOUT_MS * 1000000ULL;
+    // yield such that the peer thread gets to run on a single core machine
+    while ((n = udp->readUDPSocketFrom(buf, len, NULL)) == 0 && timeNs() < t_end)
+      sched_yield();
+    return n;
+  }
+
+  return udp->readUDPSocketFrom(buf, len, NULL);
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+ \note  echoServer
+ \date  Oct 2026
+
+ \remarks
+
+ returns every packet to its sender until a quit datagram arrives
+
+ ******************************************************************************/
+static void
+echoServer(UDP_communication *srv, int mode, std::atomic<bool> *done)
+{
+  static char bufs[UDP_MAX_BATCH][BENCH_MAX_PAYLOAD];
+  UDPMessage  msgs[UDP_MAX_BATCH];
+  int         n, i;
+
+  if (mode == MODE_BATCHED) {
+    for (i=0; i<UDP_MAX_BATCH; ++i) {
+      msgs[i].buf    = bufs[i];
+      msgs[i].bufLen = BENCH_MAX_PAYLOAD;
+    }
+    while (TRUE) {
+      if ((n = srv->readUDPSocketBatch(msgs, UDP_MAX_BATCH)) <= 0)
+	continue;
+      for (i=0; i<n; ++i) {
+	if (msgs[i].msgLen == BENCH_QUIT_LEN) {
+	  *done = true;
+	  return;
+	}
+	msgs[i].bufLen = msgs[i].msgLen;
+      }
+      srv->writeUDPSocketBatch(msgs, n);
+      for (i=0; i<n; ++i)
+	msgs[i].bufLen = BENCH_MAX_PAYLOAD;
+    }
+  }
+
+  while (TRUE) {
+    n = readPacket(srv, mode, bufs[0], BENCH_MAX_PAYLOAD);
+    if (n == BENCH_QUIT_LEN) {
+      *done = true;
+      return;
+    }
+    if (n > 0)
+      srv->writeUDPSocket(bufs[0], n);
+  }
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+ \note  waitForReply
+ \date  Oct 2026
+
+ \remarks
+
+ waits until the socket is readable, such that a lost reply does not block
+ the benchmark forever; returns FALSE on timeout. In non-blocking mode,
+ readPacket() polls with the time out instead.
+
+ ******************************************************************************/
+static int
+waitForReply(UDP_communication *udp, int mode)
+{
+  struct pollfd pfd;
+
+  if (mode == MODE_NONBLOCKING)
+    return TRUE;
+
+  pfd.fd     = udp->getUDPSocketFd();
+  pfd.events = POLLIN;
+
+  return poll(&pfd, 1, BENCH_TIMEOUT_MS) > 0;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+ \note  benchLatency
+ \date  Oct 2026
+
+ \remarks
+
+ ping-pong round trip times between a connected client and an echo server;
+ lost replies are not recorded, i.e., the histogram count is the number of
+ completed round trips. Every packet carries the iteration number, such that
+ a reply that arrives after its iteration timed out is discarded instead of
+ being taken for the reply of the next iteration.
+
+ ******************************************************************************/
+static void
+benchLatency(int mode, int payload, int n_iterations, LatencyHistogram *hist)
+{
+  static char bufs[BENCH_BATCH][BENCH_MAX_PAYLOAD];
+  char        loopback[] = "127.0.0.1";
+  char        quit = 'q';
+  UDPMessage  msgs[BENCH_BATCH];
+  UDP_communication srv;
+  UDP_communication cli;
+  std::atomic<bool> done(false);
+  uint64_t    t0;
+  int         i, j, n, n_received, tag;
+  int         n_burst = BENCH_BURST_BYTES/payload;
+
+  if (n_burst > BENCH_BATCH)
+    n_burst = BENCH_BATCH;
+
+  srv.makeUDPConnectedServer(BENCHPORT, loopback);
+  cli.makeUDPConnectedClient(BENCHPORT, loopback);
+  if (mode == MODE_NONBLOCKING) {
+    srv.setUDPNonBlocking(TRUE);
+    cli.setUDPNonBlocking(TRUE);
+  }
+
+  std::thread echo(echoServer, &srv, mode, &done);
+
+  memset(bufs, 0, sizeof(bufs));
+  for (j=0; j<BENCH_BATCH; ++j) {
+    msgs[j].buf    = bufs[j];
+    msgs[j].bufLen = payload;
+  }
+
+  hist->reset();
+  for (i=0; i<n_iterations; ++i) {
+    if (mode == MODE_BATCHED) {
+      // a burst of packets, each with the time until its batch came back
+      for (j=0; j<n_burst; ++j)
+	memcpy(bufs[j], &i, sizeof(i));
+      t0 = timeNs();
+      cli.writeUDPSocketBatch(msgs, n_burst);
+      for (n_received=0; n_received<n_burst; ) {
+	for (j=0; j<BENCH_BATCH; ++j)
+	  msgs[j].bufLen = payload;
+	if (!waitForReply(&cli, mode) ||
+	    (n = cli.readUDPSocketBatch(msgs, n_burst - n_received)) <= 0)
+	  break;
+	for (j=0; j<n; ++j) {
+	  memcpy(&tag, msgs[j].buf, sizeof(tag));
+	  if (tag == i) {
+	    hist->record(timeNs() - t0);
+	    ++n_received;
+	  }
+	}
+      }
+      for (j=0; j<BENCH_BATCH; ++j)
+	msgs[j].bufLen = payload;
+    } else {
+      memcpy(bufs[0], &i, sizeof(i));
+      t0 = timeNs();
+      cli.writeUDPSocket(bufs[0], payload);
+      while (waitForReply(&cli, mode) &&
+	     readPacket(&cli, mode, bufs[0], BENCH_MAX_PAYLOAD) > 0) {
+	memcpy(&tag, bufs[0], sizeof(tag));
+	if (tag == i) {
+	  hist->record(timeNs() - t0);
+	  break;
+	}
+      }
+    }
+  }
+
+  // the quit datagram may be dropped like any other
+  struct timespec ns = { 0, 10000000 };
+  while (!done) {
+    cli.writeUDPSocket(&quit, BENCH_QUIT_LEN);
+    nanosleep(&ns, NULL);
+  }
+  echo.join();
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+ \note  benchThroughput
+ \date  Oct 2026
+
+ \remarks
+
+ a client sends for the given duration, and a receiver thread counts what
+ arrives. With a rate, the client is paced with absolute deadlines, sending
+ as many packets per deadline as needed to keep the wake ups below
+ BENCH_PACE_HZ; without a rate, it sends as fast as possible.
+
+ ******************************************************************************/
+static void
+benchThroughput(int mode, int payload, double duration, double rate,
+		double *pps_sent, double *pps_received, double *loss_pct)
+{
+  static char            bufs[UDP_MAX_BATCH][BENCH_MAX_PAYLOAD];
+  char                   loopback[] = "127.0.0.1";
+  char                   quit = 'q';
+  UDPMessage             msgs[UDP_MAX_BATCH];
+  UDP_communication      srv;
+  UDP_communication      cli;
+  std::atomic<uint64_t>  n_received(0);
+  std::atomic<uint64_t>  t_last(0);
+  std::atomic<bool>      done(false);
+  UDPPacedSender         pacer;
+  uint64_t               n_sent = 0;
+  uint64_t               t0, t_end;
+  int                    n_per_period = UDP_MAX_BATCH;
+  int                    i, n;
+
+  srv.makeUDPServer(BENCHPORT, loopback);
+  cli.makeUDPConnectedClient(BENCHPORT, loopback);
+  if (mode == MODE_NONBLOCKING)
+    srv.setUDPNonBlocking(TRUE);
+
+  std::thread receiver([&]() {
+      static char rbufs[UDP_MAX_BATCH][BENCH_MAX_PAYLOAD];
+      UDPMessage  rmsgs[UDP_MAX_BATCH];
+      int         n, j;
+
+      for (j=0; j<UDP_MAX_BATCH; ++j) {
+	rmsgs[j].buf    = rbufs[j];
+	rmsgs[j].bufLen = BENCH_MAX_PAYLOAD;
+      }
+      while (TRUE) {
+	if (mode == MODE_BATCHED) {
+	  n = srv.readUDPSocketBatch(rmsgs, UDP_MAX_BATCH);
+	  for (j=0; j<n; ++j)
+	    if (rmsgs[j].msgLen == BENCH_QUIT_LEN) {
+	      n_received += j;
+	      done = true;
+	      return;
+	    }
+	} else {
+	  n = readPacket(&srv, mode, rbufs[0], BENCH_MAX_PAYLOAD);
+	  if (n == BENCH_QUIT_LEN) {
+	    done = true;
+	    return;
+	  }
+	  n = n > 0 ? 1 : 0;
+	}
+	n_received += n;
+	t_last = timeNs();
+      }
+    });
+
+  memset(bufs, 0, sizeof(bufs));
+  for (i=0; i<UDP_MAX_BATCH; ++i) {
+    msgs[i].buf    = bufs[i];
+    msgs[i].bufLen = payload;
+  }
+
+  if (rate > 0) {
+    n_per_period = (int) (rate / BENCH_PACE_HZ) + 1;
+    pacer.initUDPPacer(&cli, rate / n_per_period);
+  } else if (mode != MODE_BATCHED) {
+    n_per_period = 1;
+  }
+
+  t0    = timeNs();
+  t_end = t0 + (uint64_t) (duration * 1.e9);
+  while (timeNs() < t_end) {
+    // a sender that falls behind skips periods instead of catching up
+    if (rate > 0)
+      pacer.waitUDPPacer();
+    for (i=0; i<n_per_period; i+=n) {
+      if (mode == MODE_BATCHED) {
+	n = n_per_period - i < UDP_MAX_BATCH ? n_per_period - i : UDP_MAX_BATCH;
+	n_sent += cli.writeUDPSocketBatch(msgs, n);
+      } else {
+	n = 1;
+	if (cli.writeUDPSocket(bufs[0], payload) == payload)
+	  ++n_sent;
+      }
+    }
+  }
+  *pps_sent = n_sent / ((timeNs() - t0) * 1.e-9);
+
+  // let the receiver drain the socket buffer before stopping it; the quit
+  // datagram is repeated as it may be dropped like any other
+  struct timespec ns = { 0, 100000000 };
+  nanosleep(&ns, NULL);
+  ns.tv_nsec = 10000000;
+  while (!done) {
+    cli.writeUDPSocket(&quit, BENCH_QUIT_LEN);
+    nanosleep(&ns, NULL);
+  }
+  receiver.join();
+
+  *pps_received = t_last > t0 ? n_received / ((t_last - t0) * 1.e-9) : 0;
+  *loss_pct     = n_sent > 0 ? 100. * (1. - (double) n_received / n_sent) : 0;
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+ \note  benchSustainable
+ \date  Oct 2026
+
+ \remarks
+
+ bisects the paced rate between 0 and the raw send rate for the highest
+ rate whose loss stays below BENCH_MAX_LOSS_PCT; returns the receive rate
+ and the loss of that rate, or 0 if no tried rate was loss free enough
+
+ ******************************************************************************/
+static void
+benchSustainable(int mode, int payload, double duration, double pps_raw,
+		 double *pps_sustained, double *loss_pct)
+{
+  double lo = 0, hi = pps_raw, rate;
+  double pps_sent, pps_received, loss;
+
+  *pps_sustained = 0;
+  *loss_pct      = 0;
+
+  for (int i=0; i<BENCH_SEARCH_STEPS; ++i) {
+    rate = 0.5 * (lo + hi);
+    benchThroughput(mode, payload, duration, rate, &pps_sent, &pps_received, &loss);
+    if (loss <= BENCH_MAX_LOSS_PCT) {
+      lo = rate;
+      *pps_sustained = pps_received;
+      *loss_pct      = loss;
+    } else {
+      hi = rate;
+    }
+  }
+}
+
+/*!*****************************************************************************
+ *******************************************************************************
+ \note  main
+ \date  Oct 2026
+
+ \remarks
+
+ runs all benchmarks and writes the results as CSV
+
+ *******************************************************************************
+ Function Parameters: [in]=input,[out]=output
+
+ \param[in]     argc : number of elements in argv
+ \param[in]     argv : array of argc character strings
+
+ ******************************************************************************/
+int
+main(int argc, char**argv)
+{
+  int    n_iterations = 10000;
+  double duration = 0.25;
+  double pps_sent, pps_received, loss_pct;
+  double pps_sustained, sustained_loss_pct;
+  FILE  *csv;
+  LatencyHistogram hist;
+
+  if (argc > 1 && argv[1][0] == '-') {
+    printf("Usage: xudpBench [n_iterations] [duration of a throughput run in s] [csv file]\n");
+    return 1;
+  }
+  if (argc > 1)
+    sscanf(argv[1],"%d",&n_iterations);
+  if (argc > 2)
+    sscanf(argv[2],"%lf",&duration);
+
+  if (argc > 3) {
+    if ((csv = fopen(argv[3],"w")) == NULL) {
+      printf("Error: could not open %s\n",argv[3]);
+      return 1;
+    }
+  } else {
+    // keep stdout for the CSV, and send everything else to stderr
+    fflush(stdout);
+    if ((csv = fdopen(dup(STDOUT_FILENO),"w")) == NULL) {
+      printf("Error: could not duplicate stdout\n");
+      return 1;
+    }
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+  }
+
+  fprintf(csv,"mode,payload,rtt_count,rtt_p50_ns,rtt_p99_ns,rtt_p999_ns,rtt_max_ns,"
+	      "tx_pps,rx_pps,loss_pct,sustained_pps,sustained_loss_pct\n");
+
+  for (int mode=0; mode<N_MODES; ++mode) {
+    for (size_t i=0; i<sizeof(payload_sizes)/sizeof(int); ++i) {
+      benchLatency(mode, payload_sizes[i], n_iterations, &hist);
+      benchThroughput(mode, payload_sizes[i], duration, 0,
+		      &pps_sent, &pps_received, &loss_pct);
+      benchSustainable(mode, payload_sizes[i], duration, pps_sent,
+		       &pps_sustained, &sustained_loss_pct);
+
+      fprintf(csv,"%s,%d,%lu,%lu,%lu,%lu,%lu,%.0f,%.0f,%.2f,%.0f,%.2f\n",
+		  mode_names[mode], payload_sizes[i],
+		  (unsigned long) hist.total(),
+		  (unsigned long) hist.percentile(0.5),
+		  (unsigned long) hist.percentile(0.99),
+		  (unsigned long) hist.percentile(0.999),
+		  (unsigned long) hist.max(),
+		  pps_sent, pps_received, loss_pct, pps_sustained, sustained_loss_pct);
+      fflush(csv);
+    }
+  }
+
+  fclose(csv);
+
+  return 0;
+}
@@ -0,0 +1,568 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_capture.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  Recording and replay of UDP traffic. A UDPCapture attached to a
+  UDP_communication socket with setUDPCapture() appends every datagram that is
+  read or written, with time stamp, direction, and peer, to a memory-mapped
+  file. The file is sized once when it is opened, such that recording is just
+  an atomic reservation and a memcpy, without any system call.
+
+  A UDPReplay reads a capture file, and either iterates over its records, or
+  sends them again through a socket at the original timing, scaled in time,
+  or as fast as possible.
+
+  ============================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+#include "unistd.h"
+#include "string.h"
+#include "errno.h"
+#include "fcntl.h"
+#include "time.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+
+// my utilities library
+#include "utility.h"
+
+#include "udp_capture.h"
+
+#define CAPTURE_ALIGN(n) (((n) + 7) & ~((size_t) 7))
+
+namespace udp_communication {
+
+  static uint64_t
+  monotonicTimeNs(void)
+  {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+
+  static uint64_t
+  realtimeNs(void)
+  {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  UDPCapture
+\date  Oct 2026
+
+\remarks
+
+The capture is inactive until openUDPCapture() was called.
+
+  ******************************************************************************/
+  UDPCapture::
+  UDPCapture()
+  {
+    active  = FALSE;
+    fd      = ERROR;
+    map     = NULL;
+    mapSize = 0;
+    writePos.store(0);
+    nRecorded.store(0);
+    nDropped.store(0);
+  }
+
+  UDPCapture::
+  ~UDPCapture()
+  {
+    if (active)
+      closeUDPCapture();
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  openUDPCapture
+\date  Oct 2026
+
+\remarks
+
+Creates a capture file of maxBytes, and maps it into memory. Datagrams that
+do not fit anymore are counted in nDropped.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     fileName        : the capture file
+\param[in]     maxBytes        : max. size of the file
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPCapture::
+  openUDPCapture(char  *fileName,
+		 size_t maxBytes)
+  {
+    UDPCaptureFileHeader *hdr;
+
+    if (active) {
+      printf("Capture is already active\n");
+      return FALSE;
+    }
+
+    if (maxBytes < sizeof(UDPCaptureFileHeader)) {
+      printf("Error: capture file too small\n");
+      return FALSE;
+    }
+
+    if ((fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644)) == ERROR) {
+      printf("Error: could not open capture file %s (errno=%d)\n",fileName,errno);
+      return FALSE;
+    }
+
+    if (ftruncate(fd, maxBytes) == ERROR) {
+      printf("Error: could not size capture file %s (errno=%d)\n",fileName,errno);
+      close(fd);
+      return FALSE;
+    }
+
+    // allocate the blocks and map all pages now, such that recording does not
+    // page fault
+    posix_fallocate(fd, 0, maxBytes);
+    map = (char *) mmap(NULL, maxBytes, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (map == MAP_FAILED) {
+      printf("Error: could not map capture file %s (errno=%d)\n",fileName,errno);
+      map = NULL;
+      close(fd);
+      return FALSE;
+    }
+
+    hdr = (UDPCaptureFileHeader *) map;
+    hdr->magic         = UDP_CAPTURE_MAGIC;
+    hdr->start_ns      = realtimeNs();
+    hdr->start_mono_ns = monotonicTimeNs();
+    hdr->reserved      = 0;
+
+    mapSize = maxBytes;
+    writePos.store(sizeof(UDPCaptureFileHeader));
+    nRecorded.store(0);
+    nDropped.store(0);
+    active = TRUE;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  closeUDPCapture
+\date  Oct 2026
+
+\remarks
+
+Unmaps the capture file and truncates it to the recorded data. Detach the
+capture from all sockets before.
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPCapture::
+  closeUDPCapture(void)
+  {
+    size_t len;
+
+    if (!active) {
+      printf("Capture not initialized\n");
+      return FALSE;
+    }
+
+    active = FALSE;
+    len = writePos.load();
+    if (len > mapSize)
+      len = mapSize;
+
+    munmap(map, mapSize);
+    map = NULL;
+
+    if (ftruncate(fd, len) == ERROR)
+      printf("Error: could not truncate capture file (errno=%d)\n",errno);
+    close(fd);
+    fd = ERROR;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  recordUDPPacket
+\date  Oct 2026
+
+\remarks
+
+Appends a datagram to the capture file; can be called from several threads.
+The length of a record is written last, such that a reader can tell
+complete records from ones that are still being written.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     direction       : UDP_CAPTURE_RX or UDP_CAPTURE_TX
+\param[in]     buf             : the datagram
+\param[in]     len             : length of the datagram
+\param[in]     peer            : sender or receiver -- may be NULL
+
+  ******************************************************************************/
+  void UDPCapture::
+  recordUDPPacket(int                direction,
+		  const char        *buf,
+		  int                len,
+		  const UDPEndpoint *peer)
+  {
+    struct iovec iov;
+
+    iov.iov_base = (void *) buf;
+    iov.iov_len  = len;
+
+    recordUDPPacketV(direction, &iov, 1, len, peer);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  recordUDPPacketV
+\date  Oct 2026
+
+\remarks
+
+Like recordUDPPacket(), for a datagram that is scattered over several
+segments; they are gathered directly into the capture file.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     direction       : UDP_CAPTURE_RX or UDP_CAPTURE_TX
+\param[in]     iov             : the segments of the datagram
+\param[in]     iovcnt          : number of segments
+\param[in]     len             : length of the datagram -- segments beyond
+                                  it are not recorded
+\param[in]     peer            : sender or receiver -- may be NULL
+
+  ******************************************************************************/
+  void UDPCapture::
+  recordUDPPacketV(int                direction,
+		   const struct iovec *iov,
+		   int                 iovcnt,
+		   int                 len,
+		   const UDPEndpoint  *peer)
+  {
+    UDPCaptureRecord *rec;
+    size_t            size;
+    size_t            pos;
+    int               total = 0;
+    int               n;
+
+    if (!active || len <= 0)
+      return;
+
+    // a truncated datagram is recorded as far as it was read
+    for (int i=0; i<iovcnt; ++i)
+      total += iov[i].iov_len;
+    if (len > total)
+      len = total;
+
+    size = CAPTURE_ALIGN(sizeof(UDPCaptureRecord) + len);
+    pos  = writePos.fetch_add(size, std::memory_order_relaxed);
+    if (pos + size > mapSize) {
+      nDropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    rec = (UDPCaptureRecord *) (map + pos);
+    rec->direction = direction;
+    rec->port      = peer != NULL ? peer->port : 0;
+    rec->addr      = peer != NULL ? peer->addr : 0;
+    rec->reserved  = 0;
+    rec->t_ns      = monotonicTimeNs();
+    for (int i=0, off=0; i<iovcnt && off<len; ++i, off+=n) {
+      n = (int) iov[i].iov_len < len - off ? (int) iov[i].iov_len : len - off;
+      memcpy((char *) (rec + 1) + off, iov[i].iov_base, n);
+    }
+    __atomic_store_n(&rec->len, (uint32_t) len, __ATOMIC_RELEASE);
+
+    nRecorded.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  UDPReplay
+\date  Oct 2026
+
+\remarks
+
+The replay is inactive until openUDPReplay() was called.
+
+  ******************************************************************************/
+  UDPReplay::
+  UDPReplay()
+  {
+    active      = FALSE;
+    fd          = ERROR;
+    map         = NULL;
+    mapSize     = 0;
+    readPos     = 0;
+    maxLateness = 0;
+  }
+
+  UDPReplay::
+  ~UDPReplay()
+  {
+    if (active)
+      closeUDPReplay();
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  openUDPReplay
+\date  Oct 2026
+
+\remarks
+
+Maps a capture file for reading.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     fileName        : the capture file
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPReplay::
+  openUDPReplay(char *fileName)
+  {
+    struct stat st;
+
+    if (active) {
+      printf("Replay is already active\n");
+      return FALSE;
+    }
+
+    if ((fd = open(fileName, O_RDONLY)) == ERROR) {
+      printf("Error: could not open capture file %s (errno=%d)\n",fileName,errno);
+      return FALSE;
+    }
+
+    if (fstat(fd, &st) == ERROR || (size_t) st.st_size < sizeof(UDPCaptureFileHeader)) {
+      printf("Error: %s is not a capture file\n",fileName);
+      close(fd);
+      return FALSE;
+    }
+
+    map = (char *) mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      printf("Error: could not map capture file %s (errno=%d)\n",fileName,errno);
+      map = NULL;
+      close(fd);
+      return FALSE;
+    }
+
+    if (((UDPCaptureFileHeader *) map)->magic != UDP_CAPTURE_MAGIC) {
+      printf("Error: %s is not a capture file\n",fileName);
+      munmap(map, st.st_size);
+      map = NULL;
+      close(fd);
+      return FALSE;
+    }
+
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+    mapSize = st.st_size;
+    readPos = sizeof(UDPCaptureFileHeader);
+    active  = TRUE;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  closeUDPReplay
+\date  Oct 2026
+
+\remarks
+
+Unmaps the capture file.
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPReplay::
+  closeUDPReplay(void)
+  {
+    if (!active) {
+      printf("Replay not initialized\n");
+      return FALSE;
+    }
+
+    active = FALSE;
+    munmap(map, mapSize);
+    map = NULL;
+    close(fd);
+    fd = ERROR;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  nextUDPRecord
+\date  Oct 2026
+
+\remarks
+
+Returns the next complete record of the capture file. The pointers refer to
+the mapped file and stay valid until closeUDPReplay().
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[out]    rec             : the record header
+\param[out]    data            : the datagram
+
+returns TRUE if a record was returned, FALSE at the end of the file
+
+  ******************************************************************************/
+  int UDPReplay::
+  nextUDPRecord(UDPCaptureRecord **rec,
+		char             **data)
+  {
+    UDPCaptureRecord *r;
+
+    if (!active)
+      return FALSE;
+
+    if (readPos + sizeof(UDPCaptureRecord) > mapSize)
+      return FALSE;
+
+    r = (UDPCaptureRecord *) (map + readPos);
+    if (r->len == 0 || readPos + sizeof(UDPCaptureRecord) + r->len > mapSize)
+      return FALSE;
+
+    *rec  = r;
+    *data = (char *) (r + 1);
+    readPos += CAPTURE_ALIGN(sizeof(UDPCaptureRecord) + r->len);
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  rewindUDPReplay
+\date  Oct 2026
+
+\remarks
+
+Restarts nextUDPRecord() at the first record.
+
+  ******************************************************************************/
+  void UDPReplay::
+  rewindUDPReplay(void)
+  {
+    readPos = sizeof(UDPCaptureFileHeader);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  replayUDPCapture
+\date  Oct 2026
+
+\remarks
+
+Sends the recorded datagrams of one direction through a socket, e.g., the
+datagrams that a server received in the field to a server under test. The
+send times are absolute deadlines relative to the start of the replay, such
+that delays do not accumulate; the worst delay is reported in maxLateness.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     udp             : the socket to send with
+\param[in]     direction       : UDP_CAPTURE_RX, UDP_CAPTURE_TX, or
+                                 UDP_CAPTURE_ANY
+\param[in]     speed           : 1 for the original timing, >1 for faster than
+                                 real time, 0 for as fast as possible
+
+returns the number of datagrams sent, or ERROR
+
+  ******************************************************************************/
+  int UDPReplay::
+  replayUDPCapture(UDP_communication *udp,
+		   int    direction,
+		   double speed)
+  {
+    UDPCaptureRecord *rec;
+    char             *data;
+    uint64_t          t_first = 0;
+    uint64_t          t_start;
+    uint64_t          t_due;
+    int64_t           dt;
+    double            lateness;
+    struct timespec   ts;
+    int               n_sent = 0;
+
+    if (!active) {
+      printf("Replay not initialized\n");
+      return ERROR;
+    }
+
+    if (speed < 0) {
+      printf("Error: invalid replay speed\n");
+      return ERROR;
+    }
+
+    rewindUDPReplay();
+    maxLateness = 0;
+    t_start = monotonicTimeNs();
+
+    while (nextUDPRecord(&rec, &data)) {
+      if (direction != UDP_CAPTURE_ANY && rec->direction != direction)
+	continue;
+
+      if (speed > 0) {
+	if (n_sent == 0)
+	  t_first = rec->t_ns;
+
+	// records are in the order of their reservation, and with several threads
+	// on the socket, a record can carry an earlier time stamp than its
+	// predecessor
+	dt = (int64_t) (rec->t_ns - t_first);
+	if (dt < 0)
+	  dt = 0;
+	t_due = t_start + (uint64_t) (dt / speed);
+
+	ts.tv_sec  = t_due / 1000000000ULL;
+	ts.tv_nsec = t_due % 1000000000ULL;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+	  ;
+
+	lateness = ((int64_t) (monotonicTimeNs() - t_due)) * 1.e-9;
+	if (lateness > maxLateness)
+	  maxLateness = lateness;
+      }
+
+      if (udp->writeUDPSocket(data, rec->len) != (int) rec->len)
+	return ERROR;
+      ++n_sent;
+    }
+
+    return n_sent;
+  }
+
+} // end of namespace
@@ -0,0 +1,612 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_clock_sync.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  Estimates the offset and the drift of the clock of a remote node relative
+  to the local clock with two-way time transfer over an existing socket, such
+  that time stamps of the remote node can be converted into the local time
+  base with remoteToLocal().
+
+  A requester sends a request stamped with its send time t1. The responder
+  stamps the reception t2 and, just before it replies, t3, and the requester
+  stamps the reception of the reply t4. Assuming equal delays in both
+  directions, the remote clock is ahead of the local clock by
+
+     offset = ((t2 - t1) + (t3 - t4)) / 2
+
+  and the exchange took rtt = (t4 - t1) - (t3 - t2) on the network. The
+  error of the offset is at most rtt/2, such that only the exchanges of the
+  window whose round trip time is close to the minimum are used. A line is
+  fitted through their offsets over local time, which gives the drift, i.e.,
+  the rate difference of the clocks, once the samples span at least
+  UDP_CLOCK_MIN_SPAN_NS.
+
+  Clock datagrams are told from application datagrams by their magic and
+  their length, and readUDPClockSync() handles them internally and returns
+  all other datagrams. Every instance answers requests; the estimate is kept
+  for a single remote node, i.e., use one instance per peer. The requester
+  needs a connected socket (makeUDPConnectedClient()/
+  makeUDPConnectedServer()); the responder can use any socket that reads. If
+  kernel receive time stamps are enabled with setUDPTimestamping() and the
+  clock is CLOCK_REALTIME, they are used for t2 and t4, which removes the
+  scheduling latency of the reader from the estimate. The service is meant
+  for a single thread.
+
+  ============================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+#include "string.h"
+#include "time.h"
+
+// my utilities library
+#include "utility.h"
+
+#include "udp_clock_sync.h"
+
+namespace udp_communication {
+
+  static uint64_t
+  monotonicTimeNs(void)
+  {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Constructor
+\date  Oct 2026
+
+\remarks
+
+The service is inactive until initUDPClockSync() was called.
+
+  ******************************************************************************/
+  UDPClockSync::
+  UDPClockSync()
+  {
+    active = FALSE;
+    synced = FALSE;
+    udp    = NULL;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Destructor
+\date  Oct 2026
+
+\remarks
+
+The UDP socket is not closed.
+
+  ******************************************************************************/
+  UDPClockSync::
+  ~UDPClockSync()
+  {
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  initUDPClockSync
+\date  Oct 2026
+
+\remarks
+
+Initializes the service on an open socket.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     udp             : the UDP socket to the remote node
+\param[in]     clock           : clock of all time stamps, e.g., CLOCK_REALTIME
+\param[in]     window          : number of exchanges kept for the estimate, at
+                                 most UDP_CLOCK_MAX_SAMPLES
+\param[in]     period          : time between requests of serviceUDPClockSync()
+                                 [s], 0 to only answer requests or to send them
+                                 with requestUDPClockSync()
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPClockSync::
+  initUDPClockSync(UDP_communication *udp,
+		   clockid_t clock,
+		   int window,
+		   double period)
+  {
+    struct timespec ts;
+
+    if (active) {
+      printf("Clock synchronization is already active\n");
+      return FALSE;
+    }
+
+    if (udp == NULL || window < 2 || window > UDP_CLOCK_MAX_SAMPLES || period < 0) {
+      printf("Error: invalid clock synchronization parameters\n");
+      return FALSE;
+    }
+
+    if (clock_gettime(clock, &ts) == ERROR) {
+      printf("Error: clock %d is not available\n",(int) clock);
+      return FALSE;
+    }
+
+    this->udp     = udp;
+    this->clock   = clock;
+    this->window  = window;
+    periodNs      = (uint64_t) (period * 1.e9);
+    lastRequestNs = 0;
+    seq           = 0;
+    lastReplySeq  = 0;
+    nSamples      = 0;
+    head          = 0;
+    refNs         = 0;
+    offsetNs      = 0;
+    drift         = 0;
+    minRttNs      = 0;
+
+    nRequestsSent     = 0;
+    nRequestsAnswered = 0;
+    nRepliesReceived  = 0;
+    nRejected         = 0;
+    nInvalid          = 0;
+
+    synced = FALSE;
+    active = TRUE;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  getUDPClockTime
+\date  Oct 2026
+
+\remarks
+
+returns the current time of the clock of the service, i.e., the local time
+base of remoteToLocal()
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+returns the time in nanoseconds
+
+  ******************************************************************************/
+  uint64_t UDPClockSync::
+  getUDPClockTime(void)
+  {
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  requestUDPClockSync
+\date  Oct 2026
+
+\remarks
+
+Sends one request to the remote node. The reply is processed by
+readUDPClockSync() or handleUDPClockSync().
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPClockSync::
+  requestUDPClockSync(void)
+  {
+    UDPClockHeader hdr;
+
+    if (!active) {
+      printf("Clock synchronization not initialized\n");
+      return FALSE;
+    }
+
+    hdr.magic    = UDP_CLOCK_MAGIC;
+    hdr.type     = UDP_CLOCK_REQUEST;
+    hdr.reserved = 0;
+    hdr.seq      = seq + 1;
+    hdr.t2       = 0;
+    hdr.t3       = 0;
+
+    lastRequestNs = monotonicTimeNs();
+
+    // stamp as late as possible
+    hdr.t1 = getUDPClockTime();
+    if (udp->writeUDPSocket((char *) &hdr, sizeof(hdr)) != sizeof(hdr))
+      return FALSE;
+
+    ++seq;
+    ++nRequestsSent;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  serviceUDPClockSync
+\date  Oct 2026
+
+\remarks
+
+Sends a request if the request period has passed since the last one. Call
+periodically, e.g., once per control cycle.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPClockSync::
+  serviceUDPClockSync(void)
+  {
+    if (!active) {
+      printf("Clock synchronization not initialized\n");
+      return FALSE;
+    }
+
+    if (periodNs == 0 || monotonicTimeNs() - lastRequestNs < periodNs)
+      return TRUE;
+
+    return requestUDPClockSync();
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  handleUDPClockSync
+\date  Oct 2026
+
+\remarks
+
+Processes a datagram that was read by the application: requests are answered,
+replies are added to the estimate. Use this instead of readUDPClockSync() if
+the application reads the socket itself.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     buf             : the datagram
+\param[in]     len             : length of the datagram
+\param[in]     peer            : sender of the datagram, needed to answer
+                                 requests on unconnected sockets
+\param[in]     rxNs            : reception time in the clock of the service,
+                                 0 to take the current time
+
+returns TRUE if the datagram was a clock datagram, FALSE if it belongs to the
+application
+
+  ******************************************************************************/
+  int UDPClockSync::
+  handleUDPClockSync(const char        *buf,
+		     int                len,
+		     const UDPEndpoint *peer,
+		     uint64_t           rxNs)
+  {
+    UDPClockHeader  hdr;
+    Sample         *s;
+    int64_t         rtt;
+    int             n;
+
+    if (!active || len != sizeof(UDPClockHeader) ||
+	((const UDPClockHeader *) buf)->magic != UDP_CLOCK_MAGIC)
+      return FALSE;
+
+    if (rxNs == 0)
+      rxNs = getUDPClockTime();
+
+    memcpy(&hdr, buf, sizeof(hdr));
+
+    switch (hdr.type) {
+    case UDP_CLOCK_REQUEST:
+      if (!udp->isUDPConnected() && peer == NULL) {
+	++nInvalid;
+	break;
+      }
+      hdr.type = UDP_CLOCK_REPLY;
+      hdr.t2   = rxNs;
+      hdr.t3   = getUDPClockTime();
+      if (udp->isUDPConnected())
+	n = udp->writeUDPSocket((char *) &hdr, sizeof(hdr));
+      else
+	n = udp->writeUDPSocketTo((char *) &hdr, sizeof(hdr), peer);
+      if (n == sizeof(hdr))
+	++nRequestsAnswered;
+      break;
+
+    case UDP_CLOCK_REPLY:
+      // only replies to the last requests, each at most once, and in order
+      rtt = (int64_t) (rxNs - hdr.t1) - (int64_t) (hdr.t3 - hdr.t2);
+      if ((int32_t) (hdr.seq - lastReplySeq) <= 0 || (int32_t) (seq - hdr.seq) < 0 ||
+	  (int64_t) (rxNs - hdr.t1) < 0 || rtt < 0) {
+	++nRejected;
+	break;
+      }
+      lastReplySeq = hdr.seq;
+
+      s = &samples[head];
+      s->tLocal = hdr.t1 + (rxNs - hdr.t1) / 2;
+      s->offset = ((int64_t) (hdr.t2 - hdr.t1) + (int64_t) (hdr.t3 - rxNs)) / 2;
+      s->rtt    = rtt;
+      head = (head + 1) % window;
+      if (nSamples < window)
+	++nSamples;
+      ++nRepliesReceived;
+
+      updateUDPClockEstimate();
+      break;
+
+    default:
+      ++nInvalid;
+    }
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  updateUDPClockEstimate
+\date  Oct 2026
+
+\remarks
+
+Fits offset + drift * (t - refNs) through the samples of the window whose round
+trip time is close to the minimum. Until these samples span
+UDP_CLOCK_MIN_SPAN_NS, the last drift is kept and only the offset is updated.
+
+  ******************************************************************************/
+  void UDPClockSync::
+  updateUDPClockEstimate(void)
+  {
+    Sample  *s;
+    int64_t  maxRtt;
+    double   x, y, xMean = 0, yMean = 0, sxx = 0, sxy = 0;
+    double   xMin = 0, xMax = 0, b;
+    int      i, n = 0;
+
+    minRttNs = samples[0].rtt;
+    for (i=1; i<nSamples; ++i)
+      if (samples[i].rtt < minRttNs)
+	minRttNs = samples[i].rtt;
+    maxRtt = minRttNs + minRttNs / 2 + UDP_CLOCK_RTT_SLACK_NS;
+
+    // relative to the newest sample, such that doubles keep nanoseconds
+    refNs = samples[(head + window - 1) % window].tLocal;
+
+    for (i=0; i<nSamples; ++i) {
+      s = &samples[i];
+      if (s->rtt > maxRtt)
+	continue;
+      x = (double) (int64_t) (s->tLocal - refNs);
+      y = (double) s->offset;
+      if (n == 0 || x < xMin)
+	xMin = x;
+      if (n == 0 || x > xMax)
+	xMax = x;
+      ++n;
+      xMean += (x - xMean) / n;
+      yMean += (y - yMean) / n;
+    }
+
+    for (i=0; i<nSamples; ++i) {
+      s = &samples[i];
+      if (s->rtt > maxRtt)
+	continue;
+      x = (double) (int64_t) (s->tLocal - refNs) - xMean;
+      y = (double) s->offset - yMean;
+      sxx += x * x;
+      sxy += x * y;
+    }
+
+    if (n >= 2 && xMax - xMin >= UDP_CLOCK_MIN_SPAN_NS && sxx > 0) {
+      b = sxy / sxx;
+      if (b > -UDP_CLOCK_MAX_DRIFT && b < UDP_CLOCK_MAX_DRIFT)
+	drift = b;
+    }
+
+    offsetNs = yMean - drift * xMean;
+    synced   = TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPClockSync
+\date  Oct 2026
+
+\remarks
+
+Reads the next application datagram from the socket like readUDPSocketFrom().
+Clock datagrams are processed internally. buf needs to hold at least a
+UDPClockHeader.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[out]    buf             : data buffer
+\param[in]     bufLen          : length of data buffer
+\param[out]    peer            : address and port of the sender -- pass NULL
+                                  if not needed
+
+returns the number of bytes received, 0 if no data on a non-blocking socket,
+or ERROR
+
+  ******************************************************************************/
+  int UDPClockSync::
+  readUDPClockSync(char        *buf,
+		   int          bufLen,
+		   UDPEndpoint *peer)
+  {
+    struct timespec ts;
+    UDPEndpoint     from;
+    uint64_t        rxNs, now;
+    int             n;
+
+    if (!active) {
+      printf("Clock synchronization not initialized\n");
+      return ERROR;
+    }
+
+    if (bufLen < (int) sizeof(UDPClockHeader)) {
+      printf("Error: buffer too small for clock synchronization\n");
+      return ERROR;
+    }
+
+    while (TRUE) {
+      n = udp->readUDPSocketTimestamped(buf, bufLen, &from, &ts);
+      if (n <= 0)
+	return n == 0 ? 0 : ERROR;
+
+      // kernel time stamps are CLOCK_REALTIME, or the NIC clock if hardware
+      // time stamping is on -- use them only if they are plausible
+      rxNs = 0;
+      if (clock == CLOCK_REALTIME && (ts.tv_sec || ts.tv_nsec)) {
+	now  = getUDPClockTime();
+	rxNs = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	if (rxNs > now || now - rxNs > 100000000ULL)
+	  rxNs = now;
+      }
+
+      if (handleUDPClockSync(buf, n, &from, rxNs))
+	continue;
+
+      if (peer != NULL)
+	*peer = from;
+
+      return n;
+    }
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  remoteToLocal
+\date  Oct 2026
+
+\remarks
+
+Converts a time stamp of the remote clock into the local clock of the service.
+Before the first exchange, the time stamp is returned unchanged.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     tRemote         : time stamp of the remote node [ns]
+
+returns the corresponding local time [ns]
+
+  ******************************************************************************/
+  uint64_t UDPClockSync::
+  remoteToLocal(uint64_t tRemote)
+  {
+    double dt;
+
+    if (!synced)
+      return tRemote;
+
+    // solve tRemote = tLocal + offsetNs + drift * (tLocal - refNs)
+    dt = ((double) (int64_t) (tRemote - refNs) - offsetNs) / (1. + drift);
+
+    return refNs + (int64_t) (dt < 0 ? dt - 0.5 : dt + 0.5);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  localToRemote
+\date  Oct 2026
+
+\remarks
+
+Converts a local time stamp into the clock of the remote node, e.g., to
+schedule an action on the remote node. Before the first exchange, the time
+stamp is returned unchanged.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     tLocal          : local time stamp [ns]
+
+returns the corresponding remote time [ns]
+
+  ******************************************************************************/
+  uint64_t UDPClockSync::
+  localToRemote(uint64_t tLocal)
+  {
+    double dt;
+
+    if (!synced)
+      return tLocal;
+
+    dt = (double) (int64_t) (tLocal - refNs);
+    dt = dt + offsetNs + drift * dt;
+
+    return refNs + (int64_t) (dt < 0 ? dt - 0.5 : dt + 0.5);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  getUDPClockOffset
+\date  Oct 2026
+
+\remarks
+
+returns the current estimate of the remote clock relative to the local clock
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[out]    offset          : remote minus local clock now [s] -- pass NULL
+                                 if not needed
+\param[out]    drift           : rate of the remote clock minus 1, e.g., 1.e-6
+                                 for 1ppm faster -- pass NULL if not needed
+\param[out]    rtt             : min. round trip time of the window [s] -- pass
+                                 NULL if not needed
+
+returns TRUE if an estimate exists, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPClockSync::
+  getUDPClockOffset(double *offset,
+		    double *drift,
+		    double *rtt)
+  {
+    uint64_t now;
+
+    if (!active || !synced)
+      return FALSE;
+
+    now = getUDPClockTime();
+
+    if (offset != NULL)
+      *offset = ((double) (int64_t) (localToRemote(now) - now)) * 1.e-9;
+    if (drift != NULL)
+      *drift = this->drift;
+    if (rtt != NULL)
+      *rtt = minRttNs * 1.e-9;
+
+    return TRUE;
+  }
+
+}
@@ -25,8 +25,15 @@
 #include "arpa/inet.h"
 #include "string.h"
 #include "sys/ioctl.h"
+#include "sys/socket.h"
+#include "poll.h"
+#include "netinet/udp.h"
+#include "linux/net_tstamp.h"
+#include "linux/errqueue.h"
 #include "netdb.h"
+#include "net/if.h"
 #include "errno.h"
+#include "limits.h"
 
 
 
@@ -34,6 +41,9 @@
 #include "utility.h"
 
 #include "udp_communication.h"
+#include "udp_capture.h"
+#include "udp_paced.h"
+#include "comm_log.h"
 
 // sleep or not?  If yes, make sure the timer has proper low resolution,
 // but also that the system does not block due to too much polling. Note
@@ -41,6 +51,7 @@
 //! using the regular API functions.
 #define USE_SLEEP TRUE
 
+using namespace comm_log;
 
 namespace udp_communication {
 
@@ -76,6 +87,12 @@ returns TRUE if all OK, otherwise FALSE
     // The socket is inactive until all information has been provided
     active = FALSE;
     is_server = FALSE;
+    connected = FALSE;
+    lock_on_peer = FALSE;
+    capture = NULL;
+    count_drops = FALSE;
+    nKernelDrops = 0;
+    nDropEvents = 0;
 
     // create a UDP-based socket
     if ((sFd = socket (AF_INET, SOCK_DGRAM, IPPROTO_UDP)) == ERROR) {
@@ -158,9 +175,9 @@ Function Parameters: [in]=input,[out]=output
 \param[in]     bufLen          : length of data buffer
 \param[out]    buf             : data buffer
 \param[out]    inetAddr        : inet address from where data was received,
-allocate as "char inetAddr[INET_ADDRSTRLENT]" for unix.
-NOTE: pass NULL to avoid returning this string -- for
-unix it is costly due to memory allocation.
+allocate as "char inetAddr[INET_ADDRSTRLEN]" for unix.
+NOTE: pass NULL to avoid returning this string -- on
+the hot path, use readUDPSocketFrom() instead.
 
 returns the number of bytes received
 
@@ -169,321 +186,2131 @@ returns the number of bytes received
   readUDPSocket(char *buf,
 		int   bufLen,
 		char *inetAddr)
+  {
+    UDPEndpoint         peer;
+    struct in_addr      addr;
+    int                 bufLenReceived;
+
+    // errors are reported as no data, as always
+    if ((bufLenReceived = readUDPSocketFrom(buf,bufLen,&peer)) == ERROR)
+      return FALSE;
+
+    // convert inet address to dot notation
+    if (bufLenReceived > 0 && inetAddr != NULL) {
+      addr.s_addr = peer.addr;
+      inet_ntop(AF_INET, &addr, inetAddr, INET_ADDRSTRLEN);
+    }
+
+    return bufLenReceived;
+
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPSocketFrom
+\date  Oct 2026
+
+\remarks
+
+Read from a previously created socket, and return the sender as a binary
+endpoint, which is cheap to compare, hash, or pass to writeUDPSocketTo().
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     bufLen          : length of data buffer
+\param[out]    buf             : data buffer
+\param[out]    peer            : address and port of the sender -- pass NULL
+                                  if not needed
+
+returns the number of bytes received, 0 if no data on a non-blocking socket,
+or ERROR
+
+  ******************************************************************************/
+  int UDP_communication::
+  readUDPSocketFrom(char        *buf,
+		    int          bufLen,
+		    UDPEndpoint *peer)
   {
     socklen_t           sockAddrSize;            // size of socket address structure
     struct sockaddr_in  clientAddr;              // client's socket address
     int                 bufLenReceived;
-    char               *inetAddrTemp;
+    UDPRecvInfo         info;
+
+    if (!active) {
+      logCommEvent(COMM_EV_UDP_NOT_ACTIVE,0,sFd);
+      return ERROR;
+    }
+
+    if (!is_server && !connected) {
+      logCommEvent(COMM_EV_UDP_NOT_SERVER,0,sFd);
+      return ERROR;
+    }
+
+    // the drop count is only available from the control messages
+    if (count_drops)
+      return recvUDPMessage(buf,bufLen,peer,&info);
+
+    // read data
+    sockAddrSize = sizeof (struct sockaddr_in);
+    if ((bufLenReceived = recvfrom (sFd, buf, bufLen, 0,
+				    (struct sockaddr *) &clientAddr,
+				    &sockAddrSize)) == ERROR) {
+
+      if (non_block && (errno==EAGAIN || errno==EWOULDBLOCK))
+	return 0;
+      else {
+	logCommEvent(COMM_EV_UDP_READ_ERROR,errno,sFd);
+	return ERROR;
+      }
+    }
+
+    // a connected server locks onto the first peer
+    if (lock_on_peer && !connected)
+      lockOnUDPPeer(&clientAddr);
+
+    if (peer != NULL) {
+      peer->addr = clientAddr.sin_addr.s_addr;
+      peer->port = clientAddr.sin_port;
+    }
+
+    if (capture != NULL)
+      captureUDPPackets(UDP_CAPTURE_RX,buf,bufLenReceived,bufLenReceived,&clientAddr);
+
+    return bufLenReceived;
+
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  setUDPBlocking
+\date  May 2004
+
+\remarks
+
+Set (or unsets) the blocking status of a socket.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param [in]   do_not_block: FALSE for a blocking socket, TRUE for non blocking
+
+returns number of bytes available for reading
+
+  ******************************************************************************/
+  void UDP_communication::
+  setUDPNonBlocking(int do_not_block)
+  {
+
+    if (!active) {
+      printf("Socket not initialized\n");
+      return;
+    }
+
+    ioctl(sFd,FIONBIO,(unsigned long) (&do_not_block));
+    non_block = do_not_block;
+
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  setUDPReusePort
+\date  Oct 2026
+
+\remarks
+
+Allows several sockets to bind to the same port (SO_REUSEPORT), such that the
+kernel distributes the incoming datagrams over them. Must be called before
+makeUDPServer().
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     reuse           : TRUE to share the port
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  setUDPReusePort(int reuse)
+  {
+
+    if (active) {
+      printf("Error: port sharing must be set before the socket is bound\n");
+      return FALSE;
+    }
+
+    if (setsockopt(sFd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) == ERROR) {
+      printf("Error: couldn't set SO_REUSEPORT (errno=%d)\n",errno);
+      return FALSE;
+    }
+
+    return TRUE;
+
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  setUDPBufferSizes
+\date  Oct 2026
+
+\remarks
+
+Sets the kernel receive and send buffer sizes of the socket. The sizes are
+the kernel memory the buffers may use, as reported by getUDPBufferSizes(),
+which includes roughly UDP_SKB_OVERHEAD bytes of bookkeeping per datagram.
+SO_RCVBUFFORCE/SO_SNDBUFFORCE are tried first, which bypass the
+net.core.rmem_max/wmem_max limits but need CAP_NET_ADMIN; otherwise the
+kernel limits apply, and a warning is printed if the size was capped. Best
+called before the socket is bound, such that no datagrams arrive at the
+default buffer size.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     rcvbuf          : receive buffer size in bytes -- pass 0 to keep
+\param[in]     sndbuf          : send buffer size in bytes -- pass 0 to keep
+
+returns TRUE if all OK, FALSE if a buffer could not be set or was capped
+
+  ******************************************************************************/
+  int UDP_communication::
+  setUDPBufferSizes(int rcvbuf, int sndbuf)
+  {
+    int rc = TRUE;
+
+    if (rcvbuf > 0 && !setUDPBufferSize(SO_RCVBUFFORCE,SO_RCVBUF,rcvbuf))
+      rc = FALSE;
+
+    if (sndbuf > 0 && !setUDPBufferSize(SO_SNDBUFFORCE,SO_SNDBUF,sndbuf))
+      rc = FALSE;
+
+    return rc;
+  }
+
+  int UDP_communication::
+  setUDPBufferSize(int optForce, int opt, int size)
+  {
+    int       n;
+    socklen_t m;
+
+    // the kernel doubles the requested value to account for its bookkeeping;
+    // round up, such that an odd size is not read back one byte short
+    n = size/2 + size%2;
+    if (setsockopt(sFd, SOL_SOCKET, optForce, &n, sizeof(n)) == ERROR) {
+      if (errno != EPERM) {
+	logCommEvent(COMM_EV_UDP_BUFFER_ERROR,errno,sFd);
+	return FALSE;
+      }
+      if (setsockopt(sFd, SOL_SOCKET, opt, &n, sizeof(n)) == ERROR) {
+	logCommEvent(COMM_EV_UDP_BUFFER_ERROR,errno,sFd);
+	return FALSE;
+      }
+    }
+
+    m = sizeof(n);
+    getsockopt(sFd, SOL_SOCKET, opt, &n, &m);
+    if (n < size) {
+      logCommEvent(COMM_EV_UDP_BUFFER_LOW,0,n,size);
+      return FALSE;
+    }
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  getUDPBufferSizes
+\date  Oct 2026
+
+\remarks
+
+Returns the kernel receive and send buffer sizes of the socket.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[out]    rcvbuf          : receive buffer size in bytes
+\param[out]    sndbuf          : send buffer size in bytes
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  getUDPBufferSizes(int *rcvbuf, int *sndbuf)
+  {
+    socklen_t m;
+
+    m = sizeof(int);
+    if (getsockopt(sFd, SOL_SOCKET, SO_RCVBUF, rcvbuf, &m) == ERROR)
+      return FALSE;
+
+    m = sizeof(int);
+    if (getsockopt(sFd, SOL_SOCKET, SO_SNDBUF, sndbuf, &m) == ERROR)
+      return FALSE;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  autoTuneUDPBuffers
+\date  Oct 2026
+
+\remarks
+
+Sizes the receive and send buffers for a stream of datagrams, such that the
+receive buffer absorbs maxStall seconds in which the reader does not run
+(e.g., preemption or a page fault), and the send buffer holds a burst of the
+same duration. Buffers are only grown, never shrunk below the defaults.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     msgLen          : typical datagram size in bytes
+\param[in]     rate            : datagrams per second
+\param[in]     maxStall        : longest reader stall to absorb [s]
+
+returns TRUE if all OK, FALSE if the buffers could not be made large enough
+
+  ******************************************************************************/
+  int UDP_communication::
+  autoTuneUDPBuffers(int msgLen, double rate, double maxStall)
+  {
+    double size;
+    int    rcvbuf, sndbuf;
+
+    if (msgLen <= 0 || rate <= 0 || maxStall <= 0) {
+      printf("Error: invalid buffer tuning parameters\n");
+      return FALSE;
+    }
+
+    if (!getUDPBufferSizes(&rcvbuf,&sndbuf))
+      return FALSE;
+
+    size = (double) (msgLen + UDP_SKB_OVERHEAD) * rate * maxStall;
+    if (size > INT_MAX)
+      size = INT_MAX;
+
+    return setUDPBufferSizes(size > rcvbuf ? (int) size : 0,
+			     size > sndbuf ? (int) size : 0);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  setUDPDropCounting
+\date  Oct 2026
+
+\remarks
+
+Enables SO_RXQ_OVFL, such that the kernel reports with every received
+datagram how many datagrams the socket dropped so far, mostly due to a full
+receive buffer. The count is kept in nKernelDrops, and nDropEvents counts the
+receptions at which it increased. The plain and batched reads switch to
+recvmsg()/control messages while this is enabled.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     enable          : TRUE to count drops
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  setUDPDropCounting(int enable)
+  {
+
+    if (setsockopt(sFd, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable)) == ERROR) {
+      printf("Error: couldn't set SO_RXQ_OVFL (errno=%d)\n",errno);
+      return FALSE;
+    }
+
+    count_drops = enable;
+
+    return TRUE;
+
+  }
+
+  void UDP_communication::
+  countUDPDrops(uint32_t drops)
+  {
+    // the kernel count is cumulative and wraps at 32 bit
+    if (drops != (uint32_t) nKernelDrops) {
+      nKernelDrops += (uint32_t) (drops - (uint32_t) nKernelDrops);
+      ++nDropEvents;
+    }
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  checkUDPSocket
+\date  May 2004
+
+\remarks
+
+checks for available data in a socket. Note that depending on the unix system,
+this may return just the length of the next UDP package, or the amount of all
+UDP packages in the socket buffer.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+returns number of bytes available for reading
+
+  ******************************************************************************/
+  int UDP_communication::
+  checkUDPSocket(void)
+  {
+    int n_bytes;
+
+    if (!active) {
+      logCommEvent(COMM_EV_UDP_NOT_ACTIVE,0,sFd);
+      return FALSE;
+    }
+
+    ioctl(sFd, FIONREAD, (unsigned long) &n_bytes);
+
+    return n_bytes;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  getUDPSocketFd
+\date  Oct 2026
+
+\remarks
+
+returns the file descriptor of the socket, e.g., for use with epoll or
+io_uring based I/O engines
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+returns the socket file descriptor, or ERROR if the socket is not active
+
+  ******************************************************************************/
+  int UDP_communication::
+  getUDPSocketFd(void)
+  {
+    if (!active)
+      return ERROR;
+
+    return sFd;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  isUDPConnected
+\date  Oct 2026
+
+\remarks
+
+returns whether the socket is connected to a single peer, i.e., whether
+writeUDPSocket() or writeUDPSocketTo() needs to be used for replies
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+returns TRUE if the socket is connected, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  isUDPConnected(void)
+  {
+    return active && connected;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  closeUDPSocket
+\date  May 2004
+
+\remarks
+
+Closes a socket
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+none
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  closeUDPSocket(void)
+  {
+
+    if (!active) {
+      printf("Socket not initialized\n");
+      return FALSE;
+    }
+
+    active = FALSE;
+    connected = FALSE;
+    if (close(sFd) == ERROR)
+      return FALSE;
+    else
+      return TRUE;
+  }
+
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  writeUDPSocket
+\date  May 2004
+
+\remarks
+
+Write to a previously created socket.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     bufLen          : length of data buffer
+\param[in]     buf             : data buffer
+
+returns the number of bytes written
+
+  ******************************************************************************/
+  int UDP_communication::
+  writeUDPSocket(char *buf,
+		 int   bufLen)
+  {
+    int bufLenSent;
+    int sockAddrSize;
+
+    if (!active) {
+      logCommEvent(COMM_EV_UDP_NOT_ACTIVE,0,sFd);
+      return FALSE;
+    }
+
+    // send request to server -- connected sockets skip the address lookup
+    sockAddrSize = sizeof (struct sockaddr_in);
+    if (connected)
+      bufLenSent = send (sFd, (caddr_t) buf, bufLen, 0);
+    else
+      bufLenSent = sendto (sFd, (caddr_t) buf, bufLen, 0,
+			   (struct sockaddr *) &socketAddr, sockAddrSize);
+    if (bufLenSent == ERROR) {
+      logCommEvent(COMM_EV_UDP_WRITE_ERROR,errno,sFd);
+      return FALSE;
+    }
+
+    if (capture != NULL)
+      captureUDPPackets(UDP_CAPTURE_TX,buf,bufLenSent,bufLenSent,&socketAddr);
+
+    return bufLenSent;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  writeUDPSocketTo
+\date  Oct 2026
+
+\remarks
+
+Write to a given peer, e.g., a server replying to the endpoint returned by
+readUDPSocketFrom(). Must not be used on connected sockets.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     bufLen          : length of data buffer
+\param[in]     buf             : data buffer
+\param[in]     peer            : address and port of the receiver
+
+returns the number of bytes written
+
+  ******************************************************************************/
+  int UDP_communication::
+  writeUDPSocketTo(char              *buf,
+		   int                bufLen,
+		   const UDPEndpoint *peer)
+  {
+    struct sockaddr_in  peerAddr;
+    int                 bufLenSent;
+
+    if (!active) {
+      logCommEvent(COMM_EV_UDP_NOT_ACTIVE,0,sFd);
+      return FALSE;
+    }
+
+    bzero ((char *) &peerAddr, sizeof (struct sockaddr_in));
+    peerAddr.sin_family      = AF_INET;
+    peerAddr.sin_addr.s_addr = peer->addr;
+    peerAddr.sin_port        = peer->port;
+
+    if ((bufLenSent = sendto (sFd, (caddr_t) buf, bufLen, 0,
+			      (struct sockaddr *) &peerAddr,
+			      sizeof (struct sockaddr_in))) == ERROR) {
+      logCommEvent(COMM_EV_UDP_WRITE_ERROR,errno,sFd);
+      return FALSE;
+    }
+
+    if (capture != NULL)
+      captureUDPPackets(UDP_CAPTURE_TX,buf,bufLenSent,bufLenSent,&peerAddr);
+
+    return bufLenSent;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  writeUDPSocketV
+\date  Oct 2026
+
+\remarks
+
+Write one datagram that is gathered from several segments, e.g., a header, a
+payload, and a trailer in separate buffers, without copying them into one
+buffer first.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     iov             : the segments of the datagram
+\param[in]     iovcnt          : number of segments
+
+returns the number of bytes written
+
+  ******************************************************************************/
+  int UDP_communication::
+  writeUDPSocketV(const struct iovec *iov,
+		  int                 iovcnt)
+  {
+    return sendUDPMessageV(iov,iovcnt,connected ? NULL : &socketAddr);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  writeUDPSocketVTo
+\date  Oct 2026
+
+\remarks
+
+Like writeUDPSocketV(), but to a given peer as in writeUDPSocketTo(). Must
+not be used on connected sockets.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     iov             : the segments of the datagram
+\param[in]     iovcnt          : number of segments
+\param[in]     peer            : address and port of the receiver
+
+returns the number of bytes written
+
+  ******************************************************************************/
+  int UDP_communication::
+  writeUDPSocketVTo(const struct iovec *iov,
+		    int                 iovcnt,
+		    const UDPEndpoint  *peer)
+  {
+    struct sockaddr_in  peerAddr;
+
+    bzero ((char *) &peerAddr, sizeof (struct sockaddr_in));
+    peerAddr.sin_family      = AF_INET;
+    peerAddr.sin_addr.s_addr = peer->addr;
+    peerAddr.sin_port        = peer->port;
+
+    return sendUDPMessageV(iov,iovcnt,&peerAddr);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPSocketV
+\date  Oct 2026
+
+\remarks
+
+Read one datagram and scatter it over several segments, e.g., a header
+directly into a struct and the payload directly into the buffer of the
+application. The segments are filled in order; a datagram that is longer
+than all segments together is truncated.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     iov             : the segments to fill
+\param[in]     iovcnt          : number of segments
+\param[out]    peer            : address and port of the sender -- pass NULL
+                                  if not needed
+
+returns the length of the datagram, which exceeds the length of all segments
+if it was truncated, 0 if no data on a non-blocking socket, or ERROR
+
+  ******************************************************************************/
+  int UDP_communication::
+  readUDPSocketV(const struct iovec *iov,
+		 int                 iovcnt,
+		 UDPEndpoint        *peer)
+  {
+    UDPRecvInfo info;
+
+    return recvUDPMessageV(iov,iovcnt,MSG_TRUNC,peer,&info);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPSocketBatch
+\date  Oct 2026
+
+\remarks
+
+Reads as many datagrams as are available (up to n_msgs) with a single
+recvmmsg() call. On a blocking socket, the call waits for the first datagram
+and then returns whatever else is queued without blocking again. On a
+non-blocking socket, 0 is returned if nothing is available.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in,out] msgs            : array of message slots; buf and bufLen need
+                                  to be set, msgLen, addr, and truncated are
+                                  filled in for each received message
+\param[in]     n_msgs          : number of slots in msgs (at most UDP_MAX_BATCH
+                                  are used per call)
+
+returns the number of messages received, or ERROR
+
+  ******************************************************************************/
+  int UDP_communication::
+  readUDPSocketBatch(UDPMessage *msgs,
+		     int         n_msgs)
+  {
+    struct mmsghdr  hdrs[UDP_MAX_BATCH];
+    struct iovec    iovs[UDP_MAX_BATCH];
+    struct cmsghdr *cmsg;
+    char            control[UDP_MAX_BATCH][256];
+    int             n_received;
+    int             i;
+
+    if (!active) {
+      logCommEvent(COMM_EV_UDP_NOT_ACTIVE,0,sFd);
+      return ERROR;
+    }
+
+    if (!is_server && !connected) {
+      logCommEvent(COMM_EV_UDP_NOT_SERVER,0,sFd);
+      return ERROR;
+    }
+
+    if (n_msgs > UDP_MAX_BATCH)
+      n_msgs = UDP_MAX_BATCH;
+
+    bzero((char *) hdrs, n_msgs*sizeof(struct mmsghdr));
+    for (i=0; i<n_msgs; ++i) {
+      iovs[i].iov_base = msgs[i].buf;
+      iovs[i].iov_len  = msgs[i].bufLen;
+      hdrs[i].msg_hdr.msg_iov     = &iovs[i];
+      hdrs[i].msg_hdr.msg_iovlen  = 1;
+      hdrs[i].msg_hdr.msg_name    = &msgs[i].addr;
+      hdrs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+      if (count_drops) {
+	hdrs[i].msg_hdr.msg_control    = control[i];
+	hdrs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+      }
+    }
+
+    if ((n_received = recvmmsg(sFd, hdrs, n_msgs, MSG_WAITFORONE, NULL)) == ERROR) {
+      if (non_block && (errno==EAGAIN || errno==EWOULDBLOCK))
+	return 0;
+      else {
+	logCommEvent(COMM_EV_UDP_READ_ERROR,errno,sFd);
+	return ERROR;
+      }
+    }
+
+    for (i=0; i<n_received; ++i) {
+      msgs[i].msgLen    = hdrs[i].msg_len;
+      msgs[i].truncated = (hdrs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+      msgs[i].drops     = nKernelDrops;
+      // time stamps or GRO segment sizes may come along with the drop count
+      if (count_drops) {
+	for (cmsg = CMSG_FIRSTHDR(&hdrs[i].msg_hdr); cmsg != NULL;
+	     cmsg = CMSG_NXTHDR(&hdrs[i].msg_hdr, cmsg)) {
+	  if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+	    msgs[i].drops = *((uint32_t *) CMSG_DATA(cmsg));
+	    countUDPDrops(msgs[i].drops);
+	  }
+	}
+      }
+      if (capture != NULL)
+	captureUDPPackets(UDP_CAPTURE_RX,msgs[i].buf,msgs[i].msgLen,msgs[i].msgLen,
+			  &msgs[i].addr);
+    }
+
+    if (lock_on_peer && !connected && n_received > 0)
+      lockOnUDPPeer(&msgs[0].addr);
+
+    return n_received;
+
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  writeUDPSocketBatch
+\date  Oct 2026
+
+\remarks
+
+Writes n_msgs datagrams with a single sendmmsg() call. All messages go to the
+address of this socket, or to the peer of a connected socket.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in,out] msgs            : array of messages; buf and bufLen need to be
+                                  set, msgLen is filled in with the bytes sent
+\param[in]     n_msgs          : number of messages (at most UDP_MAX_BATCH
+                                  are sent per call)
+
+returns the number of messages sent, or ERROR
+
+  ******************************************************************************/
+  int UDP_communication::
+  writeUDPSocketBatch(UDPMessage *msgs,
+		      int         n_msgs)
+  {
+    struct mmsghdr  hdrs[UDP_MAX_BATCH];
+    struct iovec    iovs[UDP_MAX_BATCH];
+    int             n_sent;
+    int             i;
+
+    if (!active) {
+      logCommEvent(COMM_EV_UDP_NOT_ACTIVE,0,sFd);
+      return ERROR;
+    }
+
+    if (n_msgs > UDP_MAX_BATCH)
+      n_msgs = UDP_MAX_BATCH;
+
+    bzero((char *) hdrs, n_msgs*sizeof(struct mmsghdr));
+    for (i=0; i<n_msgs; ++i) {
+      iovs[i].iov_base = msgs[i].buf;
+      iovs[i].iov_len  = msgs[i].bufLen;
+      hdrs[i].msg_hdr.msg_iov     = &iovs[i];
+      hdrs[i].msg_hdr.msg_iovlen  = 1;
+      if (!connected) {
+	hdrs[i].msg_hdr.msg_name    = &socketAddr;
+	hdrs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+      }
+    }
+
+    if ((n_sent = sendmmsg(sFd, hdrs, n_msgs, 0)) == ERROR) {
+      logCommEvent(COMM_EV_UDP_WRITE_ERROR,errno,sFd);
+      return ERROR;
+    }
+
+    for (i=0; i<n_sent; ++i) {
+      msgs[i].msgLen = hdrs[i].msg_len;
+      if (capture != NULL)
+	captureUDPPackets(UDP_CAPTURE_TX,msgs[i].buf,msgs[i].msgLen,msgs[i].msgLen,
+			  &socketAddr);
+    }
+
+    return n_sent;
+
+  }
+  /*!*****************************************************************************
+*******************************************************************************
+\note  writeUDPSocketSegmented
+\date  Oct 2026
+
+\remarks
+
+Writes a buffer that consists of several datagrams of segSize bytes each (the
+last one may be shorter) with a single sendmsg() call. The kernel splits the
+buffer by UDP generic segmentation offload (GSO, Linux 4.18 or newer), which
+is much cheaper than sending each datagram by itself. At most 64 segments and
+64KB can be sent per call.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     buf             : data buffer
+\param[in]     bufLen          : length of data buffer
+\param[in]     segSize         : size of each datagram
+
+returns the number of bytes written
+
+  ******************************************************************************/
+  int UDP_communication::
+  writeUDPSocketSegmented(char *buf,
+			  int   bufLen,
+			  int   segSize)
+  {
+    struct msghdr   msg;
+    struct iovec    iov;
+    struct cmsghdr *cmsg;
+    char            control[CMSG_SPACE(sizeof(uint16_t))];
+    int             bufLenSent;
+
+    if (!active) {
+      logCommEvent(COMM_EV_UDP_NOT_ACTIVE,0,sFd);
+      return FALSE;
+    }
+
+    iov.iov_base = buf;
+    iov.iov_len  = bufLen;
+
+    bzero((char *) &msg, sizeof(msg));
+    bzero(control, sizeof(control));
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control;
+    msg.msg_controllen = sizeof(control);
+    if (!connected) {
+      msg.msg_name     = &socketAddr;
+      msg.msg_namelen  = sizeof(struct sockaddr_in);
+    }
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type  = UDP_SEGMENT;
+    cmsg->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+    *((uint16_t *) CMSG_DATA(cmsg)) = segSize;
+
+    if ((bufLenSent = sendmsg(sFd, &msg, 0)) == ERROR) {
+      logCommEvent(COMM_EV_UDP_WRITE_ERROR,errno,sFd);
+      return FALSE;
+    }
+
+    if (capture != NULL)
+      captureUDPPackets(UDP_CAPTURE_TX,buf,bufLenSent,segSize,&socketAddr);
+
+    return bufLenSent;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  setUDPGRO
+\date  Oct 2026
+
+\remarks
+
+Enables or disables UDP generic receive offload (GRO, Linux 5.0 or newer).
+With GRO, the kernel may coalesce several datagrams of the same flow and size
+into one buffer, which readUDPSocketSegmented() returns together with the
+segment size.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     enable          : TRUE to enable GRO
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  setUDPGRO(int enable)
+  {
+    if (!active) {
+      printf("Socket not initialized\n");
+      return FALSE;
+    }
+
+    if (setsockopt(sFd, SOL_UDP, UDP_GRO, &enable, sizeof(enable)) == ERROR) {
+      printf("Error: UDP GRO not supported (errno=%d)\n",errno);
+      return FALSE;
+    }
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPSocketSegmented
+\date  Oct 2026
+
+\remarks
+
+Reads from the socket like readUDPSocketFrom(), but also reports the segment
+size if the kernel coalesced several datagrams by GRO. In this case, buf
+contains consecutive datagrams of segSize bytes each, only the last one may be
+shorter. Without coalescing, segSize equals the number of bytes received. buf
+should be 64KB large to take full advantage of GRO.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     bufLen          : length of data buffer
+\param[out]    buf             : data buffer
+\param[out]    peer            : address and port of the sender -- pass NULL
+                                  if not needed
+\param[out]    segSize         : size of each datagram in buf
+
+returns the number of bytes received, 0 if no data on a non-blocking socket,
+or ERROR
+
+  ******************************************************************************/
+  int UDP_communication::
+  readUDPSocketSegmented(char        *buf,
+			 int          bufLen,
+			 UDPEndpoint *peer,
+			 int         *segSize)
+  {
+    UDPRecvInfo info;
+    int         bufLenReceived;
+
+    bufLenReceived = recvUDPMessage(buf,bufLen,peer,&info);
+    *segSize = info.segSize;
+
+    return bufLenReceived;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  setUDPTimestamping
+\date  Oct 2026
+
+\remarks
+
+Enables kernel (SO_TIMESTAMPING) time stamps of received and/or sent
+datagrams. Receive time stamps are returned by readUDPSocketTimestamped(),
+transmit time stamps are collected from the error queue with
+readUDPTxTimestamp(). Software time stamps are taken by the kernel when the
+datagram passes the network stack and work on any interface, including
+loopback. Hardware time stamps additionally require the NIC to be configured
+for time stamping (e.g., with hwstamp_ctl); if available, they are preferred.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     rx              : TRUE to time stamp received datagrams
+\param[in]     tx              : TRUE to time stamp sent datagrams
+\param[in]     hardware        : TRUE to request NIC time stamps as well
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  setUDPTimestamping(int rx, int tx, int hardware)
+  {
+    int flags = 0;
+
+    if (!active) {
+      printf("Socket not initialized\n");
+      return FALSE;
+    }
+
+    if (rx || tx)
+      flags |= SOF_TIMESTAMPING_SOFTWARE;
+    if ((rx || tx) && hardware)
+      flags |= SOF_TIMESTAMPING_RAW_HARDWARE;
+    if (rx)
+      flags |= SOF_TIMESTAMPING_RX_SOFTWARE
+	| (hardware ? SOF_TIMESTAMPING_RX_HARDWARE : 0);
+    if (tx)
+      flags |= SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_OPT_ID
+	| SOF_TIMESTAMPING_OPT_TSONLY
+	| (hardware ? SOF_TIMESTAMPING_TX_HARDWARE : 0);
+
+    if (setsockopt(sFd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == ERROR) {
+      printf("Error: could not enable time stamping (errno=%d)\n",errno);
+      return FALSE;
+    }
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPSocketTimestamped
+\date  Oct 2026
+
+\remarks
+
+Reads from the socket like readUDPSocketFrom(), and returns the kernel time
+stamp of the reception (CLOCK_REALTIME based). Requires setUDPTimestamping().
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     bufLen          : length of data buffer
+\param[out]    buf             : data buffer
+\param[out]    peer            : address and port of the sender -- pass NULL
+                                  if not needed
+\param[out]    rxTime          : receive time stamp, zero if none is available
+
+returns the number of bytes received, 0 if no data on a non-blocking socket,
+or ERROR
+
+  ******************************************************************************/
+  int UDP_communication::
+  readUDPSocketTimestamped(char            *buf,
+			   int              bufLen,
+			   UDPEndpoint     *peer,
+			   struct timespec *rxTime)
+  {
+    UDPRecvInfo info;
+    int         bufLenReceived;
+
+    bufLenReceived = recvUDPMessage(buf,bufLen,peer,&info);
+    *rxTime = info.rxTime;
+
+    return bufLenReceived;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPTxTimestamp
+\date  Oct 2026
+
+\remarks
+
+Collects one transmit time stamp from the error queue of the socket. This
+never blocks. The id counts the datagrams sent since time stamping was
+enabled, starting at 0, such that time stamps can be matched to datagrams.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[out]    id              : number of the datagram
+\param[out]    txTime          : transmit time stamp
+
+returns TRUE if a time stamp and its id were available, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  readUDPTxTimestamp(uint32_t        *id,
+		     struct timespec *txTime)
+  {
+    struct msghdr             msg;
+    struct cmsghdr           *cmsg;
+    struct scm_timestamping  *tss;
+    struct sock_extended_err *err;
+    char                      control[256];
+    bool                      found = FALSE;
+    bool                      has_id = FALSE;
+
+    if (!active) {
+      logCommEvent(COMM_EV_UDP_NOT_ACTIVE,0,sFd);
+      return FALSE;
+    }
+
+    bzero((char *) &msg, sizeof(msg));
+    msg.msg_control    = control;
+    msg.msg_controllen = sizeof(control);
+
+    if (recvmsg(sFd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == ERROR)
+      return FALSE;
+
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+	tss = (struct scm_timestamping *) CMSG_DATA(cmsg);
+	*txTime = (tss->ts[2].tv_sec || tss->ts[2].tv_nsec) ? tss->ts[2] : tss->ts[0];
+	found = TRUE;
+      } else if (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) {
+	err = (struct sock_extended_err *) CMSG_DATA(cmsg);
+	if (err->ee_errno == ENOMSG && err->ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+	  *id = err->ee_data;
+	  has_id = TRUE;
+	}
+      }
+    }
+
+    // a time stamp that cannot be matched to its datagram is of no use
+    return found && has_id;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  recvUDPMessage
+\date  Oct 2026
+
+\remarks
+
+Common recvmsg() based reading for all functions that need information from
+control messages (GRO segment size, time stamps, kernel drop count).
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     bufLen          : length of data buffer
+\param[out]    buf             : data buffer
+\param[out]    peer            : address and port of the sender -- pass NULL
+                                  if not needed
+\param[out]    info            : the control message information
+
+returns the number of bytes received, 0 if no data on a non-blocking socket,
+or ERROR
+
+  ******************************************************************************/
+  int UDP_communication::
+  recvUDPMessage(char        *buf,
+		 int          bufLen,
+		 UDPEndpoint *peer,
+		 UDPRecvInfo *info)
+  {
+    struct iovec iov;
+
+    iov.iov_base = buf;
+    iov.iov_len  = bufLen;
+
+    return recvUDPMessageV(&iov,1,0,peer,info);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  recvUDPMessageV
+\date  Oct 2026
+
+\remarks
+
+The recvmsg() call behind recvUDPMessage() and readUDPSocketV(), reading
+into a list of segments.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     iov             : the segments to fill
+\param[in]     iovcnt          : number of segments
+\param[in]     flags           : recvmsg() flags, e.g., MSG_TRUNC
+\param[out]    peer            : address and port of the sender -- pass NULL
+                                  if not needed
+\param[out]    info            : the control message information
+
+returns the number of bytes received, 0 if no data on a non-blocking socket,
+or ERROR
+
+  ******************************************************************************/
+  int UDP_communication::
+  recvUDPMessageV(const struct iovec *iov,
+		  int                 iovcnt,
+		  int                 flags,
+		  UDPEndpoint        *peer,
+		  UDPRecvInfo        *info)
+  {
+    struct msghdr            msg;
+    struct cmsghdr          *cmsg;
+    struct sockaddr_in       clientAddr;
+    struct scm_timestamping *tss;
+    char                     control[256];
+    int                      bufLenReceived;
+
+    bzero((char *) info, sizeof(UDPRecvInfo));
+
+    if (!active) {
+      logCommEvent(COMM_EV_UDP_NOT_ACTIVE,0,sFd);
+      return ERROR;
+    }
+
+    if (!is_server && !connected) {
+      logCommEvent(COMM_EV_UDP_NOT_SERVER,0,sFd);
+      return ERROR;
+    }
+
+    bzero((char *) &msg, sizeof(msg));
+    msg.msg_iov        = (struct iovec *) iov;
+    msg.msg_iovlen     = iovcnt;
+    msg.msg_name       = &clientAddr;
+    msg.msg_namelen    = sizeof(struct sockaddr_in);
+    msg.msg_control    = control;
+    msg.msg_controllen = sizeof(control);
+
+    if ((bufLenReceived = recvmsg(sFd, &msg, flags)) == ERROR) {
+      if (non_block && (errno==EAGAIN || errno==EWOULDBLOCK))
+	return 0;
+      else {
+	logCommEvent(COMM_EV_UDP_READ_ERROR,errno,sFd);
+	return ERROR;
+      }
+    }
+
+    if (lock_on_peer && !connected)
+      lockOnUDPPeer(&clientAddr);
+
+    if (peer != NULL) {
+      peer->addr = clientAddr.sin_addr.s_addr;
+      peer->port = clientAddr.sin_port;
+    }
+
+    info->segSize = bufLenReceived;
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+	info->segSize = *((int *) CMSG_DATA(cmsg));
+      } else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+	// ts[0] is the software, ts[2] the raw hardware time stamp
+	tss = (struct scm_timestamping *) CMSG_DATA(cmsg);
+	info->rxTime = (tss->ts[2].tv_sec || tss->ts[2].tv_nsec) ? tss->ts[2] : tss->ts[0];
+      } else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+	countUDPDrops(*((uint32_t *) CMSG_DATA(cmsg)));
+      }
+    }
+    info->drops = nKernelDrops;
+
+    if (capture != NULL) {
+      if (iovcnt == 1)
+	captureUDPPackets(UDP_CAPTURE_RX,(char *) iov[0].iov_base,
+			  bufLenReceived < (int) iov[0].iov_len ? bufLenReceived : iov[0].iov_len,
+			  info->segSize,&clientAddr);
+      else
+	captureUDPPacketV(UDP_CAPTURE_RX,iov,iovcnt,bufLenReceived,&clientAddr);
+    }
+
+    return bufLenReceived;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  sendUDPMessageV
+\date  Oct 2026
+
+\remarks
+
+The sendmsg() call behind writeUDPSocketV() and writeUDPSocketVTo().
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     iov             : the segments of the datagram
+\param[in]     iovcnt          : number of segments
+\param[in]     addr            : the receiver, or NULL on a connected socket
+
+returns the number of bytes written
+
+  ******************************************************************************/
+  int UDP_communication::
+  sendUDPMessageV(const struct iovec       *iov,
+		  int                       iovcnt,
+		  const struct sockaddr_in *addr)
+  {
+    struct msghdr msg;
+    int           bufLenSent;
+
+    if (!active) {
+      logCommEvent(COMM_EV_UDP_NOT_ACTIVE,0,sFd);
+      return FALSE;
+    }
+
+    bzero((char *) &msg, sizeof(msg));
+    msg.msg_iov     = (struct iovec *) iov;
+    msg.msg_iovlen  = iovcnt;
+    msg.msg_name    = (void *) addr;
+    msg.msg_namelen = addr != NULL ? sizeof(struct sockaddr_in) : 0;
+
+    if ((bufLenSent = sendmsg(sFd, &msg, 0)) == ERROR) {
+      logCommEvent(COMM_EV_UDP_WRITE_ERROR,errno,sFd);
+      return FALSE;
+    }
+
+    if (capture != NULL)
+      captureUDPPacketV(UDP_CAPTURE_TX,iov,iovcnt,bufLenSent,
+			addr != NULL ? addr : &socketAddr);
+
+    return bufLenSent;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  makeUDPServer
+\date  Jan 2016
+
+\remarks
+
+Converts the current client socket to become a server
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     socketPortNum     : which port to use
+\param[in]     serverName        : name or IP address of server -- pass "" to use
+localhost
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  makeUDPServer(int socketPortNum, char *serverName)
+
+  {
+
+    int            	sockAddrSize;   // size of socket address structure
+    unsigned int   	opts;           // socket options
+    unsigned int	n,m;
+
+    // if something goes wrong, the socket is inactive
+    if (active) {
+      printf("socket is already active as server socket\n");
+      return FALSE;
+    }
+
+    // set up the local address
+    sockAddrSize = sizeof (struct sockaddr_in);
+    bzero ((char *) &socketAddr, sockAddrSize);
+    socketAddr.sin_family  = AF_INET;
+    socketAddr.sin_port    = htons (socketPortNum);
+
+    if (strcmp(serverName,"")==0) {
+      // use localhost as server
+      socketAddr.sin_addr.s_addr = htonl (INADDR_ANY);
+    } else {
+      // determine server from serverName
+      struct hostent *host_ent;
+      struct in_addr *addr_ptr;
+
+      if ((host_ent = (struct hostent *) gethostbyname (serverName)) == NULL) {
+	if ((socketAddr.sin_addr.s_addr = inet_addr(serverName)) == (unsigned int) ERROR) {
+	  printf("Error: unknown server name\n");
+	  return FALSE;
+	}
+      } else {
+	addr_ptr = (struct in_addr *) *host_ent->h_addr_list;
+	serverName = inet_ntoa (*addr_ptr);
+	socketAddr.sin_addr.s_addr = inet_addr(serverName);
+      }
+    }
+
+    // bind socket to local address
+    if (bind (sFd, (struct sockaddr *) &socketAddr, sockAddrSize) == ERROR) {
+      printf("Error: couldn't bind to socket address (errno=%d)\n",errno);
+      return FALSE;
+    }
+
+    is_server = TRUE;
+    active = TRUE;
+
+    return TRUE;
+
+  }
+
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  makeUDPClient
+\date  Jan 2016
+
+\remarks
+
+Specifies client specific information
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     socketPortNum     : which port to use
+\param[in]     clientName        : name or IP address of client -- pass "" to use
+localhost
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  makeUDPClient(int socketPortNum, char *clientName)
+
+  {
+
+    int            	sockAddrSize;   // size of socket address structure
+    unsigned int   	opts;           // socket options
+    unsigned int	n,m;
+
+    // if something goes wrong, the socket is inactive
+    active = FALSE;
+    is_server = FALSE;
+    connected = FALSE;
+    lock_on_peer = FALSE;
+
+    // set up the local address
+    sockAddrSize = sizeof (struct sockaddr_in);
+    bzero ((char *) &socketAddr, sockAddrSize);
+    socketAddr.sin_family  = AF_INET;
+    socketAddr.sin_port    = htons (socketPortNum);
+
+    if (strcmp(clientName,"")==0) {
+      // use localhost as server
+      socketAddr.sin_addr.s_addr = htonl (INADDR_ANY);
+    } else {
+      // determine server from clientName
+      struct hostent *host_ent;
+      struct in_addr *addr_ptr;
+
+      if ((host_ent = (struct hostent *) gethostbyname (clientName)) == NULL) {
+	if ((socketAddr.sin_addr.s_addr = inet_addr(clientName)) == (unsigned int) ERROR) {
+	  printf("Error: unknown server name\n");
+	  return FALSE;
+	}
+      } else {
+	addr_ptr = (struct in_addr *) *host_ent->h_addr_list;
+	clientName = inet_ntoa (*addr_ptr);
+	socketAddr.sin_addr.s_addr = inet_addr(clientName);
+      }
+    }
+
+    active = TRUE;
+
+    return TRUE;
+
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  makeUDPConnectedClient
+\date  Oct 2026
+
+\remarks
+
+Like makeUDPClient(), but the socket is connected to the server once, such
+that writeUDPSocket() uses send() instead of sendto(), and the kernel does not
+need to resolve the route and build the destination address for every
+packet. A connected client can also read the replies of its server.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     socketPortNum     : which port to use
+\param[in]     clientName        : name or IP address of server -- pass "" to use
+localhost
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  makeUDPConnectedClient(int socketPortNum, char *clientName)
+
+  {
+
+    if (!makeUDPClient(socketPortNum,clientName))
+      return FALSE;
+
+    if (connect(sFd, (struct sockaddr *) &socketAddr, sizeof(struct sockaddr_in)) == ERROR) {
+      printf("Error: couldn't connect socket (errno=%d)\n",errno);
+      active = FALSE;
+      return FALSE;
+    }
+
+    connected = TRUE;
+
+    return TRUE;
+
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  makeUDPConnectedServer
+\date  Oct 2026
+
+\remarks
+
+Like makeUDPServer(), but the socket gets connected to the first peer it
+receives data from. After that, datagrams from other peers are discarded by
+the kernel, and writeUDPSocket() sends to this peer with send().
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     serverPortNum     : which port to use
+\param[in]     serverName        : name or IP address of server -- pass "" to use
+localhost
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  makeUDPConnectedServer(int serverPortNum, char *serverName)
+
+  {
+
+    if (!makeUDPServer(serverPortNum,serverName))
+      return FALSE;
+
+    connected = FALSE;
+    lock_on_peer = TRUE;
+
+    return TRUE;
+
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  makeUDPMulticastPublisher
+\date  Oct 2026
+
+\remarks
+
+Makes a client socket that sends to a multicast group, such that a single
+writeUDPSocket() reaches every subscriber of the group. The socket is
+connected to the group, as in makeUDPConnectedClient().
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     socketPortNum     : which port to use
+\param[in]     groupName         : IP address of the multicast group,
+                                   e.g., "239.255.0.1"
+\param[in]     interfaceName     : name (e.g., "eth0") or IP address of the
+                                   outgoing interface -- pass "" for the
+                                   default route
+\param[in]     ttl               : max. number of router hops (1 = local
+                                   network only)
+\param[in]     loopback          : TRUE if subscribers on the same host should
+                                   receive the datagrams
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  makeUDPMulticastPublisher(int socketPortNum, char *groupName, char *interfaceName,
+			    int ttl, int loopback)
+
+  {
+
+    if (!IN_MULTICAST(ntohl(inet_addr(groupName)))) {
+      printf("Error: %s is not a multicast address\n",groupName);
+      return FALSE;
+    }
+
+    if (!setUDPMulticastInterface(interfaceName) ||
+	!setUDPMulticastTTL(ttl) ||
+	!setUDPMulticastLoopback(loopback))
+      return FALSE;
+
+    return makeUDPConnectedClient(socketPortNum,groupName);
+
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  makeUDPMulticastSubscriber
+\date  Oct 2026
+
+\remarks
+
+Makes a server socket that receives the datagrams of a multicast group. The
+address is bound with SO_REUSEADDR, such that several subscribers on the same
+host can receive the same group and port. Further groups can be added with
+joinUDPMulticastGroup().
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     serverPortNum     : which port to use
+\param[in]     groupName         : IP address of the multicast group
+\param[in]     interfaceName     : name or IP address of the interface to
+                                   receive on -- pass "" to let the kernel
+                                   choose
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  makeUDPMulticastSubscriber(int serverPortNum, char *groupName, char *interfaceName)
+
+  {
+    int opt = TRUE;
+
+    if (setsockopt(sFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == ERROR) {
+      printf("Error: couldn't set SO_REUSEADDR (errno=%d)\n",errno);
+      return FALSE;
+    }
+
+    // binding to the group address filters out unicast datagrams to this port
+    if (!makeUDPServer(serverPortNum,groupName))
+      return FALSE;
+
+    // only deliver groups that this socket joined, not those of other sockets
+    opt = FALSE;
+    setsockopt(sFd, IPPROTO_IP, IP_MULTICAST_ALL, &opt, sizeof(opt));
+
+    if (!joinUDPMulticastGroup(groupName,interfaceName)) {
+      active = FALSE;
+      return FALSE;
+    }
+
+    return TRUE;
+
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  getUDPInterface
+\date  Oct 2026
+
+\remarks
+
+Fills a multicast request with an interface given by name or IP address.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     interfaceName     : name or IP address of the interface, or ""
+\param[out]    mreq              : the request structure
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  static int
+  getUDPInterface(char *interfaceName, struct ip_mreqn *mreq)
+  {
+    bzero((char *) mreq, sizeof(struct ip_mreqn));
+    mreq->imr_address.s_addr = htonl(INADDR_ANY);
+
+    if (interfaceName == NULL || strcmp(interfaceName,"")==0)
+      return TRUE;
+
+    if (inet_pton(AF_INET, interfaceName, &mreq->imr_address) == 1)
+      return TRUE;
+
+    if ((mreq->imr_ifindex = if_nametoindex(interfaceName)) == 0) {
+      printf("Error: unknown interface %s\n",interfaceName);
+      return FALSE;
+    }
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  joinUDPMulticastGroup
+\date  Oct 2026
+
+\remarks
+
+Subscribes the socket to a multicast group. The socket needs to be bound to
+the port of the group (makeUDPServer() with "" as server name, or
+makeUDPMulticastSubscriber()).
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     groupName         : IP address of the multicast group
+\param[in]     interfaceName     : name or IP address of the interface -- pass
+                                   "" to let the kernel choose
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  joinUDPMulticastGroup(char *groupName, char *interfaceName)
+  {
+    struct ip_mreqn mreq;
+
+    if (!getUDPInterface(interfaceName,&mreq))
+      return FALSE;
+
+    if (inet_pton(AF_INET, groupName, &mreq.imr_multiaddr) != 1 ||
+	!IN_MULTICAST(ntohl(mreq.imr_multiaddr.s_addr))) {
+      printf("Error: %s is not a multicast address\n",groupName);
+      return FALSE;
+    }
+
+    if (setsockopt(sFd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) == ERROR) {
+      printf("Error: couldn't join multicast group %s (errno=%d)\n",groupName,errno);
+      return FALSE;
+    }
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  leaveUDPMulticastGroup
+\date  Oct 2026
+
+\remarks
+
+Unsubscribes the socket from a multicast group.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     groupName         : IP address of the multicast group
+\param[in]     interfaceName     : interface as given to joinUDPMulticastGroup()
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  leaveUDPMulticastGroup(char *groupName, char *interfaceName)
+  {
+    struct ip_mreqn mreq;
+
+    if (!getUDPInterface(interfaceName,&mreq))
+      return FALSE;
+
+    if (inet_pton(AF_INET, groupName, &mreq.imr_multiaddr) != 1) {
+      printf("Error: %s is not a multicast address\n",groupName);
+      return FALSE;
+    }
+
+    if (setsockopt(sFd, IPPROTO_IP, IP_DROP_MEMBERSHIP, &mreq, sizeof(mreq)) == ERROR) {
+      printf("Error: couldn't leave multicast group %s (errno=%d)\n",groupName,errno);
+      return FALSE;
+    }
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  setUDPMulticastInterface
+\date  Oct 2026
+
+\remarks
+
+Selects the interface that outgoing multicast datagrams are sent on.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     interfaceName     : name or IP address of the interface -- pass
+                                   "" for the default route
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  setUDPMulticastInterface(char *interfaceName)
+  {
+    struct ip_mreqn mreq;
+
+    if (!getUDPInterface(interfaceName,&mreq))
+      return FALSE;
+
+    if (setsockopt(sFd, IPPROTO_IP, IP_MULTICAST_IF, &mreq, sizeof(mreq)) == ERROR) {
+      printf("Error: couldn't set multicast interface (errno=%d)\n",errno);
+      return FALSE;
+    }
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  setUDPMulticastTTL
+\date  Oct 2026
+
+\remarks
+
+Sets how many router hops outgoing multicast datagrams may take; 1 keeps them
+in the local network.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     ttl               : time to live (0 ... 255)
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDP_communication::
+  setUDPMulticastTTL(int ttl)
+  {
+    if (setsockopt(sFd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) == ERROR) {
+      printf("Error: couldn't set multicast TTL (errno=%d)\n",errno);
+      return FALSE;
+    }
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  setUDPMulticastLoopback
+\date  Oct 2026
+
+\remarks
+
+Determines whether outgoing multicast datagrams are also delivered to
+subscribers on the sending host.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     loopback          : TRUE to deliver locally
 
-    if (!active) {
-      printf("Socket not initialized\n");
-      return FALSE;
-    }
+returns TRUE if all OK, otherwise FALSE
 
-    if (!is_server) {
-      printf("This is not a server socket\n");
+  ******************************************************************************/
+  int UDP_communication::
+  setUDPMulticastLoopback(int loopback)
+  {
+    if (setsockopt(sFd, IPPROTO_IP, IP_MULTICAST_LOOP, &loopback, sizeof(loopback)) == ERROR) {
+      printf("Error: couldn't set multicast loopback (errno=%d)\n",errno);
       return FALSE;
     }
 
-    // read data
-    sockAddrSize = sizeof (struct sockaddr_in);
-    if ((bufLenReceived = recvfrom (sFd, buf, bufLen, 0,
-				    (struct sockaddr *) &clientAddr,
-				    &sockAddrSize)) == ERROR) {
+    return TRUE;
+  }
 
-      if (non_block && (errno==EAGAIN || errno==EWOULDBLOCK))
-	return 0;
-      else {
-	printf("Error when reading from socket\n");
-	return FALSE;
-      }
-    }
+  /*!*****************************************************************************
+*******************************************************************************
+\note  setUDPCapture
+\date  Oct 2026
 
-    // convert inet address to dot notation
-    if (inetAddr != NULL) {
-      inetAddrTemp = inet_ntoa (clientAddr.sin_addr);
-      strcpy(inetAddr,inetAddrTemp);
-    }
+\remarks
 
-    return bufLenReceived;
+Attaches a capture that records every datagram read from or written to this
+socket, or detaches it. Several sockets can share one capture.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
 
+\param[in]     capture         : an open capture, or NULL to stop recording
+
+  ******************************************************************************/
+  void UDP_communication::
+  setUDPCapture(UDPCapture *capture)
+  {
+    this->capture = capture;
   }
 
   /*!*****************************************************************************
 *******************************************************************************
-\note  setUDPBlocking
-\date  May 2004
+\note  captureUDPPackets
+\date  Oct 2026
 
 \remarks
 
-Set (or unsets) the blocking status of a socket.
+Records a buffer of one or several datagrams of segSize bytes each (GSO/GRO).
 
 *******************************************************************************
 Function Parameters: [in]=input,[out]=output
 
-\param [in]   do_not_block: FALSE for a blocking socket, TRUE for non blocking
-
-returns number of bytes available for reading
+\param[in]     direction       : UDP_CAPTURE_RX or UDP_CAPTURE_TX
+\param[in]     buf             : the datagrams
+\param[in]     len             : length of buf
+\param[in]     segSize         : size of each datagram
+\param[in]     addr            : the peer
 
   ******************************************************************************/
   void UDP_communication::
-  setUDPNonBlocking(int do_not_block)
+  captureUDPPackets(int                       direction,
+		    const char               *buf,
+		    int                       len,
+		    int                       segSize,
+		    const struct sockaddr_in *addr)
   {
+    UDPEndpoint peer;
 
-    if (!active) {
-      printf("Socket not initialized\n");
-      return;
-    }
+    peer.addr = addr->sin_addr.s_addr;
+    peer.port = addr->sin_port;
 
-    ioctl(sFd,FIONBIO,(unsigned long) (&do_not_block));
-    non_block = do_not_block;
+    if (segSize <= 0)
+      segSize = len;
 
+    for (int pos=0; pos<len; pos+=segSize)
+      capture->recordUDPPacket(direction, buf+pos,
+			       len-pos < segSize ? len-pos : segSize, &peer);
   }
 
   /*!*****************************************************************************
 *******************************************************************************
-\note  checkUDPSocket
-\date  May 2004
+\note  captureUDPPacketV
+\date  Oct 2026
 
 \remarks
 
-checks for available data in a socket. Note that depending on the unix system,
-this may return just the length of the next UDP package, or the amount of all
-UDP packages in the socket buffer.
+Records a datagram that is scattered over several segments.
 
 *******************************************************************************
 Function Parameters: [in]=input,[out]=output
 
-none
-
-returns number of bytes available for reading
+\param[in]     direction       : UDP_CAPTURE_RX or UDP_CAPTURE_TX
+\param[in]     iov             : the segments of the datagram
+\param[in]     iovcnt          : number of segments
+\param[in]     len             : length of the datagram
+\param[in]     addr            : the peer
 
   ******************************************************************************/
-  int UDP_communication::
-  checkUDPSocket(void)
+  void UDP_communication::
+  captureUDPPacketV(int                       direction,
+		    const struct iovec       *iov,
+		    int                       iovcnt,
+		    int                       len,
+		    const struct sockaddr_in *addr)
   {
-    int n_bytes;
-
-    if (!active) {
-      printf("Socket not initialized\n");
-      return FALSE;
-    }
+    UDPEndpoint peer;
 
-    ioctl(sFd, FIONREAD, (unsigned long) &n_bytes);
+    peer.addr = addr->sin_addr.s_addr;
+    peer.port = addr->sin_port;
 
-    return n_bytes;
+    capture->recordUDPPacketV(direction, iov, iovcnt, len, &peer);
   }
 
   /*!*****************************************************************************
 *******************************************************************************
-\note  closeUDPSocket
-\date  May 2004
+\note  lockOnUDPPeer
+\date  Oct 2026
 
 \remarks
 
-Closes a socket
+Connects a server socket to the given peer.
 
 *******************************************************************************
 Function Parameters: [in]=input,[out]=output
 
-none
+\param[in]     peerAddr          : address of the peer
 
 returns TRUE if all OK, otherwise FALSE
 
   ******************************************************************************/
   int UDP_communication::
-  closeUDPSocket(void)
+  lockOnUDPPeer(struct sockaddr_in *peerAddr)
+
   {
 
-    if (!active) {
-      printf("Socket not initialized\n");
+    if (connect(sFd, (struct sockaddr *) peerAddr, sizeof(struct sockaddr_in)) == ERROR) {
+      printf("Error: couldn't connect to peer (errno=%d)\n",errno);
       return FALSE;
     }
 
-    active = FALSE;
-    if (close(sFd) == ERROR)
-      return FALSE;
-    else
-      return TRUE;
-  }
+    socketAddr = *peerAddr;
+    connected = TRUE;
 
+    return TRUE;
+
+  }
 
   /*!*****************************************************************************
 *******************************************************************************
-\note  writeUDPSocket
-\date  May 2004
+\note  UDPPeerTable
+\date  Oct 2026
 
 \remarks
 
-Write to a previously created socket.
+A small open-addressing hash table that maps peer endpoints to stable integer
+ids 0,1,2,..., such that multi-client servers can index per-peer state
+directly. The table is not thread-safe, and entries are never removed.
 
 *******************************************************************************
 Function Parameters: [in]=input,[out]=output
 
-\param[in]     bufLen          : length of data buffer
-\param[in]     buf             : data buffer
-
-returns the number of bytes written
+\param[in]     max_peers       : max. number of peers
 
   ******************************************************************************/
-  int UDP_communication::
-  writeUDPSocket(char *buf,
-		 int   bufLen)
+  UDPPeerTable::
+  UDPPeerTable(int max_peers)
   {
-    int bufLenSent;
-    int sockAddrSize;
+    maxPeers = max_peers;
+    nPeers   = 0;
+
+    // keep the load factor at or below 0.5
+    capacity = 1;
+    while (capacity < 2*max_peers)
+      capacity <<= 1;
+
+    slots = new int[capacity];
+    peers = new UDPEndpoint[max_peers];
+    for (int i=0; i<capacity; ++i)
+      slots[i] = ERROR;
+  }
 
-    if (!active) {
-      printf("Socket not initialized\n");
-      return FALSE;
-    }
+  UDPPeerTable::
+  ~UDPPeerTable()
+  {
+    delete [] slots;
+    delete [] peers;
+  }
 
-    // send request to server
-    sockAddrSize = sizeof (struct sockaddr_in);
-    if ((bufLenSent = sendto (sFd, (caddr_t) buf, bufLen, 0,
-			      (struct sockaddr *) &socketAddr, sockAddrSize)) == ERROR) {
-      printf("Error: could not write to socket\n");
-      return FALSE;
-    }
+  // the slot of peer, or of the empty slot where it would be inserted
+  int UDPPeerTable::
+  findSlot(const UDPEndpoint *peer)
+  {
+    uint64_t key;
+    int      i;
 
-    return bufLenSent;
+    key = ((uint64_t) peer->addr << 16) | peer->port;
+    i   = (int) ((key * 0x9E3779B97F4A7C15ULL) >> 40) & (capacity - 1);
+
+    while (slots[i] != ERROR &&
+	   (peers[slots[i]].addr != peer->addr || peers[slots[i]].port != peer->port))
+      i = (i + 1) & (capacity - 1);
+
+    return i;
   }
+
   /*!*****************************************************************************
 *******************************************************************************
-\note  makeUDPServer
-\date  Jan 2016
+\note  getPeerId
+\date  Oct 2026
 
 \remarks
 
-Converts the current client socket to become a server
+Returns the id of peer, and assigns a new id if the peer is not known yet.
 
 *******************************************************************************
 Function Parameters: [in]=input,[out]=output
 
-\param[in]     socketPortNum     : which port to use
-\param[in]     serverName        : name or IP address of server -- pass "" to use
-localhost
+\param[in]     peer            : the peer endpoint
 
-returns TRUE if all OK, otherwise FALSE
+returns the peer id, or ERROR if the table is full
 
   ******************************************************************************/
-  int UDP_communication::
-  makeUDPServer(int socketPortNum, char *serverName)
-
+  int UDPPeerTable::
+  getPeerId(const UDPEndpoint *peer)
   {
+    int i;
 
-    int            	sockAddrSize;   // size of socket address structure
-    unsigned int   	opts;           // socket options
-    unsigned int	n,m;
+    i = findSlot(peer);
+    if (slots[i] != ERROR)
+      return slots[i];
 
-    // if something goes wrong, the socket is inactive
-    if (active) {
-      printf("socket is already active as server socket\n");
-      return FALSE;
-    }
+    if (nPeers >= maxPeers)
+      return ERROR;
 
-    // set up the local address
-    sockAddrSize = sizeof (struct sockaddr_in);
-    bzero ((char *) &socketAddr, sockAddrSize);
-    socketAddr.sin_family  = AF_INET;
-    socketAddr.sin_port    = htons (socketPortNum);
+    peers[nPeers] = *peer;
+    slots[i] = nPeers;
 
-    if (strcmp(serverName,"")==0) {
-      // use localhost as server
-      socketAddr.sin_addr.s_addr = htonl (INADDR_ANY);
-    } else {
-      // determine server from serverName
-      struct hostent *host_ent;
-      struct in_addr *addr_ptr;
+    return nPeers++;
+  }
 
-      if ((host_ent = (struct hostent *) gethostbyname (serverName)) == NULL) {
-	if ((socketAddr.sin_addr.s_addr = inet_addr(serverName)) == (unsigned int) ERROR) {
-	  printf("Error: unknown server name\n");
-	  return FALSE;
-	}
-      } else {
-	addr_ptr = (struct in_addr *) *host_ent->h_addr_list;
-	serverName = inet_ntoa (*addr_ptr);
-	socketAddr.sin_addr.s_addr = inet_addr(serverName);
-      }
-    }
+  /*!*****************************************************************************
+*******************************************************************************
+\note  findPeerId
+\date  Oct 2026
 
-    // bind socket to local address
-    if (bind (sFd, (struct sockaddr *) &socketAddr, sockAddrSize) == ERROR) {
-      printf("Error: couldn't bind to socket address (errno=%d)\n",errno);
-      return FALSE;
-    }
+\remarks
 
-    is_server = TRUE;
-    active = TRUE;
+Looks up the id of peer without inserting it.
 
-    return TRUE;
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
 
-  }
+\param[in]     peer            : the peer endpoint
+
+returns the peer id, or ERROR if the peer is unknown
 
+  ******************************************************************************/
+  int UDPPeerTable::
+  findPeerId(const UDPEndpoint *peer)
+  {
+    return slots[findSlot(peer)];
+  }
 
   /*!*****************************************************************************
 *******************************************************************************
-\note  makeUDPClient
-\date  Jan 2016
+\note  getPeerEndpoint
+\date  Oct 2026
 
 \remarks
 
-Specifies client specific information
+Returns the endpoint that belongs to a peer id.
 
 *******************************************************************************
 Function Parameters: [in]=input,[out]=output
 
-\param[in]     socketPortNum     : which port to use
-\param[in]     clientName        : name or IP address of client -- pass "" to use
-localhost
+\param[in]     id              : the peer id
+\param[out]    peer            : the peer endpoint
 
 returns TRUE if all OK, otherwise FALSE
 
   ******************************************************************************/
-  int UDP_communication::
-  makeUDPClient(int socketPortNum, char *clientName)
-
+  int UDPPeerTable::
+  getPeerEndpoint(int id, UDPEndpoint *peer)
   {
+    if (id < 0 || id >= nPeers)
+      return FALSE;
 
-    int            	sockAddrSize;   // size of socket address structure
-    unsigned int   	opts;           // socket options
-    unsigned int	n,m;
-
-    // if something goes wrong, the socket is inactive
-    active = FALSE;
-    is_server = FALSE;
-
-    // set up the local address
-    sockAddrSize = sizeof (struct sockaddr_in);
-    bzero ((char *) &socketAddr, sockAddrSize);
-    socketAddr.sin_family  = AF_INET;
-    socketAddr.sin_port    = htons (socketPortNum);
-
-    if (strcmp(clientName,"")==0) {
-      // use localhost as server
-      socketAddr.sin_addr.s_addr = htonl (INADDR_ANY);
-    } else {
-      // determine server from clientName
-      struct hostent *host_ent;
-      struct in_addr *addr_ptr;
-
-      if ((host_ent = (struct hostent *) gethostbyname (clientName)) == NULL) {
-	if ((socketAddr.sin_addr.s_addr = inet_addr(clientName)) == (unsigned int) ERROR) {
-	  printf("Error: unknown server name\n");
-	  return FALSE;
-	}
-      } else {
-	addr_ptr = (struct in_addr *) *host_ent->h_addr_list;
-	clientName = inet_ntoa (*addr_ptr);
-	socketAddr.sin_addr.s_addr = inet_addr(clientName);
-      }
-    }
-
-    active = TRUE;
+    *peer = peers[id];
 
     return TRUE;
-
   }
 
   /*!*****************************************************************************
@@ -510,18 +2337,20 @@ Function Parameters: [in]=input,[out]=output
     union {
       char cbuf[CBUFLEN];
       int  ibuf[IBUFLEN];
-    } buf;
+    } buf, bufs[UDP_MAX_BATCH];
 
-    int  i;
+    int  i,j;
     int  n_bytes;
-    int  n_bytes_ready;
+    int  n_msgs;
     int  count_packages=0;
+    int  count_batches=0;
     int  error_packages=0;
     int  expected_message = 1;
-    double average_ready_size=0;
+    double average_batch_size=0;
     double average_message_size = 0;
-    struct timespec ns;
     int save_sys_clk_rate;
+    UDPMessage msgs[UDP_MAX_BATCH];
+    struct pollfd fds[2];
     UDP_communication udp;
 
     udp.makeUDPServer(TESTPORTSERVER,name);
@@ -532,6 +2361,16 @@ Function Parameters: [in]=input,[out]=output
       return;
     }
 
+    // report datagrams dropped by the kernel
+    udp.setUDPDropCounting(TRUE);
+
+    // drain the socket with batched, non-blocking reads
+    udp.setUDPNonBlocking(TRUE);
+    for (j=0; j<UDP_MAX_BATCH; ++j) {
+      msgs[j].buf    = bufs[j].cbuf;
+      msgs[j].bufLen = CBUFLEN;
+    }
+
     // receive message until user hits keyboard
     printf("Hit any key to terminate server ....");
     fflush(stdout);
@@ -546,26 +2385,38 @@ Function Parameters: [in]=input,[out]=output
 
     while (buf.ibuf[0] != -1) {
 
-      // read data as much as available
-      while ((n_bytes_ready=udp.checkUDPSocket())) {
-	n_bytes = udp.readUDPSocket(buf.cbuf,CBUFLEN,NULL);
-	average_message_size += n_bytes;
-	++count_packages;
-	if (expected_message != buf.ibuf[0] && buf.ibuf[0] != -1) {
-	  ++error_packages;
-	  printf("\n%d != %d (expected)",buf.ibuf[0],expected_message);
-	  expected_message = buf.ibuf[0];
+      // read data as much as available, one system call per batch, and
+      // stop at the termination message
+      while (buf.ibuf[0] != -1 &&
+	     (n_msgs=udp.readUDPSocketBatch(msgs,UDP_MAX_BATCH)) > 0) {
+	++count_batches;
+	average_batch_size += n_msgs;
+	for (j=0; j<n_msgs; ++j) {
+	  buf.ibuf[0] = bufs[j].ibuf[0];
+	  average_message_size += msgs[j].msgLen;
+	  ++count_packages;
+	  if (expected_message != buf.ibuf[0] && buf.ibuf[0] != -1) {
+	    ++error_packages;
+	    printf("\n%d != %d (expected)",buf.ibuf[0],expected_message);
+	    expected_message = buf.ibuf[0];
+	  }
+	  ++expected_message;
+	  if (buf.ibuf[0] == -1)
+	    break;
 	}
-	++expected_message;
-
-	average_ready_size += n_bytes_ready;
       }
 
-      // wait a moment for new data
+      // termination message received
+      if (buf.ibuf[0] == -1)
+	break;
+
+      // wait for new data or keyboard input instead of polling
       if (USE_SLEEP) {
-	ns.tv_sec=0;
-	ns.tv_nsec=10000;
-	nanosleep(&ns,NULL);
+	fds[0].fd = udp.getUDPSocketFd();
+	fds[0].events = POLLIN;
+	fds[1].fd = 0;
+	fds[1].events = POLLIN;
+	poll(fds,2,-1);
       }
 
       // check for keyboard interaction
@@ -575,10 +2426,10 @@ Function Parameters: [in]=input,[out]=output
 
     }
 
-    if (count_packages > 0) {
+    if (count_packages > 0)
       average_message_size /= (double) count_packages;
-      average_ready_size  /= (double) count_packages;
-    }
+    if (count_batches > 0)
+      average_batch_size /= (double) count_batches;
 
     // close down the server
     udp.closeUDPSocket();
@@ -587,8 +2438,9 @@ Function Parameters: [in]=input,[out]=output
     printf("Package Statistics:\n");
     printf("     received          : %d\n",count_packages);
     printf("     errors            : %d\n",error_packages);
+    printf("     kernel drops      : %lu\n",udp.nKernelDrops);
     printf("     ave.message size  : %f\n",average_message_size);
-    printf("     ave.ready size    : %f\n",average_ready_size);
+    printf("     ave.batch size    : %f\n",average_batch_size);
 
   }
 
@@ -602,9 +2454,9 @@ Function Parameters: [in]=input,[out]=output
 
     int i,j;
     int count=0;
-    struct timespec ns;
     int save_sys_clk_rate;
     UDP_communication udp;
+    UDPPacedSender    pacer;
 
     udp.makeUDPClient(TESTPORTCLIENT,name);
 
@@ -614,20 +2466,25 @@ Function Parameters: [in]=input,[out]=output
       return;
     }
 
+    // send at 1kHz on absolute deadlines
+    pacer.initUDPPacer(&udp,1000.0);
+
     while (count <  n_bytes) {
       buf.ibuf[0] = ++count;
+
+      // wait for the next period
+      if (USE_SLEEP)
+	pacer.waitUDPPacer();
+
       if (udp.writeUDPSocket(buf.cbuf,CBUFLEN) != CBUFLEN) {
 	printf("Couldn't write all bytes\n");
       }
-
-      // wait a moment
-      if (USE_SLEEP) {
-	ns.tv_sec=0;
-	ns.tv_nsec=1000000;
-	nanosleep(&ns,NULL);
-      }
     }
 
+    if (USE_SLEEP)
+      printf("Deadline misses: %lu of %lu (skipped periods %lu, max. lateness %f s)\n",
+	     pacer.nDeadlineMisses,pacer.nPeriods,pacer.nSkippedPeriods,pacer.maxLateness);
+
     // a server termination message
     buf.ibuf[0] = -1;
     udp.writeUDPSocket(buf.cbuf,4);
@@ -638,5 +2495,59 @@ Function Parameters: [in]=input,[out]=output
 
   }
 
+  static double
+  measureUDPSendTime(UDP_communication *udp, int n_packets)
+  {
+    char            cbuf[CBUFLEN];
+    struct timespec t0, t1;
+    int             i;
+
+    bzero(cbuf, CBUFLEN);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i=0; i<n_packets; ++i)
+      udp->writeUDPSocket(cbuf,CBUFLEN);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    return ((t1.tv_sec - t0.tv_sec)*1.e9 + (t1.tv_nsec - t0.tv_nsec))/(double) n_packets;
+  }
+
+  void
+  testUDPSendLatency(int n_packets, char *name)
+  {
+    double t_unconnected;
+    double t_connected;
+    char   any[1] = "";
+    UDP_communication sink;
+    UDP_communication udp;
+    UDP_communication udp_connected;
+
+    // a local sink such that connected sends do not fail with ECONNREFUSED;
+    // for a remote host, run a server there
+    sink.makeUDPServer(TESTPORTSERVER,any);
+
+    udp.makeUDPClient(TESTPORTCLIENT,name);
+    udp_connected.makeUDPConnectedClient(TESTPORTCLIENT,name);
+
+    // test for active socket
+    if (!udp.active || !udp_connected.active) {
+      printf("Failed to create UDP Client\n");
+      return;
+    }
+
+    t_unconnected = measureUDPSendTime(&udp,n_packets);
+    t_connected   = measureUDPSendTime(&udp_connected,n_packets);
+
+    udp.closeUDPSocket();
+    udp_connected.closeUDPSocket();
+
+    // print statistics
+    printf("Send Latency (%d packets):\n",n_packets);
+    printf("     sendto (unconnected) : %f ns/packet\n",t_unconnected);
+    printf("     send   (connected)   : %f ns/packet\n",t_connected);
+    printf("     improvement          : %f %%\n",
+	   100.*(t_unconnected - t_connected)/t_unconnected);
+
+  }
+
 } // end of namespace
 
@@ -0,0 +1,529 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_delta.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  Delta encoding of successive frames of a state stream. The sender XORs each
+  frame with the previous one, and transmits only the runs of changed bytes,
+  each preceded by the length of the unchanged run before it (LEB128 varints).
+  Every keyframe_interval frames, and whenever a delta would not be smaller,
+  the full frame is sent as a keyframe. Deltas refer to the immediately
+  preceding frame; after a lost datagram, the receiver skips all deltas until
+  the next keyframe.
+
+  The XOR and change detection run over 16 bytes at a time with SSE2, and
+  the runs are found by scanning a bitmap of changed bytes, such that
+  unchanged regions cost almost nothing.
+
+  ============================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+#include "string.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// my utilities library
+#include "utility.h"
+
+#include "udp_delta.h"
+#include "comm_log.h"
+
+namespace udp_communication {
+
+  using namespace comm_log;
+
+  static int
+  putVarint(char *out, uint32_t v)
+  {
+    int n = 0;
+
+    while (v >= 0x80) {
+      out[n++] = (char) (v | 0x80);
+      v >>= 7;
+    }
+    out[n++] = (char) v;
+
+    return n;
+  }
+
+  static int
+  getVarint(const char *in, int inLen, int *pos, uint32_t *v)
+  {
+    uint8_t byte;
+
+    *v = 0;
+    for (int shift=0; shift<35; shift+=7) {
+      if (*pos >= inLen)
+	return FALSE;
+      byte = (uint8_t) in[(*pos)++];
+      *v |= (uint32_t) (byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+	return TRUE;
+    }
+
+    return FALSE;
+  }
+
+  // the first position >= pos whose mask bit equals set, or len
+  static int
+  nextBit(const uint64_t *mask, int len, int pos, bool set)
+  {
+    int      n_words = (len + 63) / 64;
+    int      w = pos >> 6;
+    uint64_t bits;
+
+    if (pos >= len)
+      return len;
+
+    bits = (set ? mask[w] : ~mask[w]) & (~0ULL << (pos & 63));
+    while (bits == 0) {
+      if (++w >= n_words)
+	return len;
+      bits = set ? mask[w] : ~mask[w];
+    }
+
+    pos = w*64 + __builtin_ctzll(bits);
+
+    return pos < len ? pos : len;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Constructor
+\date  Oct 2026
+
+\remarks
+
+The codec is inactive until initUDPDelta() was called.
+
+  ******************************************************************************/
+  UDPDeltaCodec::
+  UDPDeltaCodec()
+  {
+    active    = FALSE;
+    udp       = NULL;
+    prevFrame = NULL;
+    sendBuf   = NULL;
+    scratch   = NULL;
+    mask      = NULL;
+    frameBuf  = NULL;
+    recvBuf   = NULL;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Destructor
+\date  Oct 2026
+
+\remarks
+
+Frees all buffers. The UDP socket is not closed.
+
+  ******************************************************************************/
+  UDPDeltaCodec::
+  ~UDPDeltaCodec()
+  {
+    free(prevFrame);
+    free(sendBuf);
+    free(scratch);
+    free(mask);
+    free(frameBuf);
+    free(recvBuf);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  initUDPDelta
+\date  Oct 2026
+
+\remarks
+
+Allocates the frame buffers for sending and receiving.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     udp               : the UDP socket to communicate with
+\param[in]     max_frame_len     : max. length of a frame
+\param[in]     keyframe_interval : a keyframe is sent at least every
+                                   keyframe_interval frames
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPDeltaCodec::
+  initUDPDelta(UDP_communication *udp,
+	       int max_frame_len,
+	       int keyframe_interval)
+  {
+    if (active) {
+      printf("Delta codec is already active\n");
+      return FALSE;
+    }
+
+    if (max_frame_len <= 0 || max_frame_len + (int) sizeof(UDPDeltaHeader) > 65507) {
+      printf("Error: frames must fit into a single datagram\n");
+      return FALSE;
+    }
+
+    if (keyframe_interval < 1) {
+      printf("Error: invalid keyframe interval\n");
+      return FALSE;
+    }
+
+    this->udp        = udp;
+    maxFrameLen      = max_frame_len;
+    keyframeInterval = keyframe_interval;
+    prevFrame        = (char *) malloc(max_frame_len);
+    sendBuf          = (char *) malloc(sizeof(UDPDeltaHeader) + max_frame_len);
+    scratch          = (char *) malloc(max_frame_len);
+    mask             = (uint64_t *) malloc(((max_frame_len + 63) / 64) * sizeof(uint64_t));
+    frameBuf         = (char *) malloc(max_frame_len);
+    recvBuf          = (char *) malloc(sizeof(UDPDeltaHeader) + max_frame_len);
+
+    prevLen        = ERROR;
+    sendSeq        = 0;
+    sinceKeyframe  = 0;
+    frameLen       = 0;
+    recvSeq        = 0;
+    haveFrame      = FALSE;
+    haveSeq        = FALSE;
+    nKeyframes     = 0;
+    nDeltas        = 0;
+    nDeltasSkipped = 0;
+    nLate          = 0;
+    nBytesRaw      = 0;
+    nBytesEncoded  = 0;
+
+    active = TRUE;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  encodeUDPDelta
+\date  Oct 2026
+
+\remarks
+
+Encodes the difference of two frames as a sequence of (unchanged run length,
+changed run length, XOR bytes of the changed run). Unchanged runs shorter
+than UDP_DELTA_MIN_ZEROS are merged into the surrounding changed runs.
+Unchanged bytes at the end of the frame are not encoded.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     prev            : the previous frame
+\param[in]     cur             : the current frame
+\param[in]     len             : length of both frames
+\param[out]    out             : the encoded delta
+\param[in]     maxOutLen       : size of out
+\param[out]    scratch         : work space of len bytes
+\param[out]    mask            : work space of (len+63)/64 words
+
+returns the length of the encoded delta, or ERROR if it exceeds maxOutLen
+
+  ******************************************************************************/
+  int UDPDeltaCodec::
+  encodeUDPDelta(const char *prev,
+		 const char *cur,
+		 int         len,
+		 char       *out,
+		 int         maxOutLen,
+		 char       *scratch,
+		 uint64_t   *mask)
+  {
+    int      i = 0;
+    int      pos, start, end, clear, next;
+    int      n = 0;
+    uint64_t bits;
+
+    // XOR the frames and mark the changed bytes, 64 bytes per mask word
+    for (; i + 64 <= len; i += 64) {
+#ifdef __SSE2__
+      bits = 0;
+      for (int j=0; j<64; j+=16) {
+	__m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (prev + i + j)),
+				  _mm_loadu_si128((const __m128i *) (cur + i + j)));
+	_mm_storeu_si128((__m128i *) (scratch + i + j), x);
+	bits |= (uint64_t) (~_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_setzero_si128()))
+			    & 0xffff) << j;
+      }
+#else
+      bits = 0;
+      for (int j=0; j<64; ++j) {
+	scratch[i+j] = prev[i+j] ^ cur[i+j];
+	if (scratch[i+j])
+	  bits |= 1ULL << j;
+      }
+#endif
+      mask[i/64] = bits;
+    }
+    if (i < len) {
+      bits = 0;
+      for (int j=0; i+j<len; ++j) {
+	scratch[i+j] = prev[i+j] ^ cur[i+j];
+	if (scratch[i+j])
+	  bits |= 1ULL << j;
+      }
+      mask[i/64] = bits;
+    }
+
+    // collect the runs of changed bytes
+    pos = 0;
+    while ((start = nextBit(mask, len, pos, TRUE)) < len) {
+      end = start;
+      while (TRUE) {
+	clear = nextBit(mask, len, end, FALSE);
+	next  = nextBit(mask, len, clear, TRUE);
+	if (next >= len || next - clear >= UDP_DELTA_MIN_ZEROS) {
+	  end = clear;
+	  break;
+	}
+	end = next;
+      }
+
+      if (n + 10 + (end - start) > maxOutLen)
+	return ERROR;
+
+      n += putVarint(out + n, start - pos);
+      n += putVarint(out + n, end - start);
+      memcpy(out + n, scratch + start, end - start);
+      n  += end - start;
+      pos = end;
+    }
+
+    return n;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  decodeUDPDelta
+\date  Oct 2026
+
+\remarks
+
+Applies an encoded delta in place to the previous frame.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     enc             : the encoded delta
+\param[in]     encLen          : length of the encoded delta
+\param[in,out] frame           : the previous frame, which becomes the current one
+\param[in]     len             : length of the frame
+
+returns TRUE if all OK, or FALSE if the delta is corrupt (the frame is then
+partially updated)
+
+  ******************************************************************************/
+  int UDPDeltaCodec::
+  decodeUDPDelta(const char *enc,
+		 int         encLen,
+		 char       *frame,
+		 int         len)
+  {
+    int      p = 0;
+    int      pos = 0;
+    int      i;
+    uint32_t zeros, changed;
+
+    while (p < encLen) {
+      if (!getVarint(enc, encLen, &p, &zeros) || !getVarint(enc, encLen, &p, &changed))
+	return FALSE;
+      if (zeros > (uint32_t) (len - pos) || changed > (uint32_t) (len - pos) - zeros ||
+	  changed > (uint32_t) (encLen - p))
+	return FALSE;
+
+      pos += zeros;
+      i = 0;
+#ifdef __SSE2__
+      for (; i + 16 <= (int) changed; i += 16)
+	_mm_storeu_si128((__m128i *) (frame + pos + i),
+			 _mm_xor_si128(_mm_loadu_si128((const __m128i *) (frame + pos + i)),
+				       _mm_loadu_si128((const __m128i *) (enc + p + i))));
+#endif
+      for (; i < (int) changed; ++i)
+	frame[pos+i] ^= enc[p+i];
+
+      pos += changed;
+      p   += changed;
+    }
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  writeUDPDelta
+\date  Oct 2026
+
+\remarks
+
+Sends a frame, either as a delta to the previous frame, or as a keyframe. A
+change of the frame length always results in a keyframe.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     frame           : the frame
+\param[in]     frameLen        : length of the frame
+
+returns the number of frame bytes sent, or FALSE on error
+
+  ******************************************************************************/
+  int UDPDeltaCodec::
+  writeUDPDelta(char *frame,
+		int   frameLen)
+  {
+    UDPDeltaHeader *hdr = (UDPDeltaHeader *) sendBuf;
+    char           *payload = sendBuf + sizeof(UDPDeltaHeader);
+    int             n = ERROR;
+
+    if (!active) {
+      logCommEvent(COMM_EV_CHANNEL_NOT_ACTIVE,0);
+      return FALSE;
+    }
+
+    if (frameLen <= 0 || frameLen > maxFrameLen) {
+      logCommEvent(COMM_EV_CHANNEL_INVALID_LENGTH,0,frameLen,maxFrameLen);
+      return FALSE;
+    }
+
+    // a delta that is not smaller than the frame is sent as keyframe
+    if (frameLen == prevLen && sinceKeyframe + 1 < keyframeInterval)
+      n = encodeUDPDelta(prevFrame, frame, frameLen, payload, frameLen - 1,
+			 scratch, mask);
+
+    if (n == ERROR) {
+      memcpy(payload, frame, frameLen);
+      n = frameLen;
+      hdr->type = UDP_DELTA_KEYFRAME;
+      sinceKeyframe = 0;
+      ++nKeyframes;
+    } else {
+      hdr->type = UDP_DELTA_DELTA;
+      ++sinceKeyframe;
+      ++nDeltas;
+    }
+
+    hdr->magic       = UDP_DELTA_MAGIC;
+    hdr->reserved    = 0;
+    hdr->seq         = sendSeq++;
+    hdr->frame_len   = frameLen;
+    hdr->payload_len = n;
+
+    memcpy(prevFrame, frame, frameLen);
+    prevLen = frameLen;
+
+    nBytesRaw     += frameLen;
+    nBytesEncoded += n;
+
+    if (udp->writeUDPSocket(sendBuf, sizeof(UDPDeltaHeader) + n) !=
+	(int) sizeof(UDPDeltaHeader) + n)
+      return FALSE;
+
+    return frameLen;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPDelta
+\date  Oct 2026
+
+\remarks
+
+Receives the next frame. The frame is reconstructed in place in an internal
+buffer, which is returned in *frame and stays valid until the next call.
+Deltas that do not follow the last reconstructed frame are counted in
+nDeltasSkipped and discarded until the next keyframe arrives. Reordered
+keyframes that are not newer than the last frame are counted in nLate and
+discarded, unless they are so old that the sender must have restarted.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[out]    frame           : pointer to the reconstructed frame
+\param[out]    peer            : the sender -- pass NULL if not needed
+
+returns the length of the frame, 0 if no frame is available on a non-blocking
+socket, or ERROR
+
+  ******************************************************************************/
+  int UDPDeltaCodec::
+  readUDPDelta(char       **frame,
+	       UDPEndpoint *peer)
+  {
+    UDPDeltaHeader *hdr = (UDPDeltaHeader *) recvBuf;
+    char           *payload = recvBuf + sizeof(UDPDeltaHeader);
+    int             n;
+
+    if (!active) {
+      logCommEvent(COMM_EV_CHANNEL_NOT_ACTIVE,0);
+      return ERROR;
+    }
+
+    while (TRUE) {
+      n = udp->readUDPSocketFrom(recvBuf, sizeof(UDPDeltaHeader) + maxFrameLen, peer);
+      if (n <= 0)
+	return n == 0 ? 0 : ERROR;
+
+      if (n < (int) sizeof(UDPDeltaHeader) || hdr->magic != UDP_DELTA_MAGIC ||
+	  hdr->payload_len != n - sizeof(UDPDeltaHeader) ||
+	  hdr->frame_len == 0 || hdr->frame_len > (uint32_t) maxFrameLen)
+	continue;
+
+      if (hdr->type == UDP_DELTA_KEYFRAME) {
+	if (hdr->payload_len != hdr->frame_len)
+	  continue;
+	// a late keyframe would replace newer state and move recvSeq back
+	if (haveSeq && (int32_t) (hdr->seq - recvSeq) <= 0 &&
+	    recvSeq - hdr->seq < UDP_DELTA_MAX_LATE) {
+	  ++nLate;
+	  continue;
+	}
+	memcpy(frameBuf, payload, hdr->frame_len);
+	frameLen  = hdr->frame_len;
+	recvSeq   = hdr->seq;
+	haveFrame = TRUE;
+	haveSeq   = TRUE;
+	++nKeyframes;
+	break;
+      }
+
+      // a late delta of an earlier frame is just ignored, while a gap
+      // invalidates the frame until the next keyframe
+      if (haveFrame && (int32_t) (hdr->seq - recvSeq) <= 0)
+	continue;
+
+      if (!haveFrame || hdr->seq != recvSeq + 1 || hdr->frame_len != (uint32_t) frameLen ||
+	  !decodeUDPDelta(payload, hdr->payload_len, frameBuf, frameLen)) {
+	haveFrame = FALSE;
+	++nDeltasSkipped;
+	continue;
+      }
+
+      recvSeq = hdr->seq;
+      ++nDeltas;
+      break;
+    }
+
+    nBytesRaw     += frameLen;
+    nBytesEncoded += hdr->payload_len;
+    *frame = frameBuf;
+
+    return frameLen;
+  }
+
+} // end of namespace
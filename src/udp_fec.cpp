@@ -0,0 +1,920 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_fec.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  Forward error correction for lossy links. The sender groups its datagrams
+  into blocks of k data packets and, after the k-th one, sends m parity
+  packets. The receiver can rebuild up to m lost data packets of a block as
+  soon as any k packets of the block arrived, i.e., at most one block later
+  than the original, without a round trip for a retransmission. The overhead
+  is m/k: k=8, m=1 costs 12.5% and survives one loss per 8 packets, k=8, m=2
+  costs 25% and survives two.
+
+  Data packets are sent right away and unchanged behind a small header, such
+  that FEC adds no latency to packets that are not lost. A data shard is the
+  2 byte length followed by the payload, zero padded to the longest shard of
+  the block. With m=1, the parity is the XOR of the data shards; otherwise,
+  the parity rows are a Cauchy matrix over GF(2^8), such that any m losses can
+  be corrected (Reed-Solomon). Encoding and decoding multiply whole shards by
+  constants, which uses the split nibble table lookup with PSHUFB (SSSE3 or
+  AVX2, selected at run time) and a scalar table fallback.
+
+  For testing, the sender can drop its own datagrams at random, see
+  setUDPFecLoss() and testUDPFec().
+
+  ============================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+#include "string.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FEC_X86 1
+#endif
+
+// my utilities library
+#include "utility.h"
+
+#include "udp_fec.h"
+#include "comm_log.h"
+
+#define FEC_TESTPORT   55007
+
+namespace udp_communication {
+
+  using namespace comm_log;
+
+  // GF(2^8) with the polynomial x^8+x^4+x^3+x^2+1
+  static uint8_t gfExp[512];
+  static uint8_t gfLog[256];
+
+  // products of c with the low and high nibble of a byte
+  static uint8_t gfMulLo[256][16] __attribute__((aligned(16)));
+  static uint8_t gfMulHi[256][16] __attribute__((aligned(16)));
+
+  static void
+  mulAddScalar(uint8_t *dst, const uint8_t *src, uint8_t c, int len)
+  {
+    const uint8_t *lo = gfMulLo[c];
+    const uint8_t *hi = gfMulHi[c];
+
+    for (int i=0; i<len; ++i)
+      dst[i] ^= lo[src[i] & 0x0f] ^ hi[src[i] >> 4];
+  }
+
+#ifdef FEC_X86
+  __attribute__((target("ssse3"))) static void
+  mulAddSSSE3(uint8_t *dst, const uint8_t *src, uint8_t c, int len)
+  {
+    __m128i lo   = _mm_load_si128((const __m128i *) gfMulLo[c]);
+    __m128i hi   = _mm_load_si128((const __m128i *) gfMulHi[c]);
+    __m128i mask = _mm_set1_epi8(0x0f);
+    __m128i s, p;
+    int     i;
+
+    for (i=0; i+16<=len; i+=16) {
+      s = _mm_loadu_si128((const __m128i *) (src+i));
+      p = _mm_xor_si128(_mm_shuffle_epi8(lo, _mm_and_si128(s, mask)),
+			_mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi64(s, 4), mask)));
+      _mm_storeu_si128((__m128i *) (dst+i),
+		       _mm_xor_si128(_mm_loadu_si128((const __m128i *) (dst+i)), p));
+    }
+
+    mulAddScalar(dst+i, src+i, c, len-i);
+  }
+
+  __attribute__((target("avx2"))) static void
+  mulAddAVX2(uint8_t *dst, const uint8_t *src, uint8_t c, int len)
+  {
+    __m256i lo   = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *) gfMulLo[c]));
+    __m256i hi   = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *) gfMulHi[c]));
+    __m256i mask = _mm256_set1_epi8(0x0f);
+    __m256i s, p;
+    int     i;
+
+    for (i=0; i+32<=len; i+=32) {
+      s = _mm256_loadu_si256((const __m256i *) (src+i));
+      p = _mm256_xor_si256(_mm256_shuffle_epi8(lo, _mm256_and_si256(s, mask)),
+			   _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi64(s, 4), mask)));
+      _mm256_storeu_si256((__m256i *) (dst+i),
+			  _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (dst+i)), p));
+    }
+
+    mulAddScalar(dst+i, src+i, c, len-i);
+  }
+#endif
+
+  //! dst ^= c * src for len bytes
+  static void (*mulAddRegion)(uint8_t *dst, const uint8_t *src, uint8_t c, int len) = mulAddScalar;
+  static const char *mulAddKernel = "scalar";
+
+  static struct GFTables {
+    GFTables()
+    {
+      int x = 1;
+
+      for (int i=0; i<255; ++i) {
+	gfExp[i] = gfExp[i+255] = x;
+	gfLog[x] = i;
+	x <<= 1;
+	if (x & 0x100)
+	  x ^= 0x11d;
+      }
+      gfLog[0] = 0;
+
+      for (int c=0; c<256; ++c)
+	for (int n=0; n<16; ++n) {
+	  gfMulLo[c][n] = (c && n) ? gfExp[gfLog[c] + gfLog[n]] : 0;
+	  gfMulHi[c][n] = (c && n) ? gfExp[gfLog[c] + gfLog[n << 4]] : 0;
+	}
+
+#ifdef FEC_X86
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2")) {
+	mulAddRegion = mulAddAVX2;
+	mulAddKernel = "avx2";
+      } else if (__builtin_cpu_supports("ssse3")) {
+	mulAddRegion = mulAddSSSE3;
+	mulAddKernel = "ssse3";
+      }
+#endif
+    }
+  } gfTables;
+
+  static inline uint8_t
+  gfMul(uint8_t a, uint8_t b)
+  {
+    return (a && b) ? gfExp[gfLog[a] + gfLog[b]] : 0;
+  }
+
+  static inline uint8_t
+  gfInv(uint8_t a)
+  {
+    return gfExp[255 - gfLog[a]];
+  }
+
+  //! coefficient of data shard j in parity shard i: all ones for m=1 (XOR),
+  //! otherwise the Cauchy matrix 1/(x_i + y_j) with x_i = 255-i, y_j = j
+  static inline uint8_t
+  fecCoef(int i, int j, int m)
+  {
+    return m == 1 ? 1 : gfInv((uint8_t) ((255 - i) ^ j));
+  }
+
+  //! inverts the n x n matrix a in place by Gauss-Jordan elimination
+  static int
+  gfInvert(uint8_t a[UDP_FEC_MAX_PARITY][UDP_FEC_MAX_PARITY], int n)
+  {
+    uint8_t b[UDP_FEC_MAX_PARITY][UDP_FEC_MAX_PARITY];
+    uint8_t f, t;
+    int     r, c, p;
+
+    for (r=0; r<n; ++r)
+      for (c=0; c<n; ++c)
+	b[r][c] = (r == c);
+
+    for (c=0; c<n; ++c) {
+      for (p=c; p<n && a[p][c] == 0; ++p)
+	;
+      if (p == n)
+	return FALSE;
+      if (p != c)
+	for (r=0; r<n; ++r) {
+	  t = a[c][r]; a[c][r] = a[p][r]; a[p][r] = t;
+	  t = b[c][r]; b[c][r] = b[p][r]; b[p][r] = t;
+	}
+
+      f = gfInv(a[c][c]);
+      for (r=0; r<n; ++r) {
+	a[c][r] = gfMul(a[c][r], f);
+	b[c][r] = gfMul(b[c][r], f);
+      }
+
+      for (p=0; p<n; ++p) {
+	if (p == c || a[p][c] == 0)
+	  continue;
+	f = a[p][c];
+	for (r=0; r<n; ++r) {
+	  a[p][r] ^= gfMul(f, a[c][r]);
+	  b[p][r] ^= gfMul(f, b[c][r]);
+	}
+      }
+    }
+
+    memcpy(a, b, sizeof(b));
+
+    return TRUE;
+  }
+
+  //! zero pads a data shard to the shard length of its block
+  static void
+  padShard(uint8_t *shard, int shardLen)
+  {
+    int used = 2 + (shard[0] | (shard[1] << 8));
+
+    if (used < shardLen)
+      memset(shard + used, 0, shardLen - used);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Constructor
+\date  Oct 2026
+
+\remarks
+
+The channel is inactive until initUDPFec() was called.
+
+  ******************************************************************************/
+  UDPFecChannel::
+  UDPFecChannel()
+  {
+    active       = FALSE;
+    udp          = NULL;
+    sendShards   = NULL;
+    sendBuf      = NULL;
+    recvBuf      = NULL;
+    scratch      = NULL;
+    pendingBlock = NULL;
+    nPending     = 0;
+    lossRate     = 0;
+    for (int i=0; i<UDP_FEC_BLOCKS; ++i)
+      blocks[i].shards = NULL;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Destructor
+\date  Oct 2026
+
+\remarks
+
+Frees all buffers. The UDP socket is not closed.
+
+  ******************************************************************************/
+  UDPFecChannel::
+  ~UDPFecChannel()
+  {
+    free(sendShards);
+    free(sendBuf);
+    free(recvBuf);
+    free(scratch);
+    for (int i=0; i<UDP_FEC_BLOCKS; ++i)
+      free(blocks[i].shards);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  initUDPFec
+\date  Oct 2026
+
+\remarks
+
+Sets the block structure and allocates all buffers. Both sides need to use
+the same k and m; the receiver rejects larger blocks.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     udp             : the UDP socket to communicate with
+\param[in]     k               : data packets per block
+\param[in]     m               : parity packets per block, 1 ... UDP_FEC_MAX_PARITY
+\param[in]     max_msg_len     : max. payload length of a datagram
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPFecChannel::
+  initUDPFec(UDP_communication *udp,
+	     int k,
+	     int m,
+	     int max_msg_len)
+  {
+    int i;
+
+    if (active) {
+      printf("FEC channel is already active\n");
+      return FALSE;
+    }
+
+    if (k < 1 || m < 1 || m > UDP_FEC_MAX_PARITY || k + m > 255) {
+      printf("Error: invalid FEC block size\n");
+      return FALSE;
+    }
+
+    if (max_msg_len <= 0 || max_msg_len > 65535 - 2) {
+      printf("Error: invalid max. message length\n");
+      return FALSE;
+    }
+
+    this->udp = udp;
+    this->k   = k;
+    this->m   = m;
+    shardMax  = max_msg_len + 2;
+
+    sendShards = (uint8_t *) calloc(k, shardMax);
+    sendBuf    = (char *) malloc(shardMax);
+    recvBuf    = (char *) malloc(sizeof(UDPFecHeader) + shardMax);
+    scratch    = (uint8_t *) malloc(m * shardMax);
+    for (i=0; i<UDP_FEC_BLOCKS; ++i) {
+      blocks[i].used   = FALSE;
+      blocks[i].shards = (uint8_t *) calloc(k + m, shardMax);
+    }
+
+    sendBlock      = 0;
+    sendCount      = 0;
+    sendShardLen   = 0;
+    nDataSent      = 0;
+    nParitySent    = 0;
+    nSimDropped    = 0;
+    nReceived      = 0;
+    nRecovered     = 0;
+    nUnrecoverable = 0;
+    nDuplicates    = 0;
+    nLate          = 0;
+    nStale         = 0;
+    nResyncs       = 0;
+    nInvalid       = 0;
+    recvStarted    = FALSE;
+    recvNewest     = 0;
+
+    active = TRUE;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  setUDPFecLoss
+\date  Oct 2026
+
+\remarks
+
+Simulates a lossy link: every datagram this channel sends is dropped with the
+given probability, counted in nSimDropped. Use 0 to switch off.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     loss_rate       : drop probability, 0 ... 1
+\param[in]     seed            : random seed, for reproducible tests
+
+  ******************************************************************************/
+  void UDPFecChannel::
+  setUDPFecLoss(double loss_rate,
+		unsigned int seed)
+  {
+    lossRate = loss_rate;
+    lossSeed = seed;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  getUDPFecKernel
+\date  Oct 2026
+
+\remarks
+
+returns the name of the GF(2^8) kernel in use: "avx2", "ssse3", or "scalar"
+
+  ******************************************************************************/
+  const char *UDPFecChannel::
+  getUDPFecKernel(void)
+  {
+    return mulAddKernel;
+  }
+
+  int UDPFecChannel::
+  sendUDPFecPacket(UDPFecHeader *hdr, const uint8_t *payload, int len)
+  {
+    struct iovec iov[2];
+
+    if (lossRate > 0 && rand_r(&lossSeed) < lossRate * ((double) RAND_MAX + 1)) {
+      ++nSimDropped;
+      return sizeof(UDPFecHeader) + len;
+    }
+
+    iov[0].iov_base = hdr;
+    iov[0].iov_len  = sizeof(UDPFecHeader);
+    iov[1].iov_base = (void *) payload;
+    iov[1].iov_len  = len;
+
+    return udp->writeUDPSocketV(iov, 2);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  writeUDPFec
+\date  Oct 2026
+
+\remarks
+
+Sends a data packet immediately, and the parity packets of the block after
+its k-th data packet.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     buf             : payload
+\param[in]     bufLen          : length of payload
+
+returns the number of payload bytes written, or FALSE on error
+
+  ******************************************************************************/
+  int UDPFecChannel::
+  writeUDPFec(char *buf,
+	      int   bufLen)
+  {
+    UDPFecHeader  hdr;
+    uint8_t      *shard;
+    int           n;
+
+    if (!active) {
+      logCommEvent(COMM_EV_CHANNEL_NOT_ACTIVE,0);
+      return FALSE;
+    }
+
+    if (bufLen < 0 || bufLen > shardMax - 2) {
+      logCommEvent(COMM_EV_CHANNEL_INVALID_LENGTH,0,bufLen,shardMax - 2);
+      return FALSE;
+    }
+
+    // keep the shard for the parity, and send the payload from there
+    shard = sendShards + sendCount * shardMax;
+    shard[0] = bufLen & 0xff;
+    shard[1] = bufLen >> 8;
+    memcpy(shard + 2, buf, bufLen);
+
+    hdr.magic = UDP_FEC_MAGIC;
+    hdr.k     = k;
+    hdr.m     = m;
+    hdr.block = sendBlock;
+    hdr.index = sendCount;
+    hdr.flags = 0;
+    hdr.len   = bufLen;
+
+    n = sendUDPFecPacket(&hdr, shard + 2, bufLen);
+    ++nDataSent;
+
+    if (bufLen + 2 > sendShardLen)
+      sendShardLen = bufLen + 2;
+
+    if (++sendCount == k)
+      flushUDPFec();
+
+    if (n < (int) sizeof(UDPFecHeader))
+      return FALSE;
+
+    return n - sizeof(UDPFecHeader);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  flushUDPFec
+\date  Oct 2026
+
+\remarks
+
+Sends the parity packets of the current block, even if it has less than k
+data packets, e.g., at the end of a burst. Called by writeUDPFec() when the
+block is complete.
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPFecChannel::
+  flushUDPFec(void)
+  {
+    UDPFecHeader  hdr;
+    uint8_t      *parity = (uint8_t *) sendBuf;
+    int           i, j;
+    int           rc = TRUE;
+
+    if (!active) {
+      logCommEvent(COMM_EV_CHANNEL_NOT_ACTIVE,0);
+      return FALSE;
+    }
+
+    if (sendCount == 0)
+      return TRUE;
+
+    for (j=0; j<sendCount; ++j)
+      padShard(sendShards + j * shardMax, sendShardLen);
+
+    hdr.magic = UDP_FEC_MAGIC;
+    hdr.k     = sendCount;
+    hdr.m     = m;
+    hdr.block = sendBlock;
+    hdr.flags = 0;
+    hdr.len   = sendShardLen;
+
+    for (i=0; i<m; ++i) {
+      memset(parity, 0, sendShardLen);
+      for (j=0; j<sendCount; ++j)
+	mulAddRegion(parity, sendShards + j * shardMax, fecCoef(i, j, m), sendShardLen);
+      hdr.index = sendCount + i;
+      if (sendUDPFecPacket(&hdr, parity, sendShardLen) <= 0)
+	rc = FALSE;
+      ++nParitySent;
+    }
+
+    ++sendBlock;
+    sendCount    = 0;
+    sendShardLen = 0;
+
+    return rc;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  closeUDPFecBlock
+\date  Oct 2026
+
+\remarks
+
+Gives up on a block whose slot is needed for a newer one, and counts its
+data packets that were neither received nor rebuilt.
+
+  ******************************************************************************/
+  void UDPFecChannel::
+  closeUDPFecBlock(Block *b)
+  {
+    int k_block, j;
+
+    if (b->used && !b->done) {
+      k_block = b->kUsed ? b->kUsed : b->kData;
+      for (j=0; j<k_block; ++j)
+	if (!b->have[j])
+	  ++nUnrecoverable;
+    }
+
+    b->used = FALSE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  getUDPFecBlock
+\date  Oct 2026
+
+\remarks
+
+Returns the receiver state of a block, opening it if needed, or NULL if the
+block was closed already. A block counter that jumps back by more than the
+open blocks means that the sender restarted: all blocks are closed, and the
+receiver continues with the new counter.
+
+  ******************************************************************************/
+  UDPFecChannel::Block *UDPFecChannel::
+  getUDPFecBlock(uint32_t block)
+  {
+    Block *b = &blocks[block % UDP_FEC_BLOCKS];
+    int    i;
+
+    if (recvStarted && (int32_t) (block - recvNewest) < -UDP_FEC_BLOCKS) {
+      for (i=0; i<UDP_FEC_BLOCKS; ++i)
+	closeUDPFecBlock(&blocks[i]);
+      recvNewest = block;
+      ++nResyncs;
+    }
+    if (!recvStarted || (int32_t) (block - recvNewest) > 0)
+      recvNewest = block;
+    recvStarted = TRUE;
+
+    if (b->used) {
+      if (b->block == block)
+	return b;
+      if ((int32_t) (block - b->block) < 0)
+	return NULL;
+      closeUDPFecBlock(b);
+    }
+
+    b->used     = TRUE;
+    b->done     = FALSE;
+    b->block    = block;
+    b->kData    = 0;
+    b->kUsed    = 0;
+    b->m        = 0;
+    b->shardLen = 0;
+    b->nData    = 0;
+    b->nParity  = 0;
+    memset(b->have, 0, sizeof(b->have));
+
+    return b;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  decodeUDPFecBlock
+\date  Oct 2026
+
+\remarks
+
+Rebuilds the missing data shards of a block once enough parity shards are
+available, and queues them for delivery. With e missing data shards and e
+parity shards P, the parity minus the known data shards leaves e equations
+in the missing shards, whose e x e coefficient matrix is inverted.
+
+  ******************************************************************************/
+  void UDPFecChannel::
+  decodeUDPFecBlock(Block *b)
+  {
+    uint8_t  a[UDP_FEC_MAX_PARITY][UDP_FEC_MAX_PARITY];
+    int      missing[UDP_FEC_MAX_PARITY];
+    int      par[UDP_FEC_MAX_PARITY];
+    int      n_missing = 0;
+    int      n_par = 0;
+    int      S = b->shardLen;
+    uint8_t *rhs, *out;
+    int      i, j, r, c;
+
+    if (b->done || b->kUsed == 0)
+      return;
+
+    for (j=0; j<b->kUsed; ++j)
+      if (!b->have[j]) {
+	if (n_missing == b->m)
+	  return;
+	missing[n_missing++] = j;
+      }
+
+    if (n_missing == 0) {
+      b->done = TRUE;
+      return;
+    }
+
+    for (i=0; i<b->m && n_par<n_missing; ++i)
+      if (b->have[k + i])
+	par[n_par++] = i;
+    if (n_par < n_missing)
+      return;
+
+    for (j=0; j<b->kUsed; ++j)
+      if (b->have[j])
+	padShard(b->shards + j * shardMax, S);
+
+    // right hand sides: the parity minus the contribution of the known data
+    for (r=0; r<n_missing; ++r) {
+      rhs = scratch + r * shardMax;
+      memcpy(rhs, b->shards + (k + par[r]) * shardMax, S);
+      for (j=0; j<b->kUsed; ++j)
+	if (b->have[j])
+	  mulAddRegion(rhs, b->shards + j * shardMax, fecCoef(par[r], j, b->m), S);
+      for (c=0; c<n_missing; ++c)
+	a[r][c] = fecCoef(par[r], missing[c], b->m);
+    }
+
+    if (!gfInvert(a, n_missing)) {
+      logCommEvent(COMM_EV_FEC_SINGULAR,0);
+      return;
+    }
+
+    // queued in reverse, such that delivery is in order
+    nPending = 0;
+    for (c=n_missing-1; c>=0; --c) {
+      out = b->shards + missing[c] * shardMax;
+      memset(out, 0, S);
+      for (r=0; r<n_missing; ++r)
+	mulAddRegion(out, scratch + r * shardMax, a[c][r], S);
+      b->have[missing[c]] = TRUE;
+      if (2 + (out[0] | (out[1] << 8)) > S) {
+	++nInvalid;
+	continue;
+      }
+      pending[nPending++] = missing[c];
+      ++nRecovered;
+    }
+    pendingBlock = b;
+    b->done = TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPFec
+\date  Oct 2026
+
+\remarks
+
+Returns the next data packet, either as received, or rebuilt from parity, in
+which case hdr->flags has UDP_FEC_RECOVERED set. Rebuilt packets arrive out
+of order, at the latest with the parity of their block; the header tells the
+block and index of each packet. Parity packets are consumed internally.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[out]    buf             : payload buffer
+\param[in]     bufLen          : length of payload buffer
+\param[out]    hdr             : header of the packet -- pass NULL if not needed
+
+returns the number of payload bytes received, 0 if no data on a non-blocking
+socket, or ERROR
+
+  ******************************************************************************/
+  int UDPFecChannel::
+  readUDPFec(char         *buf,
+	     int           bufLen,
+	     UDPFecHeader *hdr)
+  {
+    UDPFecHeader *rhdr = (UDPFecHeader *) recvBuf;
+    uint8_t      *shard;
+    Block        *b;
+    int           n, pos;
+
+    if (!active) {
+      logCommEvent(COMM_EV_CHANNEL_NOT_ACTIVE,0);
+      return ERROR;
+    }
+
+    while (TRUE) {
+
+      // rebuilt packets first
+      if (nPending > 0) {
+	pos   = pending[--nPending];
+	shard = pendingBlock->shards + pos * shardMax;
+	n     = shard[0] | (shard[1] << 8);
+	if (hdr != NULL) {
+	  hdr->magic = UDP_FEC_MAGIC;
+	  hdr->k     = pendingBlock->kUsed;
+	  hdr->m     = pendingBlock->m;
+	  hdr->block = pendingBlock->block;
+	  hdr->index = pos;
+	  hdr->flags = UDP_FEC_RECOVERED;
+	  hdr->len   = n;
+	}
+	if (n > bufLen)
+	  n = bufLen;
+	memcpy(buf, shard + 2, n);
+	return n;
+      }
+
+      n = udp->readUDPSocketFrom(recvBuf, sizeof(UDPFecHeader) + shardMax, NULL);
+      if (n <= 0)
+	return n == 0 ? 0 : ERROR;
+
+      n -= sizeof(UDPFecHeader);
+      if (n < 0 || rhdr->magic != UDP_FEC_MAGIC || rhdr->k > k || rhdr->k == 0 ||
+	  rhdr->m > m || rhdr->m == 0 || rhdr->index >= rhdr->k + rhdr->m ||
+	  rhdr->len != n || (rhdr->index < rhdr->k && n > shardMax - 2)) {
+	++nInvalid;
+	continue;
+      }
+
+      if ((b = getUDPFecBlock(rhdr->block)) == NULL) {
+	// a late data packet is still delivered, just not kept for recovery
+	if (rhdr->index < rhdr->k) {
+	  ++nReceived;
+	  ++nLate;
+	  if (hdr != NULL)
+	    *hdr = *rhdr;
+	  if (n > bufLen)
+	    n = bufLen;
+	  memcpy(buf, recvBuf + sizeof(UDPFecHeader), n);
+	  return n;
+	}
+	++nStale;
+	continue;
+      }
+
+      if (rhdr->index < rhdr->k) {
+
+	// a data packet: keep it as shard and deliver it right away
+	if (b->have[rhdr->index]) {
+	  ++nDuplicates;
+	  continue;
+	}
+	shard = b->shards + rhdr->index * shardMax;
+	shard[0] = n & 0xff;
+	shard[1] = n >> 8;
+	memcpy(shard + 2, recvBuf + sizeof(UDPFecHeader), n);
+	b->have[rhdr->index] = TRUE;
+	b->kData = rhdr->k;
+	++b->nData;
+	++nReceived;
+
+	decodeUDPFecBlock(b);
+
+	if (hdr != NULL)
+	  *hdr = *rhdr;
+	if (n > bufLen)
+	  n = bufLen;
+	memcpy(buf, shard + 2, n);
+	return n;
+
+      } else {
+
+	// a parity packet
+	pos = k + rhdr->index - rhdr->k;
+	if (b->have[pos]) {
+	  ++nDuplicates;
+	  continue;
+	}
+	if ((b->kUsed && (b->kUsed != rhdr->k || b->shardLen != n)) ||
+	    n < 2 || n > shardMax) {
+	  ++nInvalid;
+	  continue;
+	}
+	memcpy(b->shards + pos * shardMax, recvBuf + sizeof(UDPFecHeader), n);
+	b->have[pos] = TRUE;
+	b->kUsed     = rhdr->k;
+	b->m         = rhdr->m;
+	b->shardLen  = n;
+	++b->nParity;
+
+	decodeUDPFecBlock(b);
+      }
+    }
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  testUDPFec
+\date  Oct 2026
+
+\remarks
+
+Sends n_packets datagrams over loopback (or to a host given by name) through
+FEC channels of different block sizes with 5% simulated loss, and reports how
+many packets were rebuilt and verified.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     n_packets       : number of packets per configuration
+\param[in]     name            : name or IP address of the receiver
+
+  ******************************************************************************/
+  void
+  testUDPFec(int n_packets, char *name)
+  {
+    static const int configs[][2] = { {8,1}, {8,2}, {16,4}, {4,4} };
+    char             any[1] = "";
+    char             buf[256];
+    char             rbuf[256];
+    UDPFecHeader     hdr;
+    int              c, i, n, len, bad;
+
+    printf("GF(2^8) kernel: %s\n",UDPFecChannel::getUDPFecKernel());
+    printf("   k   m  overhead    lost  recovered  unrecoverable  bad\n");
+
+    for (c=0; c<(int) (sizeof(configs)/sizeof(configs[0])); ++c) {
+      UDP_communication rx_udp, tx_udp;
+      UDPFecChannel     rx, tx;
+
+      rx_udp.makeUDPServer(FEC_TESTPORT,any);
+      tx_udp.makeUDPClient(FEC_TESTPORT,name);
+      if (!rx_udp.active || !tx_udp.active) {
+	printf("Failed to create UDP sockets\n");
+	return;
+      }
+      rx_udp.setUDPNonBlocking(TRUE);
+
+      rx.initUDPFec(&rx_udp,configs[c][0],configs[c][1],sizeof(buf));
+      tx.initUDPFec(&tx_udp,configs[c][0],configs[c][1],sizeof(buf));
+      tx.setUDPFecLoss(0.05,c+1);
+
+      bad = 0;
+      for (i=0; i<=n_packets; ++i) {
+	if (i < n_packets) {
+	  // varying length and content
+	  len = 8 + i % 200;
+	  for (n=0; n<len; ++n)
+	    buf[n] = (char) (i + n);
+	  memcpy(buf, &i, sizeof(i));
+	  tx.writeUDPFec(buf,len);
+	} else {
+	  tx.flushUDPFec();
+	}
+
+	while ((n = rx.readUDPFec(rbuf,sizeof(rbuf),&hdr)) > 0) {
+	  int id;
+	  memcpy(&id, rbuf, sizeof(id));
+	  if (n != 8 + id % 200)
+	    ++bad;
+	  else
+	    for (len=sizeof(id); len<n; ++len)
+	      if (rbuf[len] != (char) (id + len)) {
+		++bad;
+		break;
+	      }
+	}
+      }
+
+      printf("%4d %3d %8.1f%% %7lu %10lu %14lu %4d\n",configs[c][0],configs[c][1],
+	     100.0*configs[c][1]/configs[c][0],
+	     tx.nDataSent - rx.nReceived,rx.nRecovered,
+	     tx.nDataSent - rx.nReceived - rx.nRecovered,bad);
+
+      rx_udp.closeUDPSocket();
+      tx_udp.closeUDPSocket();
+    }
+  }
+
+} // end of namespace
@@ -0,0 +1,483 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_fragment.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  Fragmentation and reassembly of messages that are larger than what fits
+  into a single UDP datagram. Every fragment carries a small header with the
+  message id, fragment index, and offset. The receiver assembles fragments in
+  a fixed number of preallocated slabs, such that no memory is allocated
+  while communicating, and drops messages that are not complete before a
+  deadline.
+
+  The sender can use UDP generic segmentation offload (GSO), such that all
+  fragments of a message leave with one system call, and the receiver can use
+  generic receive offload (GRO), where the kernel hands over several
+  fragments at once.
+
+  ============================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+#include "string.h"
+#include "time.h"
+
+// my utilities library
+#include "utility.h"
+
+#include "udp_fragment.h"
+#include "comm_log.h"
+
+namespace udp_communication {
+
+  using namespace comm_log;
+
+  static uint64_t
+  monotonicTimeNs(void)
+  {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Constructor
+\date  Oct 2026
+
+\remarks
+
+The fragmenter is inactive until initUDPFragmenter() was called.
+
+  ******************************************************************************/
+  UDPFragmenter::
+  UDPFragmenter()
+  {
+    active   = FALSE;
+    udp      = NULL;
+    sendBuf  = NULL;
+    sendMsgs = NULL;
+    slabs    = NULL;
+    nSlabs   = 0;
+    recvBuf  = NULL;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Destructor
+\date  Oct 2026
+
+\remarks
+
+Frees all buffers. The UDP socket is not closed.
+
+  ******************************************************************************/
+  UDPFragmenter::
+  ~UDPFragmenter()
+  {
+    for (int i=0; i<nSlabs; ++i) {
+      free(slabs[i].data);
+      free(slabs[i].received);
+    }
+    free(slabs);
+    free(sendBuf);
+    free(sendMsgs);
+    free(recvBuf);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  initUDPFragmenter
+\date  Oct 2026
+
+\remarks
+
+Allocates all send and reassembly buffers.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     udp             : the UDP socket to communicate with
+\param[in]     max_msg_len     : max. length of a message
+\param[in]     frag_size       : payload bytes per fragment; the datagrams are
+                                 sizeof(UDPFragHeader) bytes larger
+\param[in]     n_slabs         : number of messages that can be reassembled
+                                 concurrently
+\param[in]     timeout         : time in seconds after which an incomplete
+                                 message is dropped
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPFragmenter::
+  initUDPFragmenter(UDP_communication *udp,
+		    int    max_msg_len,
+		    int    frag_size,
+		    int    n_slabs,
+		    double timeout)
+  {
+    int i;
+    int seg;
+
+    if (active) {
+      printf("Fragmenter is already active\n");
+      return FALSE;
+    }
+
+    if (frag_size <= 0 || max_msg_len <= 0 || n_slabs <= 0) {
+      printf("Error: invalid fragmenter parameters\n");
+      return FALSE;
+    }
+
+    maxFrags = (max_msg_len + frag_size - 1) / frag_size;
+    if (maxFrags > 65535) {
+      printf("Error: too many fragments -- increase the fragment size\n");
+      return FALSE;
+    }
+
+    this->udp   = udp;
+    maxMsgLen   = max_msg_len;
+    fragSize    = frag_size;
+    timeoutNs   = (uint64_t) (timeout * 1.e9);
+    useGSO      = FALSE;
+    nextMsgId   = 0;
+    seg         = sizeof(UDPFragHeader) + frag_size;
+
+    sendBuf  = (char *) malloc((size_t) maxFrags * seg);
+    sendMsgs = (UDPMessage *) malloc(maxFrags * sizeof(UDPMessage));
+    recvBuf  = (char *) malloc(UDP_FRAG_RECV_LEN);
+    pendingPos = pendingLen = 0;
+
+    nSlabs      = n_slabs;
+    bitmapWords = (maxFrags + 63) / 64;
+    slabs       = (Slab *) calloc(n_slabs, sizeof(Slab));
+    for (i=0; i<n_slabs; ++i) {
+      slabs[i].state    = SLAB_FREE;
+      slabs[i].data     = (char *) malloc(max_msg_len);
+      slabs[i].received = (uint64_t *) malloc(bitmapWords * sizeof(uint64_t));
+    }
+
+    nMsgsReceived = nMsgsDropped = nFragsReceived = nFragsInvalid = 0;
+    active = TRUE;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  setUDPFragmentOffload
+\date  Oct 2026
+
+\remarks
+
+Enables segmentation offload for sending and/or receive offload for
+receiving, if supported by the kernel.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     gso             : TRUE to send with UDP_SEGMENT
+\param[in]     gro             : TRUE to receive with UDP_GRO
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPFragmenter::
+  setUDPFragmentOffload(int gso, int gro)
+  {
+    if (!active) {
+      printf("Fragmenter not initialized\n");
+      return FALSE;
+    }
+
+    useGSO = gso;
+
+    if (!udp->setUDPGRO(gro))
+      return FALSE;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  writeUDPFragmented
+\date  Oct 2026
+
+\remarks
+
+Splits a message into fragments and sends them, either with segmentation
+offload or with batched sends.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     buf             : the message
+\param[in]     bufLen          : length of the message
+
+returns the number of message bytes written, or FALSE on error
+
+  ******************************************************************************/
+  int UDPFragmenter::
+  writeUDPFragmented(char *buf,
+		     int   bufLen)
+  {
+    UDPFragHeader *hdr;
+    int            n_frags;
+    int            seg;
+    int            len;
+    int            total;
+    int            i, n, n_group;
+
+    if (!active) {
+      logCommEvent(COMM_EV_CHANNEL_NOT_ACTIVE,0);
+      return FALSE;
+    }
+
+    if (bufLen > maxMsgLen) {
+      logCommEvent(COMM_EV_CHANNEL_INVALID_LENGTH,0,bufLen,maxMsgLen);
+      return FALSE;
+    }
+
+    n_frags = bufLen > 0 ? (bufLen + fragSize - 1) / fragSize : 1;
+    seg     = sizeof(UDPFragHeader) + fragSize;
+
+    // stage all fragments back to back, only the last one can be shorter
+    total = 0;
+    for (i=0; i<n_frags; ++i) {
+      len = bufLen - i*fragSize;
+      if (len > fragSize)
+	len = fragSize;
+
+      hdr = (UDPFragHeader *) (sendBuf + total);
+      hdr->magic      = UDP_FRAG_MAGIC;
+      hdr->frag_index = i;
+      hdr->n_frags    = n_frags;
+      hdr->reserved   = 0;
+      hdr->msg_id     = nextMsgId;
+      hdr->msg_len    = bufLen;
+      hdr->offset     = i*fragSize;
+      memcpy(sendBuf + total + sizeof(UDPFragHeader), buf + i*fragSize, len);
+
+      sendMsgs[i].buf    = sendBuf + total;
+      sendMsgs[i].bufLen = sizeof(UDPFragHeader) + len;
+      total += sendMsgs[i].bufLen;
+    }
+    ++nextMsgId;
+
+    // with GSO, the kernel cuts the staging area into the fragments
+    n_group = UDP_GSO_MAX_BYTES / seg;
+    if (n_group > UDP_GSO_MAX_SEGS)
+      n_group = UDP_GSO_MAX_SEGS;
+
+    if (useGSO && n_frags > 1 && n_group > 1) {
+      for (i=0; i<n_frags; i+=n_group) {
+	n   = n_frags - i < n_group ? n_frags - i : n_group;
+	len = (int) (sendMsgs[i+n-1].buf + sendMsgs[i+n-1].bufLen - sendMsgs[i].buf);
+	if (udp->writeUDPSocketSegmented(sendMsgs[i].buf, len, seg) != len) {
+	  logCommEvent(COMM_EV_UDP_GSO_FAILED,0,udp->getUDPSocketFd());
+	  useGSO = FALSE;
+	  break;
+	}
+      }
+      if (useGSO)
+	return bufLen;
+    }
+
+    for (i=0; i<n_frags; i+=n) {
+      n = udp->writeUDPSocketBatch(&sendMsgs[i], n_frags - i);
+      if (n <= 0)
+	return FALSE;
+    }
+
+    return bufLen;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  processFragment
+\date  Oct 2026
+
+\remarks
+
+Adds a fragment to its reassembly slab.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     frag            : the fragment datagram
+\param[in]     len             : length of the datagram
+\param[in]     peer            : the sender
+
+returns the index of the slab if the message is complete, otherwise ERROR
+
+  ******************************************************************************/
+  int UDPFragmenter::
+  processFragment(char *frag, int len, UDPEndpoint *peer)
+  {
+    UDPFragHeader *hdr = (UDPFragHeader *) frag;
+    Slab          *slab;
+    uint64_t       now;
+    int            chunk;
+    int            i;
+    int            s = ERROR;
+    int            oldest = ERROR;
+
+    chunk = len - (int) sizeof(UDPFragHeader);
+    if (chunk < 0 || hdr->magic != UDP_FRAG_MAGIC || hdr->n_frags == 0 ||
+	hdr->n_frags > maxFrags || hdr->frag_index >= hdr->n_frags ||
+	hdr->msg_len > (uint32_t) maxMsgLen || hdr->offset > hdr->msg_len ||
+	(uint32_t) chunk > hdr->msg_len - hdr->offset) {
+      ++nFragsInvalid;
+      return ERROR;
+    }
+    ++nFragsReceived;
+
+    // expire incomplete messages, and look for the slab of this message
+    now = monotonicTimeNs();
+    for (i=0; i<nSlabs; ++i) {
+      if (slabs[i].state != SLAB_ASSEMBLING)
+	continue;
+      if (slabs[i].deadline_ns < now) {
+	slabs[i].state = SLAB_FREE;
+	++nMsgsDropped;
+	continue;
+      }
+      if (slabs[i].msg_id == hdr->msg_id && slabs[i].peer.addr == peer->addr &&
+	  slabs[i].peer.port == peer->port)
+	s = i;
+    }
+
+    // a new message: take a free slab, or give up the oldest incomplete one
+    if (s == ERROR) {
+      for (i=0; i<nSlabs; ++i) {
+	if (slabs[i].state == SLAB_FREE) {
+	  s = i;
+	  break;
+	}
+	if (slabs[i].state == SLAB_ASSEMBLING &&
+	    (oldest == ERROR || slabs[i].deadline_ns < slabs[oldest].deadline_ns))
+	  oldest = i;
+      }
+      if (s == ERROR) {
+	if (oldest == ERROR)
+	  return ERROR;
+	s = oldest;
+	++nMsgsDropped;
+      }
+
+      slab = &slabs[s];
+      slab->state       = SLAB_ASSEMBLING;
+      slab->msg_id      = hdr->msg_id;
+      slab->peer        = *peer;
+      slab->n_frags     = hdr->n_frags;
+      slab->n_received  = 0;
+      slab->msg_len     = hdr->msg_len;
+      slab->deadline_ns = now + timeoutNs;
+      bzero((char *) slab->received, bitmapWords * sizeof(uint64_t));
+    }
+
+    slab = &slabs[s];
+
+    // all fragments of a message need to agree on its layout
+    if ((int) hdr->n_frags != slab->n_frags || (int) hdr->msg_len != slab->msg_len) {
+      ++nFragsInvalid;
+      return ERROR;
+    }
+
+    // ignore duplicates
+    if (slab->received[hdr->frag_index / 64] & (1ULL << (hdr->frag_index % 64)))
+      return ERROR;
+    slab->received[hdr->frag_index / 64] |= 1ULL << (hdr->frag_index % 64);
+
+    memcpy(slab->data + hdr->offset, frag + sizeof(UDPFragHeader), chunk);
+
+    if (++slab->n_received < slab->n_frags)
+      return ERROR;
+
+    slab->state = SLAB_DELIVERED;
+    ++nMsgsReceived;
+
+    return s;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPFragmented
+\date  Oct 2026
+
+\remarks
+
+Reads fragments until a message is complete. On a blocking socket, this
+waits for the next complete message, on a non-blocking socket, 0 is returned
+if no message could be completed with the available data. The message is
+returned in place, i.e., msg points into an internal slab which stays valid
+until the next call of readUDPFragmented().
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[out]    msg             : pointer to the reassembled message
+\param[out]    peer            : the sender -- pass NULL if not needed
+
+returns the length of the message, 0 if none is complete, or ERROR
+
+  ******************************************************************************/
+  int UDPFragmenter::
+  readUDPFragmented(char       **msg,
+		    UDPEndpoint *peer)
+  {
+    int n;
+    int seg;
+    int s;
+
+    if (!active) {
+      logCommEvent(COMM_EV_CHANNEL_NOT_ACTIVE,0);
+      return ERROR;
+    }
+
+    // release the message returned by the previous call
+    for (s=0; s<nSlabs; ++s)
+      if (slabs[s].state == SLAB_DELIVERED)
+	slabs[s].state = SLAB_FREE;
+
+    while (TRUE) {
+
+      if (pendingPos >= pendingLen) {
+	n = udp->readUDPSocketSegmented(recvBuf, UDP_FRAG_RECV_LEN, &pendingPeer,
+					&pendingSegSize);
+	if (n <= 0)
+	  return n;
+	pendingPos = 0;
+	pendingLen = n;
+      }
+
+      // a GRO buffer may hold several fragments
+      while (pendingPos < pendingLen) {
+	seg = pendingLen - pendingPos;
+	if (seg > pendingSegSize)
+	  seg = pendingSegSize;
+
+	s = processFragment(recvBuf + pendingPos, seg, &pendingPeer);
+	pendingPos += seg;
+
+	if (s != ERROR) {
+	  *msg = slabs[s].data;
+	  if (peer != NULL)
+	    *peer = slabs[s].peer;
+	  return slabs[s].msg_len;
+	}
+      }
+
+    }
+
+  }
+
+} // end of namespace
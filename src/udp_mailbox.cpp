@@ -0,0 +1,312 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_mailbox.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  A latest-value mailbox for a UDP_communication server socket. A background
+  thread drains the socket continuously and publishes only the newest datagram
+  into a triple buffer. The control loop reads the mailbox wait-free and
+  always gets the most recent state, together with its age and the number of
+  datagrams that were overwritten before anybody read them.
+
+  ============================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+#include "unistd.h"
+#include "string.h"
+#include "errno.h"
+#include "poll.h"
+#include "time.h"
+#include "sys/eventfd.h"
+
+// my utilities library
+#include "utility.h"
+
+#include "udp_mailbox.h"
+#include "comm_log.h"
+
+#define FRESH 4     //!< flag in middle: slot was published but not yet read
+
+namespace udp_communication {
+
+  using namespace comm_log;
+
+  static uint64_t
+  monotonicTimeNs(void)
+  {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Constructor
+\date  Oct 2026
+
+\remarks
+
+The mailbox is inactive until startUDPMailbox() was called.
+
+  ******************************************************************************/
+  UDPMailbox::
+  UDPMailbox()
+  {
+    active   = FALSE;
+    running.store(false);
+    udp      = NULL;
+    wakeupFd = ERROR;
+    for (int i=0; i<3; ++i)
+      slots[i].data = NULL;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Destructor
+\date  Oct 2026
+
+\remarks
+
+Stops the receive thread if still running.
+
+  ******************************************************************************/
+  UDPMailbox::
+  ~UDPMailbox()
+  {
+    if (active)
+      stopUDPMailbox();
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  startUDPMailbox
+\date  Oct 2026
+
+\remarks
+
+Switches the socket to non-blocking mode and starts the receive thread. From
+now on, the socket must only be read through readUDPMailbox().
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     udp             : the (server) UDP socket to receive from
+\param[in]     max_msg_len     : max. datagram size
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPMailbox::
+  startUDPMailbox(UDP_communication *udp,
+		  int max_msg_len)
+  {
+    if (active) {
+      printf("Mailbox is already active\n");
+      return FALSE;
+    }
+
+    if (!udp->active) {
+      printf("Socket not initialized\n");
+      return FALSE;
+    }
+
+    if ((wakeupFd = eventfd(0, EFD_CLOEXEC)) == ERROR) {
+      printf("Error: could not create wakeup event (errno=%d)\n",errno);
+      return FALSE;
+    }
+
+    this->udp = udp;
+    maxMsgLen = max_msg_len;
+    for (int i=0; i<3; ++i) {
+      slots[i].data = (char *) malloc(max_msg_len);
+      slots[i].len  = ERROR;
+      slots[i].seq  = 0;
+      slots[i].t_ns = 0;
+    }
+    middle.store(0);
+    back  = 1;
+    front = 2;
+    seq   = 0;
+    nOverwritten.store(0);
+
+    udp->setUDPNonBlocking(TRUE);
+
+    active = TRUE;
+    running.store(true);
+    thread = std::thread(&UDPMailbox::receiveLoop, this);
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  stopUDPMailbox
+\date  Oct 2026
+
+\remarks
+
+Stops the receive thread and frees the buffers.
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPMailbox::
+  stopUDPMailbox(void)
+  {
+    uint64_t one = 1;
+
+    if (!active) {
+      printf("Mailbox not initialized\n");
+      return FALSE;
+    }
+
+    active = FALSE;
+    running.store(false);
+    if (write(wakeupFd, &one, sizeof(one)) < 0)
+      printf("Error: could not wake up receive thread (errno=%d)\n",errno);
+    thread.join();
+
+    close(wakeupFd);
+    wakeupFd = ERROR;
+    for (int i=0; i<3; ++i) {
+      free(slots[i].data);
+      slots[i].data = NULL;
+    }
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  receiveLoop
+\date  Oct 2026
+
+\remarks
+
+The receive thread: waits for data, drains the socket with batched reads, and
+publishes the newest datagram of each batch.
+
+  ******************************************************************************/
+  void UDPMailbox::
+  receiveLoop(void)
+  {
+    UDPMessage     msgs[UDP_MAX_BATCH];
+    char          *bufs;
+    struct pollfd  fds[2];
+    int            n_msgs;
+    int            prev;
+    Slot          *slot;
+
+    bufs = (char *) malloc((size_t) UDP_MAX_BATCH * maxMsgLen);
+    for (int i=0; i<UDP_MAX_BATCH; ++i) {
+      msgs[i].buf    = bufs + (size_t) i * maxMsgLen;
+      msgs[i].bufLen = maxMsgLen;
+    }
+
+    fds[0].fd     = udp->getUDPSocketFd();
+    fds[0].events = POLLIN;
+    fds[1].fd     = wakeupFd;
+    fds[1].events = POLLIN;
+
+    while (running.load()) {
+
+      if (poll(fds, 2, -1) == ERROR && errno != EINTR)
+	break;
+
+      while ((n_msgs = udp->readUDPSocketBatch(msgs, UDP_MAX_BATCH)) > 0) {
+
+	// all but the newest message of the batch are never seen
+	seq += n_msgs;
+	if (n_msgs > 1)
+	  nOverwritten.fetch_add(n_msgs - 1, std::memory_order_relaxed);
+
+	slot = &slots[back];
+	slot->len = msgs[n_msgs-1].msgLen;
+	memcpy(slot->data, msgs[n_msgs-1].buf, slot->len);
+	slot->addr = msgs[n_msgs-1].addr;
+	slot->seq  = seq;
+	slot->t_ns = monotonicTimeNs();
+
+	// publish, and take over the previous middle slot
+	prev = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+	back = prev & ~FRESH;
+	if (prev & FRESH)
+	  nOverwritten.fetch_add(1, std::memory_order_relaxed);
+      }
+
+    }
+
+    free(bufs);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPMailbox
+\date  Oct 2026
+
+\remarks
+
+Returns the newest datagram received so far. This never blocks and never
+makes a system call. If no new datagram arrived since the last call, the
+previous one is returned again with info->is_new = FALSE.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[out]    buf             : data buffer
+\param[in]     bufLen          : length of data buffer
+\param[out]    info            : age, sequence number etc. of the message --
+                                 pass NULL if not needed
+
+returns the number of bytes in buf, or ERROR if nothing was received yet
+
+  ******************************************************************************/
+  int UDPMailbox::
+  readUDPMailbox(char           *buf,
+		 int             bufLen,
+		 UDPMailboxInfo *info)
+  {
+    bool  is_new = FALSE;
+    int   prev;
+    int   len;
+    Slot *slot;
+
+    if (!active) {
+      logCommEvent(COMM_EV_CHANNEL_NOT_ACTIVE,0);
+      return ERROR;
+    }
+
+    if (middle.load(std::memory_order_relaxed) & FRESH) {
+      prev   = middle.exchange(front, std::memory_order_acq_rel);
+      front  = prev & ~FRESH;
+      is_new = TRUE;
+    }
+
+    slot = &slots[front];
+    if (slot->len == ERROR)
+      return ERROR;
+
+    len = slot->len < bufLen ? slot->len : bufLen;
+    memcpy(buf, slot->data, len);
+
+    if (info != NULL) {
+      info->age           = (monotonicTimeNs() - slot->t_ns) * 1.e-9;
+      info->seq           = slot->seq;
+      info->n_overwritten = nOverwritten.load(std::memory_order_relaxed);
+      info->is_new        = is_new;
+      info->addr          = slot->addr;
+    }
+
+    return len;
+  }
+
+} // end of namespace
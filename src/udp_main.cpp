@@ -22,6 +22,7 @@
 /* local headers */
 #include "utility.h"
 #include "udp_communication.h"
+#include "udp_fec.h"
   
 /* local functions */
 
@@ -55,7 +56,7 @@ main(int argc, char**argv)
   if (argc == 2 && argv[1][1] == 's') {
     name[0]='\0';
   } else if (argc < 3) {
-    printf("Usage: xudpTest [-s | -c] [hostName | hostIP] [n_bytes]\n");
+    printf("Usage: xudpTest [-s | -c | -l | -f] [hostName | hostIP] [n_bytes]\n");
     return FALSE;
   } else {
     strcpy(name,&(argv[2][0]));
@@ -72,8 +73,20 @@ main(int argc, char**argv)
     testUDPClient(n_bytes,name);
     break;
 
+  case 'l':
+    if (argc == 4)
+      sscanf(&(argv[3][0]),"%d",&n_bytes);
+    testUDPSendLatency(n_bytes,name);
+    break;
+
+  case 'f':
+    if (argc == 4)
+      sscanf(&(argv[3][0]),"%d",&n_bytes);
+    testUDPFec(n_bytes,name);
+    break;
+
   default:
-    printf("Pass -s for server, or -c for client communication\n");
+    printf("Pass -s for server, -c for client communication, -l for send latency, or -f for FEC\n");
   }
 	
   return TRUE;
@@ -0,0 +1,302 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_paced.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  Rate-paced sending. A relative sleep between two datagrams accumulates the
+  send time and the wake up latency, such that the stream drifts slower than
+  intended and jitters. The paced sender instead sleeps until absolute
+  deadlines on CLOCK_MONOTONIC (clock_nanosleep with TIMER_ABSTIME), which
+  keeps the long-term rate exact. Deadlines that have already passed are
+  counted as misses; if the sender falls behind by more than a period, the
+  missed periods are skipped rather than sent in a burst.
+
+  For bursty traffic, a token bucket limits the average byte rate and the
+  burst size, such that a burst does not overflow the receive buffer of the
+  peer.
+
+  ============================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+#include "errno.h"
+#include "time.h"
+
+// my utilities library
+#include "utility.h"
+
+#include "udp_paced.h"
+
+namespace udp_communication {
+
+  static uint64_t
+  monotonicTimeNs(void)
+  {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Constructor
+\date  Oct 2026
+
+\remarks
+
+The pacer is inactive until initUDPPacer() was called.
+
+  ******************************************************************************/
+  UDPPacedSender::
+  UDPPacedSender()
+  {
+    active     = FALSE;
+    udp        = NULL;
+    bucketRate = 0;
+  }
+
+  UDPPacedSender::
+  ~UDPPacedSender()
+  {
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  initUDPPacer
+\date  Oct 2026
+
+\remarks
+
+Sets the rate of the pacer. The first deadline is one period from now.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     udp             : the socket to send with
+\param[in]     rate            : datagrams per second -- pass 0 if only the
+                                 token bucket is used
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPPacedSender::
+  initUDPPacer(UDP_communication *udp,
+	       double rate)
+  {
+    if (rate < 0) {
+      printf("Error: invalid pacing rate\n");
+      return FALSE;
+    }
+
+    this->udp       = udp;
+    periodNs        = rate > 0 ? (uint64_t) (1.e9 / rate + 0.5) : 0;
+    nextDeadlineNs  = monotonicTimeNs() + periodNs;
+    nPeriods        = 0;
+    nDeadlineMisses = 0;
+    nSkippedPeriods = 0;
+    maxLateness     = 0;
+    nShaped         = 0;
+
+    active = TRUE;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  setUDPTokenBucket
+\date  Oct 2026
+
+\remarks
+
+Enables token bucket shaping for writeUDPShaped(): the bucket fills with
+bytes_per_s, holds at most burst_bytes, and every datagram takes its length
+from the bucket. The bucket starts full.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     bytes_per_s     : average rate -- pass 0 to disable shaping
+\param[in]     burst_bytes     : max. burst, at least the largest datagram
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPPacedSender::
+  setUDPTokenBucket(double bytes_per_s,
+		    double burst_bytes)
+  {
+    if (bytes_per_s < 0 || (bytes_per_s > 0 && burst_bytes <= 0)) {
+      printf("Error: invalid token bucket parameters\n");
+      return FALSE;
+    }
+
+    bucketRate   = bytes_per_s;
+    bucketBurst  = burst_bytes;
+    tokens       = burst_bytes;
+    lastRefillNs = monotonicTimeNs();
+
+    return TRUE;
+  }
+
+  void UDPPacedSender::
+  sleepUntil(uint64_t t_ns)
+  {
+    struct timespec ts;
+
+    ts.tv_sec  = t_ns / 1000000000ULL;
+    ts.tv_nsec = t_ns % 1000000000ULL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+      ;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  waitUDPPacer
+\date  Oct 2026
+
+\remarks
+
+Sleeps until the next deadline, and advances the deadline by one period. If
+the deadline has passed already, this is counted as a miss and returns
+immediately; if more than a whole period has passed, the deadline moves to
+the next multiple of the period in the future, such that the phase of the
+stream is kept.
+
+returns TRUE if the deadline was met, FALSE if it was missed
+
+  ******************************************************************************/
+  int UDPPacedSender::
+  waitUDPPacer(void)
+  {
+    uint64_t now;
+    uint64_t n_behind;
+    double   lateness;
+    int      met = TRUE;
+
+    if (!active) {
+      printf("Pacer not initialized\n");
+      return FALSE;
+    }
+
+    ++nPeriods;
+    now = monotonicTimeNs();
+
+    if (now < nextDeadlineNs) {
+      sleepUntil(nextDeadlineNs);
+      lateness = (int64_t) (monotonicTimeNs() - nextDeadlineNs) * 1.e-9;
+      if (lateness > maxLateness)
+	maxLateness = lateness;
+    } else {
+      ++nDeadlineMisses;
+      met = FALSE;
+      if (periodNs > 0 && now - nextDeadlineNs >= periodNs) {
+	n_behind = (now - nextDeadlineNs) / periodNs;
+	nSkippedPeriods += n_behind;
+	nextDeadlineNs  += n_behind * periodNs;
+      }
+    }
+
+    nextDeadlineNs += periodNs;
+
+    return met;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  writeUDPPaced
+\date  Oct 2026
+
+\remarks
+
+Waits for the next deadline and sends a datagram.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     buf             : data buffer
+\param[in]     bufLen          : length of data buffer
+
+returns the number of bytes written
+
+  ******************************************************************************/
+  int UDPPacedSender::
+  writeUDPPaced(char *buf,
+		int   bufLen)
+  {
+    if (!active) {
+      printf("Pacer not initialized\n");
+      return FALSE;
+    }
+
+    waitUDPPacer();
+
+    return udp->writeUDPSocket(buf,bufLen);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  writeUDPShaped
+\date  Oct 2026
+
+\remarks
+
+Sends a datagram as soon as the token bucket holds enough bytes for it.
+Without a token bucket, the datagram is sent immediately.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     buf             : data buffer
+\param[in]     bufLen          : length of data buffer
+
+returns the number of bytes written
+
+  ******************************************************************************/
+  int UDPPacedSender::
+  writeUDPShaped(char *buf,
+		 int   bufLen)
+  {
+    uint64_t now;
+
+    if (!active) {
+      printf("Pacer not initialized\n");
+      return FALSE;
+    }
+
+    if (bucketRate > 0) {
+      if (bufLen > bucketBurst) {
+	printf("Error: datagram larger than the token bucket\n");
+	return FALSE;
+      }
+
+      now     = monotonicTimeNs();
+      tokens += (now - lastRefillNs) * 1.e-9 * bucketRate;
+      if (tokens > bucketBurst)
+	tokens = bucketBurst;
+      lastRefillNs = now;
+
+      // sleep until the missing tokens have accumulated
+      if (tokens < bufLen) {
+	++nShaped;
+	now += (uint64_t) ((bufLen - tokens) / bucketRate * 1.e9) + 1;
+	sleepUntil(now);
+	tokens = bufLen;
+	lastRefillNs = now;
+      }
+
+      tokens -= bufLen;
+    }
+
+    return udp->writeUDPSocket(buf,bufLen);
+  }
+
+} // end of namespace
@@ -0,0 +1,620 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_redundant.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  Redundant sending over several paths: every datagram is sent with the same
+  sequenced header (see udp_sequenced.h) over each path, e.g., two client
+  sockets that address the receiver on two interfaces, such that the routing
+  takes different links. The receiver delivers whichever copy arrives first
+  and discards the others. This hides the loss of a single link and its
+  latency spikes without any retransmission delay.
+
+  Duplicates are detected with a sliding window bitmap per stream. Each
+  64 bit word of the window holds a tag (sequence number / 32) in the upper
+  half and the received bits of these 32 sequence numbers in the lower half,
+  and is updated with compare-and-swap only. Thus, one thread per path can
+  call readUDPRedundantPath() concurrently without locks, or a single thread
+  polls all paths with readUDPRedundant().
+
+  Every sender picks a random epoch at start. A new epoch on a stream means
+  the sender restarted and counts from 0 again: the receiver increments the
+  generation of the stream, which is part of every tag, such that the words
+  of the old sequence are recycled as they are hit instead of making the new
+  sequence look too old. Late copies of the previous epoch are discarded.
+
+  ============================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+#include "string.h"
+#include "time.h"
+#include "poll.h"
+#include "errno.h"
+#include "unistd.h"
+
+// my utilities library
+#include "utility.h"
+
+#include "udp_redundant.h"
+#include "comm_log.h"
+
+#define TAG_MASK   0xFFFFFFU   // seq/32 modulo 2^24 in the tag of a window word
+#define GEN_MASK   0xFFU       // generation in the tag and the epoch state
+#define PREV_MASK  0xFFFFFFU   // bits of the previous epoch in the epoch state
+
+namespace udp_communication {
+
+  using namespace comm_log;
+
+  enum { SEQ_TOO_OLD = -1, SEQ_DUPLICATE = 0, SEQ_FIRST = 1 };
+
+  static uint64_t
+  realtimeNs(void)
+  {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+
+  static uint64_t
+  monotonicTimeNs(void)
+  {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Constructor
+\date  Oct 2026
+
+\remarks
+
+The channel is inactive until initUDPRedundant() was called.
+
+  ******************************************************************************/
+  UDPRedundantChannel::
+  UDPRedundantChannel()
+  {
+    active     = FALSE;
+    nPaths     = 0;
+    nextPath   = 0;
+    maxStreams = 0;
+    nextSeq    = NULL;
+    epochs     = NULL;
+    window     = NULL;
+    for (int i=0; i<UDP_REDUNDANT_MAX_PATHS; ++i) {
+      paths[i]       = NULL;
+      nSendErrors[i] = 0;
+      nFirst[i].store(0);
+    }
+    nDelivered.store(0);
+    nDuplicates.store(0);
+    nTooOld.store(0);
+    nRestarts.store(0);
+    nInvalid.store(0);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Destructor
+\date  Oct 2026
+
+\remarks
+
+Frees all buffers. The UDP sockets are not closed.
+
+  ******************************************************************************/
+  UDPRedundantChannel::
+  ~UDPRedundantChannel()
+  {
+    delete [] nextSeq;
+    delete [] epochs;
+    delete [] window;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  initUDPRedundant
+\date  Oct 2026
+
+\remarks
+
+Sets up a channel over n_paths sockets. On the sending side, these are client
+sockets to the same receiver over different interfaces or routes; on the
+receiving side, server sockets on the corresponding interfaces. A channel may
+be used for both directions.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     paths           : array of n_paths active sockets
+\param[in]     n_paths         : number of paths, at most UDP_REDUNDANT_MAX_PATHS
+\param[in]     max_streams     : stream ids are 0 ... max_streams-1
+\param[in]     max_msg_len     : max. payload length of a datagram
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPRedundantChannel::
+  initUDPRedundant(UDP_communication **paths,
+		   int n_paths,
+		   int max_streams,
+		   int max_msg_len)
+  {
+    struct timespec ts;
+    int             i;
+
+    if (active) {
+      printf("Redundant channel is already active\n");
+      return FALSE;
+    }
+
+    if (n_paths <= 0 || n_paths > UDP_REDUNDANT_MAX_PATHS) {
+      printf("Error: invalid number of paths\n");
+      return FALSE;
+    }
+
+    if (max_streams <= 0 || max_streams > 65536) {
+      printf("Error: invalid number of streams\n");
+      return FALSE;
+    }
+
+    for (i=0; i<n_paths; ++i) {
+      if (paths[i] == NULL || !paths[i]->active) {
+	printf("Error: path %d is not an active socket\n",i);
+	return FALSE;
+      }
+    }
+
+    nPaths     = n_paths;
+    maxStreams = max_streams;
+    maxMsgLen  = max_msg_len;
+    nextSeq    = new uint32_t[max_streams];
+    epochs     = new std::atomic<uint64_t>[max_streams];
+    window     = new std::atomic<uint64_t>[max_streams*UDP_REDUNDANT_WORDS];
+    for (i=0; i<n_paths; ++i)
+      this->paths[i] = paths[i];
+
+    // a different epoch for every start of the sender
+    clock_gettime(CLOCK_REALTIME, &ts);
+    epoch = (uint32_t) (ts.tv_sec * 2654435761U) ^ (uint32_t) ts.tv_nsec
+      ^ ((uint32_t) getpid() << 16);
+    if ((epoch & PREV_MASK) == 0)
+      epoch |= 1;
+
+    for (i=0; i<max_streams; ++i) {
+      nextSeq[i] = 0;
+      epochs[i].store(0, std::memory_order_relaxed);
+      for (int j=0; j<UDP_REDUNDANT_WORDS; ++j)
+	window[i*UDP_REDUNDANT_WORDS+j].store(0, std::memory_order_relaxed);
+    }
+
+    active = TRUE;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  resetUDPRedundantStream
+\date  Oct 2026
+
+\remarks
+
+Clears the deduplication window of a stream, such that the next datagram is
+accepted whatever its epoch and sequence number. Sender restarts are detected
+by their epoch and need no reset. May run concurrently with reads: the window
+is not cleared, but starts a new generation.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     stream_id       : the stream
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPRedundantChannel::
+  resetUDPRedundantStream(int stream_id)
+  {
+    std::atomic<uint64_t> *st;
+    uint64_t               old, next;
+
+    if (!active || stream_id < 0 || stream_id >= maxStreams) {
+      printf("Error: invalid stream id\n");
+      return FALSE;
+    }
+
+    // no current epoch, and a new generation
+    st  = &epochs[stream_id];
+    old = st->load(std::memory_order_acquire);
+    do {
+      next = (old & (PREV_MASK << 8)) | ((old + 1) & GEN_MASK);
+    } while (!st->compare_exchange_weak(old, next, std::memory_order_acq_rel,
+					std::memory_order_acquire));
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  writeUDPRedundant
+\date  Oct 2026
+
+\remarks
+
+Sends a datagram with the next sequence number of the stream over all paths.
+All copies carry the same header.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     stream_id       : the stream
+\param[in]     buf             : payload
+\param[in]     bufLen          : length of payload
+
+returns the number of payload bytes written if at least one path succeeded,
+or FALSE on error
+
+  ******************************************************************************/
+  int UDPRedundantChannel::
+  writeUDPRedundant(int   stream_id,
+		    char *buf,
+		    int   bufLen)
+  {
+    UDPRedundantHeader hdr;
+    struct iovec       iov[2];
+    int                n_sent = 0;
+    int                i;
+
+    if (!active) {
+      logCommEvent(COMM_EV_CHANNEL_NOT_ACTIVE,0);
+      return FALSE;
+    }
+
+    if (stream_id < 0 || stream_id >= maxStreams) {
+      logCommEvent(COMM_EV_CHANNEL_INVALID_STREAM,0,stream_id);
+      return FALSE;
+    }
+
+    if (bufLen > maxMsgLen) {
+      logCommEvent(COMM_EV_CHANNEL_INVALID_LENGTH,0,bufLen,maxMsgLen);
+      return FALSE;
+    }
+
+    hdr.seq.magic     = UDP_SEQ_MAGIC;
+    hdr.seq.stream_id = stream_id;
+    hdr.seq.seq       = nextSeq[stream_id]++;
+    hdr.seq.send_ns   = realtimeNs();
+    hdr.epoch         = epoch;
+    hdr.reserved      = 0;
+
+    iov[0].iov_base = &hdr;
+    iov[0].iov_len  = sizeof(UDPRedundantHeader);
+    iov[1].iov_base = buf;
+    iov[1].iov_len  = bufLen;
+
+    for (i=0; i<nPaths; ++i) {
+      if (paths[i]->writeUDPSocketV(iov, 2) == (int) sizeof(UDPRedundantHeader) + bufLen)
+	++n_sent;
+      else
+	++nSendErrors[i];
+    }
+
+    return n_sent > 0 ? bufLen : FALSE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  acceptUDPEpoch
+\date  Oct 2026
+
+\remarks
+
+Checks the epoch of a datagram against the current epoch of its stream. A new
+epoch, other than the previous one, becomes the current epoch with a new
+generation of the window; datagrams of the previous epoch are late copies
+from before the restart of the sender.
+
+returns TRUE with the generation of the epoch in gen, or FALSE if the datagram
+belongs to the previous epoch
+
+  ******************************************************************************/
+  int UDPRedundantChannel::
+  acceptUDPEpoch(int stream_id, uint32_t epoch, uint32_t *gen)
+  {
+    std::atomic<uint64_t> *st;
+    uint64_t               old, next;
+    uint32_t               cur;
+
+    st  = &epochs[stream_id];
+    old = st->load(std::memory_order_acquire);
+    do {
+      cur = (uint32_t) (old >> 32);
+      if (cur == epoch) {
+	*gen = (uint32_t) old & GEN_MASK;
+	return TRUE;
+      }
+      if (((old >> 8) & PREV_MASK) == (epoch & PREV_MASK))
+	return FALSE;
+      next = ((uint64_t) epoch << 32) | ((uint64_t) (cur & PREV_MASK) << 8)
+	| ((old + 1) & GEN_MASK);
+    } while (!st->compare_exchange_weak(old, next, std::memory_order_acq_rel,
+					std::memory_order_acquire));
+
+    if (cur != 0)
+      nRestarts.fetch_add(1, std::memory_order_relaxed);
+    *gen = (uint32_t) next & GEN_MASK;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  acceptUDPSeq
+\date  Oct 2026
+
+\remarks
+
+Marks a sequence number as received in the window of its stream. The word
+of the sequence number either carries its tag already, then the bit decides,
+or an older tag, then the word is recycled for the new tag. A word with a
+newer tag means the sequence number dropped out of the window. A word of
+another generation is recycled if gen is still the current generation of the
+stream, and otherwise the datagram is too old.
+
+returns SEQ_FIRST, SEQ_DUPLICATE, or SEQ_TOO_OLD
+
+  ******************************************************************************/
+  int UDPRedundantChannel::
+  acceptUDPSeq(int stream_id, uint32_t seq, uint32_t gen)
+  {
+    std::atomic<uint64_t> *w;
+    uint64_t               old, next;
+    uint32_t               tag, otag;
+    uint64_t               bit;
+
+    tag = (gen << 24) | ((seq >> 5) & TAG_MASK);
+    bit = 1ULL << (seq & 31);
+    w   = &window[stream_id*UDP_REDUNDANT_WORDS + (seq >> 5) % UDP_REDUNDANT_WORDS];
+
+    old = w->load(std::memory_order_acquire);
+    do {
+      otag = (uint32_t) (old >> 32);
+      if (otag == tag) {
+	if (old & bit)
+	  return SEQ_DUPLICATE;
+	next = old | bit;
+      } else if ((otag >> 24) != gen) {
+	if ((epochs[stream_id].load(std::memory_order_acquire) & GEN_MASK) != gen)
+	  return SEQ_TOO_OLD;
+	next = ((uint64_t) tag << 32) | bit;
+      } else if (((tag - otag) & TAG_MASK) <= TAG_MASK/2) {
+	next = ((uint64_t) tag << 32) | bit;
+      } else {
+	return SEQ_TOO_OLD;
+      }
+    } while (!w->compare_exchange_weak(old, next, std::memory_order_acq_rel,
+				       std::memory_order_acquire));
+
+    return SEQ_FIRST;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPRedundantOnce
+\date  Oct 2026
+
+\remarks
+
+Reads one datagram from a path and classifies it. The payload is scattered
+directly into buf, but only a first copy is delivered, with its payload
+length returned in len; otherwise, len is set to ERROR and the content of buf
+is undefined.
+
+returns the number of bytes read from the socket, 0 if no data on a
+non-blocking socket, or ERROR
+
+  ******************************************************************************/
+  int UDPRedundantChannel::
+  readUDPRedundantOnce(int           path,
+		       char         *buf,
+		       int           bufLen,
+		       UDPSeqHeader *hdr,
+		       int          *len)
+  {
+    UDPRedundantHeader rhdr;
+    struct iovec       iov[2];
+    uint32_t           gen;
+    int                n;
+    int                rc;
+
+    *len = ERROR;
+
+    iov[0].iov_base = &rhdr;
+    iov[0].iov_len  = sizeof(UDPRedundantHeader);
+    iov[1].iov_base = buf;
+    iov[1].iov_len  = bufLen < maxMsgLen ? bufLen : maxMsgLen;
+
+    n = paths[path]->readUDPSocketV(iov, 2, NULL);
+    if (n <= 0)
+      return n == 0 ? 0 : ERROR;
+
+    if (n < (int) sizeof(UDPRedundantHeader) || rhdr.seq.magic != UDP_SEQ_MAGIC ||
+	rhdr.seq.stream_id >= maxStreams || (rhdr.epoch & PREV_MASK) == 0) {
+      nInvalid.fetch_add(1, std::memory_order_relaxed);
+      return n;
+    }
+
+    if (acceptUDPEpoch(rhdr.seq.stream_id, rhdr.epoch, &gen))
+      rc = acceptUDPSeq(rhdr.seq.stream_id, rhdr.seq.seq, gen);
+    else
+      rc = SEQ_TOO_OLD;
+    if (rc == SEQ_DUPLICATE) {
+      nDuplicates.fetch_add(1, std::memory_order_relaxed);
+      return n;
+    } else if (rc == SEQ_TOO_OLD) {
+      nTooOld.fetch_add(1, std::memory_order_relaxed);
+      return n;
+    }
+
+    nDelivered.fetch_add(1, std::memory_order_relaxed);
+    nFirst[path].fetch_add(1, std::memory_order_relaxed);
+
+    if (hdr != NULL)
+      *hdr = rhdr.seq;
+
+    *len = n - sizeof(UDPRedundantHeader);
+    if (*len > (int) iov[1].iov_len)
+      *len = iov[1].iov_len;
+
+    return n;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPRedundantPath
+\date  Oct 2026
+
+\remarks
+
+Reads from one path until a first copy arrives; copies that arrived over
+another path before are discarded. Each path may be served by its own thread
+concurrently. On a non-blocking socket, 0 is returned once no data is left.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     path            : the path to read from
+\param[out]    buf             : payload buffer
+\param[in]     bufLen          : length of payload buffer
+\param[out]    hdr             : header of the datagram -- pass NULL if not needed
+
+returns the number of payload bytes received, 0 if no data on a non-blocking
+socket, or ERROR
+
+  ******************************************************************************/
+  int UDPRedundantChannel::
+  readUDPRedundantPath(int           path,
+		       char         *buf,
+		       int           bufLen,
+		       UDPSeqHeader *hdr)
+  {
+    int n, len;
+
+    if (!active) {
+      logCommEvent(COMM_EV_CHANNEL_NOT_ACTIVE,0);
+      return ERROR;
+    }
+
+    if (path < 0 || path >= nPaths) {
+      logCommEvent(COMM_EV_CHANNEL_INVALID_STREAM,0,path);
+      return ERROR;
+    }
+
+    while (TRUE) {
+      n = readUDPRedundantOnce(path, buf, bufLen, hdr, &len);
+      if (n <= 0)
+	return n;
+      if (len != ERROR)
+	return len;
+    }
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPRedundant
+\date  Oct 2026
+
+\remarks
+
+Waits on all paths and returns the first copy of the next datagram, from
+whichever path it arrives on. Ready paths are served round robin, such that a
+busy path cannot starve the others. Must not be mixed with concurrent calls
+of readUDPRedundantPath().
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[out]    buf             : payload buffer
+\param[in]     bufLen          : length of payload buffer
+\param[out]    hdr             : header of the datagram -- pass NULL if not needed
+\param[out]    path            : path the datagram came from -- pass NULL if not needed
+\param[in]     timeout_ms      : max. wait time, -1 to wait forever, 0 to poll
+
+returns the number of payload bytes received, 0 on time out, or ERROR
+
+  ******************************************************************************/
+  int UDPRedundantChannel::
+  readUDPRedundant(char         *buf,
+		   int           bufLen,
+		   UDPSeqHeader *hdr,
+		   int          *path,
+		   int           timeout_ms)
+  {
+    struct pollfd fds[UDP_REDUNDANT_MAX_PATHS];
+    uint64_t      deadline = 0;
+    int64_t       remaining;
+    int           i, p, n, len;
+
+    if (!active) {
+      logCommEvent(COMM_EV_CHANNEL_NOT_ACTIVE,0);
+      return ERROR;
+    }
+
+    for (i=0; i<nPaths; ++i) {
+      fds[i].fd     = paths[i]->getUDPSocketFd();
+      fds[i].events = POLLIN;
+    }
+
+    if (timeout_ms > 0)
+      deadline = monotonicTimeNs() + (uint64_t) timeout_ms * 1000000ULL;
+
+    while (TRUE) {
+      if (poll(fds, nPaths, timeout_ms) == ERROR) {
+	if (errno == EINTR)
+	  continue;
+	logCommEvent(COMM_EV_UDP_POLL_ERROR,errno);
+	return ERROR;
+      }
+
+      for (i=0; i<nPaths; ++i) {
+	p = (nextPath + i) % nPaths;
+	if (!(fds[p].revents & POLLIN))
+	  continue;
+	if ((n = readUDPRedundantOnce(p, buf, bufLen, hdr, &len)) == ERROR)
+	  return ERROR;
+	if (n > 0 && len != ERROR) {
+	  nextPath = (p + 1) % nPaths;
+	  if (path != NULL)
+	    *path = p;
+	  return len;
+	}
+      }
+
+      // only duplicates so far: wait for the rest of the time out
+      if (timeout_ms == 0)
+	return 0;
+      if (timeout_ms > 0) {
+	remaining = (int64_t) (deadline - monotonicTimeNs());
+	if (remaining <= 0)
+	  return 0;
+	timeout_ms = (int) ((remaining + 999999) / 1000000);
+      }
+    }
+  }
+
+} // end of namespace
@@ -0,0 +1,804 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_reliable.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  A reliable sub-channel multiplexed with unreliable state datagrams on the
+  same socket. Every datagram carries a small header whose type tells state
+  from reliable data, acknowledgements, and forward notices. State datagrams
+  are sent and returned immediately, and never wait for reliable traffic.
+
+  Reliable messages are numbered and kept in a preallocated pool of at most
+  UDP_REL_MAX_WINDOW messages until they are acknowledged; if the pool is
+  full, writeUDPReliable() fails instead of allocating or blocking. The
+  receiver acknowledges every data datagram with its cumulative sequence
+  number and a 64 bit selective acknowledgement (SACK) bitmap of the
+  messages after it, and delivers the messages in order from an equally
+  preallocated reorder pool. Lost messages are retransmitted when a later
+  message was SACKed (fast retransmit) or after the retransmission time out,
+  which follows the measured round trip time (Jacobson/Karn).
+
+  The channel can be partially reliable: after max_retries retransmissions,
+  the sender gives up on a message, and tells the receiver with a FORWARD
+  notice to skip it, such that stale configuration does not block newer
+  messages.
+
+  Every start of a channel picks a random session id, which is sent in all
+  datagrams. A new session of the sender resets the receiver to the
+  sender's numbering, and a new session of the receiver makes the sender
+  retransmit everything in flight. Acknowledgements only count for the
+  session they name, and late datagrams of the previous session of the peer
+  are discarded.
+
+  Both ends need to read and write, i.e., use connected sockets
+  (makeUDPConnectedClient()/makeUDPConnectedServer()). serviceUDPReliable()
+  needs to be called periodically, e.g., once per control cycle, to run the
+  retransmission timers. The channel is meant for a single thread.
+
+  ============================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+#include "string.h"
+#include "time.h"
+#include "unistd.h"
+
+// my utilities library
+#include "utility.h"
+
+#include "udp_reliable.h"
+#include "comm_log.h"
+
+namespace udp_communication {
+
+  using namespace comm_log;
+
+  static uint64_t
+  monotonicTimeNs(void)
+  {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Constructor
+\date  Oct 2026
+
+\remarks
+
+The channel is inactive until initUDPReliable() was called.
+
+  ******************************************************************************/
+  UDPReliableChannel::
+  UDPReliableChannel()
+  {
+    active   = FALSE;
+    udp      = NULL;
+    recvBuf  = NULL;
+    recvLen  = 0;
+    sendData = NULL;
+    recvData = NULL;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Destructor
+\date  Oct 2026
+
+\remarks
+
+Frees all buffers. The UDP socket is not closed.
+
+  ******************************************************************************/
+  UDPReliableChannel::
+  ~UDPReliableChannel()
+  {
+    free(recvBuf);
+    free(sendData);
+    free(recvData);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  initUDPReliable
+\date  Oct 2026
+
+\remarks
+
+Allocates the message pools of the channel. No memory is allocated later.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     udp             : a connected UDP socket
+\param[in]     max_msg_len     : max. payload length of a message
+\param[in]     window          : max. reliable messages in flight, at most
+                                 UDP_REL_MAX_WINDOW
+\param[in]     max_retries     : retransmissions before a message is given up,
+                                 0 to retransmit forever
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPReliableChannel::
+  initUDPReliable(UDP_communication *udp,
+		  int max_msg_len,
+		  int window,
+		  int max_retries)
+  {
+    struct timespec ts;
+    int             i;
+
+    if (active) {
+      printf("Reliable channel is already active\n");
+      return FALSE;
+    }
+
+    if (window <= 0 || window > UDP_REL_MAX_WINDOW || max_msg_len <= 0 || max_retries < 0) {
+      printf("Error: invalid reliable channel parameters\n");
+      return FALSE;
+    }
+
+    this->udp    = udp;
+    maxMsgLen    = max_msg_len;
+    this->window = window;
+    maxRetries   = max_retries;
+
+    // the ACK payload is the 8 byte SACK bitmap
+    recvLen  = max_msg_len > (int) sizeof(uint64_t) ? max_msg_len : sizeof(uint64_t);
+    recvBuf  = (char *) malloc(recvLen);
+    sendData = (char *) malloc(window * max_msg_len);
+    recvData = (char *) malloc(window * max_msg_len);
+
+    for (i=0; i<UDP_REL_MAX_WINDOW; ++i) {
+      sendSlots[i].used    = FALSE;
+      recvSlots[i].present = FALSE;
+    }
+
+    sendNext    = 0;
+    sendBase    = 0;
+    peerNext    = 0;
+    srttNs      = 0;
+    rttvarNs    = 0;
+    rtoNs       = UDP_REL_INIT_RTO_NS;
+    forwardNs   = 0;
+    recvNext    = 0;
+    deliverNext = 0;
+
+    // a different session for every start of the channel
+    clock_gettime(CLOCK_REALTIME, &ts);
+    session = (uint32_t) (ts.tv_sec * 2654435761U) ^ (uint32_t) ts.tv_nsec
+      ^ ((uint32_t) getpid() << 16);
+    if (session == 0)
+      session = 1;
+    ackSession      = 0;
+    prevAckSession  = 0;
+    recvSession     = 0;
+    prevRecvSession = 0;
+
+    nStateSent     = 0;
+    nStateReceived = 0;
+    nReliableSent  = 0;
+    nRetransmits   = 0;
+    nAcked         = 0;
+    nExpired       = 0;
+    nQueueFull     = 0;
+    nDelivered     = 0;
+    nSkipped       = 0;
+    nDuplicates    = 0;
+    nInvalid       = 0;
+    nRestarts      = 0;
+    nStale         = 0;
+    srtt           = 0;
+
+    active = TRUE;
+
+    return TRUE;
+  }
+
+  int UDPReliableChannel::
+  sendUDPRelPacket(int type, uint32_t seq, const char *buf, int len)
+  {
+    UDPRelHeader  hdr;
+    struct iovec  iov[2];
+
+    hdr.magic       = UDP_REL_MAGIC;
+    hdr.type        = type;
+    hdr.reserved    = 0;
+    hdr.seq         = seq;
+    hdr.base        = sendBase;
+    hdr.len         = len;
+    hdr.session     = session;
+    hdr.peerSession = recvSession;
+
+    // the payload is gathered from the caller, e.g., the retransmission pool
+    iov[0].iov_base = &hdr;
+    iov[0].iov_len  = sizeof(UDPRelHeader);
+    iov[1].iov_base = (void *) buf;
+    iov[1].iov_len  = len;
+
+    return udp->writeUDPSocketV(iov, len > 0 ? 2 : 1) - sizeof(UDPRelHeader);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  writeUDPUnreliable
+\date  Oct 2026
+
+\remarks
+
+Sends a state datagram right away. It is neither numbered nor kept.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     buf             : payload
+\param[in]     bufLen          : length of payload
+
+returns the number of payload bytes written, or FALSE on error
+
+  ******************************************************************************/
+  int UDPReliableChannel::
+  writeUDPUnreliable(char *buf,
+		     int   bufLen)
+  {
+    int n;
+
+    if (!active) {
+      logCommEvent(COMM_EV_CHANNEL_NOT_ACTIVE,0);
+      return FALSE;
+    }
+
+    if (bufLen < 0 || bufLen > maxMsgLen) {
+      logCommEvent(COMM_EV_CHANNEL_INVALID_LENGTH,0,bufLen,maxMsgLen);
+      return FALSE;
+    }
+
+    n = sendUDPRelPacket(UDP_REL_STATE, 0, buf, bufLen);
+    ++nStateSent;
+
+    return n < 0 ? FALSE : n;
+  }
+
+  void UDPReliableChannel::
+  transmitUDPSlot(SendSlot *s, uint64_t now)
+  {
+    sendUDPRelPacket(UDP_REL_DATA, s->seq, sendData + (s->seq % window) * maxMsgLen, s->len);
+    s->sentNs = now;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  writeUDPReliable
+\date  Oct 2026
+
+\remarks
+
+Copies a message into the retransmission pool and sends it. The message is
+retransmitted until it is acknowledged, or given up after max_retries.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     buf             : payload
+\param[in]     bufLen          : length of payload
+
+returns the number of payload bytes queued, or FALSE if the pool is full or
+on error
+
+  ******************************************************************************/
+  int UDPReliableChannel::
+  writeUDPReliable(char *buf,
+		   int   bufLen)
+  {
+    SendSlot *s;
+
+    if (!active) {
+      logCommEvent(COMM_EV_CHANNEL_NOT_ACTIVE,0);
+      return FALSE;
+    }
+
+    if (bufLen < 0 || bufLen > maxMsgLen) {
+      logCommEvent(COMM_EV_CHANNEL_INVALID_LENGTH,0,bufLen,maxMsgLen);
+      return FALSE;
+    }
+
+    serviceUDPReliable();
+
+    if ((int) (sendNext - sendBase) >= window) {
+      ++nQueueFull;
+      return FALSE;
+    }
+
+    s = &sendSlots[sendNext % window];
+    memcpy(sendData + (sendNext % window) * maxMsgLen, buf, bufLen);
+    s->used    = TRUE;
+    s->sacked  = FALSE;
+    s->seq     = sendNext++;
+    s->len     = bufLen;
+    s->retries = 0;
+    s->rtoNs   = rtoNs;
+    transmitUDPSlot(s, monotonicTimeNs());
+    ++nReliableSent;
+
+    return bufLen;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  releaseUDPSlots
+\date  Oct 2026
+
+\remarks
+
+Advances the send window over acknowledged or given up messages.
+
+  ******************************************************************************/
+  void UDPReliableChannel::
+  releaseUDPSlots(void)
+  {
+    while (sendBase != sendNext && !sendSlots[sendBase % window].used)
+      ++sendBase;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  restartUDPSender
+\date  Oct 2026
+
+\remarks
+
+The receiver restarted and holds none of the messages in flight: selective
+acknowledgements of the old receiver are void, and all messages are
+retransmitted. The new receiver starts at sendBase.
+
+  ******************************************************************************/
+  void UDPReliableChannel::
+  restartUDPSender(void)
+  {
+    SendSlot *s;
+    uint32_t  seq;
+    uint64_t  now = monotonicTimeNs();
+
+    peerNext = sendBase;
+
+    for (seq=sendBase; seq!=sendNext; ++seq) {
+      s = &sendSlots[seq % window];
+      if (!s->used || s->seq != seq)
+	continue;
+      s->sacked = FALSE;
+      ++s->retries;
+      ++nRetransmits;
+      transmitUDPSlot(s, now);
+    }
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  ackUDPReliable
+\date  Oct 2026
+
+\remarks
+
+Processes an acknowledgement: messages before next are done, messages with a
+bit in sack are held by the receiver. Round trip samples are only taken from
+messages that were sent once. Unacknowledged messages before the newest
+SACKed one are presumed lost and retransmitted right away, at most once per
+round trip.
+
+  ******************************************************************************/
+  void UDPReliableChannel::
+  ackUDPReliable(uint32_t next, uint64_t sack, uint64_t now)
+  {
+    SendSlot *s;
+    uint32_t  seq;
+    uint32_t  highest = next;
+    uint32_t  d;
+    int64_t   sample;
+    bool      acked;
+
+    if ((int32_t) (next - peerNext) > 0)
+      peerNext = next;
+
+    for (seq=sendBase; seq!=sendNext; ++seq) {
+      s = &sendSlots[seq % window];
+      if (!s->used || s->seq != seq)
+	continue;
+
+      d = seq - next - 1;
+      if ((int32_t) (seq - next) < 0)
+	acked = TRUE;
+      else if (d < 64 && ((sack >> d) & 1))
+	acked = FALSE;
+      else
+	continue;
+
+      if (!s->sacked) {
+	++nAcked;
+	if (s->retries == 0) {
+	  sample = now - s->sentNs;
+	  if (srttNs == 0) {
+	    srttNs   = sample;
+	    rttvarNs = sample / 2;
+	  } else {
+	    rttvarNs = (3*rttvarNs + (uint64_t) llabs((int64_t) srttNs - sample)) / 4;
+	    srttNs   = (7*srttNs + sample) / 8;
+	  }
+	  rtoNs = srttNs + 4*rttvarNs;
+	  if (rtoNs < UDP_REL_MIN_RTO_NS)
+	    rtoNs = UDP_REL_MIN_RTO_NS;
+	  if (rtoNs > UDP_REL_MAX_RTO_NS)
+	    rtoNs = UDP_REL_MAX_RTO_NS;
+	  srtt = srttNs * 1.e-9;
+	}
+      }
+
+      if (acked)
+	s->used = FALSE;
+      else {
+	s->sacked = TRUE;
+	highest   = seq;
+      }
+    }
+
+    // fast retransmit of the holes before the newest SACKed message
+    for (seq=sendBase; seq!=highest && (int32_t) (highest - seq) > 0; ++seq) {
+      s = &sendSlots[seq % window];
+      if (s->used && !s->sacked && s->seq == seq && now - s->sentNs > srttNs) {
+	++s->retries;
+	++nRetransmits;
+	transmitUDPSlot(s, now);
+      }
+    }
+
+    releaseUDPSlots();
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  serviceUDPReliable
+\date  Oct 2026
+
+\remarks
+
+Runs the retransmission timers: messages whose time out expired are sent
+again with twice the time out, or given up after max_retries. If messages
+were given up, the receiver is told with FORWARD notices until its
+acknowledgements show that it skipped them. Needs to be called periodically.
+
+returns the number of datagrams sent
+
+  ******************************************************************************/
+  int UDPReliableChannel::
+  serviceUDPReliable(void)
+  {
+    SendSlot *s;
+    uint32_t  seq;
+    uint64_t  now;
+    int       n_sent = 0;
+
+    if (!active)
+      return 0;
+
+    now = monotonicTimeNs();
+
+    for (seq=sendBase; seq!=sendNext; ++seq) {
+      s = &sendSlots[seq % window];
+      if (!s->used || s->sacked || now - s->sentNs < s->rtoNs)
+	continue;
+
+      if (maxRetries > 0 && s->retries >= maxRetries) {
+	s->used = FALSE;
+	++nExpired;
+	continue;
+      }
+
+      ++s->retries;
+      ++nRetransmits;
+      s->rtoNs = 2*s->rtoNs < UDP_REL_MAX_RTO_NS ? 2*s->rtoNs : UDP_REL_MAX_RTO_NS;
+      transmitUDPSlot(s, now);
+      ++n_sent;
+    }
+
+    releaseUDPSlots();
+
+    // the receiver still waits for messages that were given up
+    if ((int32_t) (sendBase - peerNext) > 0 && now - forwardNs >= rtoNs) {
+      sendUDPRelPacket(UDP_REL_FORWARD, 0, NULL, 0);
+      forwardNs = now;
+      ++n_sent;
+    }
+
+    return n_sent;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  getUDPReliablePending
+\date  Oct 2026
+
+\remarks
+
+returns the number of reliable messages that are not acknowledged yet
+
+  ******************************************************************************/
+  int UDPReliableChannel::
+  getUDPReliablePending(void)
+  {
+    return sendNext - sendBase;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  sendUDPAck
+\date  Oct 2026
+
+\remarks
+
+Acknowledges everything before recvNext, and the messages after it that are
+held in the reorder pool.
+
+  ******************************************************************************/
+  void UDPReliableChannel::
+  sendUDPAck(void)
+  {
+    uint64_t  sack = 0;
+    uint32_t  seq;
+    RecvSlot *r;
+    int       i;
+
+    for (i=0; i<64; ++i) {
+      seq = recvNext + 1 + i;
+      if ((int) (seq - deliverNext) >= window)
+	break;
+      r = &recvSlots[seq % window];
+      if (r->present && r->seq == seq)
+	sack |= 1ULL << i;
+    }
+
+    sendUDPRelPacket(UDP_REL_ACK, recvNext, (char *) &sack, sizeof(sack));
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  acceptUDPSession
+\date  Oct 2026
+
+\remarks
+
+Checks the session id of a datagram of the peer against its current
+session in cur. A different session, other than the previous one in prev, becomes
+the current session; this is a restart of the peer unless no session was
+known yet.
+
+returns TRUE if the datagram belongs to the current session, possibly a new
+one, or FALSE if it is a late datagram of the previous session
+
+  ******************************************************************************/
+  int UDPReliableChannel::
+  acceptUDPSession(uint32_t id, uint32_t *cur, uint32_t *prev)
+  {
+    if (id == *cur)
+      return TRUE;
+
+    if (*prev != 0 && id == *prev) {
+      ++nStale;
+      return FALSE;
+    }
+
+    if (*cur != 0)
+      ++nRestarts;
+    *prev = *cur;
+    *cur  = id;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  receiveUDPData
+\date  Oct 2026
+
+\remarks
+
+Stores a reliable message in the reorder pool, and skips messages the sender
+gave up on (hdr->base), even if they are more than the pool holds. Messages
+beyond the pool are dropped without acknowledgement, such that the sender
+retransmits them later. The first
+datagram of a new session of the sender restarts the receiver at hdr->base;
+everything was delivered up to recvNext at this point, and the messages
+held after it belong to the old session.
+
+returns TRUE if the message was new, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPReliableChannel::
+  receiveUDPData(UDPRelHeader *hdr, const char *data)
+  {
+    RecvSlot *r;
+    uint32_t  cur = recvSession;
+    int       rc = FALSE;
+    int       i;
+
+    if (!acceptUDPSession(hdr->session, &recvSession, &prevRecvSession))
+      return FALSE;
+
+    if (recvSession != cur) {
+      for (i=0; i<window; ++i)
+	recvSlots[i].present = FALSE;
+      recvNext    = hdr->base;
+      deliverNext = hdr->base;
+    }
+
+    // the sender does not send anything before base anymore, however far
+    // ahead base is; readUDPMux() skips what the pool does not hold
+    if ((int32_t) (hdr->base - recvNext) > 0) {
+      recvNext = hdr->base;
+
+      // if nothing before base is held, skip right away, such that the
+      // messages from base on fit into the pool
+      for (i=0; i<window; ++i)
+	if (recvSlots[i].present && (int32_t) (recvSlots[i].seq - hdr->base) < 0)
+	  break;
+      if (i == window) {
+	nSkipped   += hdr->base - deliverNext;
+	deliverNext = hdr->base;
+      }
+    }
+
+    if (hdr->type == UDP_REL_DATA) {
+      if ((int32_t) (hdr->seq - recvNext) < 0) {
+	++nDuplicates;
+      } else if ((int) (hdr->seq - deliverNext) < window) {
+	r = &recvSlots[hdr->seq % window];
+	if (r->present && r->seq == hdr->seq) {
+	  ++nDuplicates;
+	} else {
+	  memcpy(recvData + (hdr->seq % window) * maxMsgLen, data, hdr->len);
+	  r->present = TRUE;
+	  r->seq     = hdr->seq;
+	  r->len     = hdr->len;
+	  rc = TRUE;
+	}
+      }
+    }
+
+    while (recvSlots[recvNext % window].present &&
+	   recvSlots[recvNext % window].seq == recvNext &&
+	   (int) (recvNext - deliverNext) < window)
+      ++recvNext;
+
+    sendUDPAck();
+
+    return rc;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPMux
+\date  Oct 2026
+
+\remarks
+
+Returns the next message of the socket: reliable messages in order as soon
+as all messages before them arrived (or were given up by the sender), and
+state datagrams as they arrive. Acknowledgements are processed internally.
+If buf can hold any message of the channel, datagrams are scattered directly
+into it, such that state datagrams are delivered without a copy; the content
+of buf is undefined unless a positive length is returned.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[out]    buf             : payload buffer
+\param[in]     bufLen          : length of payload buffer
+\param[out]    type            : UDP_REL_STATE or UDP_REL_DATA -- pass NULL if
+                                 not needed
+
+returns the number of payload bytes received, 0 if no data on a non-blocking
+socket, or ERROR
+
+  ******************************************************************************/
+  int UDPReliableChannel::
+  readUDPMux(char *buf,
+	     int   bufLen,
+	     int  *type)
+  {
+    UDPRelHeader  rhdr;
+    UDPRelHeader *hdr = &rhdr;
+    struct iovec  iov[2];
+    char         *payload;
+    RecvSlot     *r;
+    uint64_t      sack;
+    uint32_t      cur;
+    int           n;
+
+    if (!active) {
+      logCommEvent(COMM_EV_CHANNEL_NOT_ACTIVE,0);
+      return ERROR;
+    }
+
+    payload = bufLen >= recvLen ? buf : recvBuf;
+    iov[0].iov_base = &rhdr;
+    iov[0].iov_len  = sizeof(UDPRelHeader);
+    iov[1].iov_base = payload;
+    iov[1].iov_len  = recvLen;
+
+    while (TRUE) {
+
+      // in order delivery from the reorder pool
+      while (deliverNext != recvNext) {
+	r = &recvSlots[deliverNext % window];
+	if (r->present && r->seq == deliverNext) {
+	  r->present = FALSE;
+	  n = r->len < bufLen ? r->len : bufLen;
+	  memcpy(buf, recvData + (deliverNext % window) * maxMsgLen, n);
+	  ++deliverNext;
+	  ++nDelivered;
+	  if (type != NULL)
+	    *type = UDP_REL_DATA;
+	  return n;
+	}
+	++deliverNext;
+	++nSkipped;
+      }
+
+      n = udp->readUDPSocketV(iov, 2, NULL);
+      if (n <= 0)
+	return n == 0 ? 0 : ERROR;
+
+      n -= sizeof(UDPRelHeader);
+      if (n < 0 || hdr->magic != UDP_REL_MAGIC || (int) hdr->len != n ||
+	  (hdr->type == UDP_REL_ACK ? n != sizeof(uint64_t) : n > maxMsgLen)) {
+	++nInvalid;
+	continue;
+      }
+
+      switch (hdr->type) {
+      case UDP_REL_STATE:
+	++nStateReceived;
+	if (n > bufLen)
+	  n = bufLen;
+	if (payload != buf)
+	  memcpy(buf, payload, n);
+	if (type != NULL)
+	  *type = UDP_REL_STATE;
+	return n;
+
+      case UDP_REL_DATA:
+      case UDP_REL_FORWARD:
+	receiveUDPData(hdr, payload);
+	break;
+
+      case UDP_REL_ACK:
+	// acknowledgements of an earlier start of this channel
+	if (hdr->peerSession != session) {
+	  ++nStale;
+	  break;
+	}
+	cur = ackSession;
+	if (!acceptUDPSession(hdr->session, &ackSession, &prevAckSession))
+	  break;
+	if (ackSession != cur && cur != 0)
+	  restartUDPSender();
+	memcpy(&sack, payload, sizeof(sack));
+	ackUDPReliable(hdr->seq, sack, monotonicTimeNs());
+	break;
+
+      default:
+	++nInvalid;
+      }
+    }
+  }
+
+} // end of namespace
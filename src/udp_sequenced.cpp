@@ -0,0 +1,448 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_sequenced.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  Sequenced datagrams: every datagram carries a small header with a stream id,
+  a per-stream sequence number, and the send time. The receiver keeps per
+  stream statistics of lost, reordered, and duplicated datagrams, and a
+  histogram of the one-way latency. The statistics are lock-free counters
+  that can be queried from any thread while the receiver runs.
+
+  The one-way latency is based on CLOCK_REALTIME of sender and receiver, and
+  is thus only meaningful if both clocks are synchronized.
+
+  ============================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+#include "string.h"
+#include "time.h"
+
+// my utilities library
+#include "utility.h"
+
+#include "udp_sequenced.h"
+#include "comm_log.h"
+
+namespace udp_communication {
+
+  using namespace comm_log;
+
+  static uint64_t
+  realtimeNs(void)
+  {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Constructor
+\date  Oct 2026
+
+\remarks
+
+The channel is inactive until initUDPSequenced() was called.
+
+  ******************************************************************************/
+  UDPSequencedChannel::
+  UDPSequencedChannel()
+  {
+    active     = FALSE;
+    udp        = NULL;
+    maxStreams = 0;
+    streams    = NULL;
+    nextSeq    = NULL;
+    nInvalid.store(0);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Destructor
+\date  Oct 2026
+
+\remarks
+
+Frees all buffers. The UDP socket is not closed.
+
+  ******************************************************************************/
+  UDPSequencedChannel::
+  ~UDPSequencedChannel()
+  {
+    delete [] streams;
+    delete [] nextSeq;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  initUDPSequenced
+\date  Oct 2026
+
+\remarks
+
+Allocates the per stream state.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     udp             : the UDP socket to communicate with
+\param[in]     max_streams     : stream ids are 0 ... max_streams-1
+\param[in]     max_msg_len     : max. payload length of a datagram
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPSequencedChannel::
+  initUDPSequenced(UDP_communication *udp,
+		   int max_streams,
+		   int max_msg_len)
+  {
+    if (active) {
+      printf("Sequenced channel is already active\n");
+      return FALSE;
+    }
+
+    if (max_streams <= 0 || max_streams > 65536) {
+      printf("Error: invalid number of streams\n");
+      return FALSE;
+    }
+
+    this->udp  = udp;
+    maxStreams = max_streams;
+    maxMsgLen  = max_msg_len;
+    streams    = new Stream[max_streams];
+    nextSeq    = new uint32_t[max_streams];
+
+    for (int i=0; i<max_streams; ++i) {
+      nextSeq[i] = 0;
+      streams[i].started = FALSE;
+      resetUDPStreamStats(i);
+    }
+
+    active = TRUE;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  writeUDPSequenced
+\date  Oct 2026
+
+\remarks
+
+Sends a datagram with the next sequence number of the given stream.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     stream_id       : the stream
+\param[in]     buf             : payload
+\param[in]     bufLen          : length of payload
+
+returns the number of payload bytes written, or FALSE on error
+
+  ******************************************************************************/
+  int UDPSequencedChannel::
+  writeUDPSequenced(int   stream_id,
+		    char *buf,
+		    int   bufLen)
+  {
+    UDPSeqHeader  hdr;
+    struct iovec  iov[2];
+    int           n;
+
+    if (!active) {
+      logCommEvent(COMM_EV_CHANNEL_NOT_ACTIVE,0);
+      return FALSE;
+    }
+
+    if (stream_id < 0 || stream_id >= maxStreams) {
+      logCommEvent(COMM_EV_CHANNEL_INVALID_STREAM,0,stream_id);
+      return FALSE;
+    }
+
+    if (bufLen > maxMsgLen) {
+      logCommEvent(COMM_EV_CHANNEL_INVALID_LENGTH,0,bufLen,maxMsgLen);
+      return FALSE;
+    }
+
+    hdr.magic      = UDP_SEQ_MAGIC;
+    hdr.stream_id  = stream_id;
+    hdr.seq        = nextSeq[stream_id]++;
+    hdr.send_ns    = realtimeNs();
+
+    // the header and the payload are gathered by the kernel
+    iov[0].iov_base = &hdr;
+    iov[0].iov_len  = sizeof(UDPSeqHeader);
+    iov[1].iov_base = buf;
+    iov[1].iov_len  = bufLen;
+
+    n = udp->writeUDPSocketV(iov, 2);
+    if (n < (int) sizeof(UDPSeqHeader))
+      return FALSE;
+
+    return n - sizeof(UDPSeqHeader);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  updateStream
+\date  Oct 2026
+
+\remarks
+
+Updates the statistics of a stream with a received datagram.
+
+  ******************************************************************************/
+  void UDPSequencedChannel::
+  updateStream(Stream *st, UDPSeqHeader *hdr, int len)
+  {
+    int32_t  diff;
+    int64_t  back;
+    int64_t  latency;
+    int      bin;
+
+    st->received.fetch_add(1, std::memory_order_relaxed);
+    st->bytes.fetch_add(len, std::memory_order_relaxed);
+
+    // sequence accounting, robust against wrap around of the counter
+    if (!st->started) {
+      st->started = TRUE;
+      st->highest = hdr->seq;
+      st->window  = 1;
+      st->span    = 0;
+      st->stale   = 0;
+    } else {
+      diff = (int32_t) (hdr->seq - st->highest);
+      back = -(int64_t) diff;
+
+      // a run of old datagrams that turned out to be no restart
+      if (st->stale > 0 && (back < UDP_SEQ_WINDOW || hdr->seq != st->staleSeq + 1)) {
+	st->reordered.fetch_add(st->stale, std::memory_order_relaxed);
+	st->stale = 0;
+      }
+
+      if (diff > 0) {
+	// newer than anything so far: everything in between is missing for now
+	st->lost.fetch_add(diff - 1, std::memory_order_relaxed);
+	st->window  = diff < UDP_SEQ_WINDOW ? (st->window << diff) | 1 : 1;
+	st->span    = st->span + diff < UDP_SEQ_WINDOW - 1 ? st->span + diff : UDP_SEQ_WINDOW - 1;
+	st->highest = hdr->seq;
+      } else if (back <= st->span) {
+	if (st->window & (1ULL << back)) {
+	  st->duplicates.fetch_add(1, std::memory_order_relaxed);
+	  return;
+	}
+	// a late datagram that was counted as lost before
+	st->window |= 1ULL << back;
+	st->reordered.fetch_add(1, std::memory_order_relaxed);
+	st->lost.fetch_sub(1, std::memory_order_relaxed);
+      } else if (back < UDP_SEQ_WINDOW) {
+	// older than the first datagram of the stream, never counted as lost
+	st->reordered.fetch_add(1, std::memory_order_relaxed);
+      } else {
+	// too old to tell whether it is a duplicate: a straggler, or the sender
+	// restarted its sequence, which shows as a run of consecutive datagrams
+	st->staleSeq = hdr->seq;
+	if (++st->stale >= UDP_SEQ_RESTART) {
+	  st->restarts.fetch_add(1, std::memory_order_relaxed);
+	  st->highest = hdr->seq;
+	  st->window  = (1ULL << UDP_SEQ_RESTART) - 1;
+	  st->span    = UDP_SEQ_RESTART - 1;
+	  st->stale   = 0;
+	}
+      }
+    }
+
+    // one-way latency
+    latency = (int64_t) (realtimeNs() - hdr->send_ns);
+    if (latency < st->latency_min_ns.load(std::memory_order_relaxed))
+      st->latency_min_ns.store(latency, std::memory_order_relaxed);
+    if (latency > st->latency_max_ns.load(std::memory_order_relaxed))
+      st->latency_max_ns.store(latency, std::memory_order_relaxed);
+    st->latency_sum_ns.fetch_add(latency, std::memory_order_relaxed);
+
+    bin = 0;
+    latency /= 1000;
+    while (latency > 0 && bin < UDP_SEQ_HIST_BINS-1) {
+      latency >>= 1;
+      ++bin;
+    }
+    st->latency_hist[bin].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  readUDPSequenced
+\date  Oct 2026
+
+\remarks
+
+Reads a sequenced datagram and updates the statistics of its stream.
+Duplicates are counted, but still returned. Datagrams without a valid header
+are counted in nInvalid and skipped.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[out]    buf             : payload buffer
+\param[in]     bufLen          : length of payload buffer
+\param[out]    hdr             : header of the datagram -- pass NULL if not needed
+\param[out]    peer            : the sender -- pass NULL if not needed
+
+returns the number of payload bytes received, 0 if no data on a non-blocking
+socket, or ERROR
+
+  ******************************************************************************/
+  int UDPSequencedChannel::
+  readUDPSequenced(char         *buf,
+		   int           bufLen,
+		   UDPSeqHeader *hdr,
+		   UDPEndpoint  *peer)
+  {
+    UDPSeqHeader  rhdr;
+    struct iovec  iov[2];
+    int           n;
+
+    if (!active) {
+      logCommEvent(COMM_EV_CHANNEL_NOT_ACTIVE,0);
+      return ERROR;
+    }
+
+    // the header is scattered into rhdr, the payload directly into buf
+    iov[0].iov_base = &rhdr;
+    iov[0].iov_len  = sizeof(UDPSeqHeader);
+    iov[1].iov_base = buf;
+    iov[1].iov_len  = bufLen < maxMsgLen ? bufLen : maxMsgLen;
+
+    while (TRUE) {
+      n = udp->readUDPSocketV(iov, 2, peer);
+      if (n <= 0)
+	return n == 0 ? 0 : ERROR;
+
+      if (n < (int) sizeof(UDPSeqHeader) || rhdr.magic != UDP_SEQ_MAGIC ||
+	  rhdr.stream_id >= maxStreams) {
+	nInvalid.fetch_add(1, std::memory_order_relaxed);
+	continue;
+      }
+      break;
+    }
+
+    // n is the full datagram length, also if the payload did not fit into buf
+    n -= sizeof(UDPSeqHeader);
+    updateStream(&streams[rhdr.stream_id], &rhdr, n);
+
+    if (hdr != NULL)
+      *hdr = rhdr;
+
+    return n < (int) iov[1].iov_len ? n : (int) iov[1].iov_len;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  getUDPStreamStats
+\date  Oct 2026
+
+\remarks
+
+Returns a snapshot of the statistics of a stream; can be called from any
+thread.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     stream_id       : the stream
+\param[out]    stats           : the statistics
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPSequencedChannel::
+  getUDPStreamStats(int stream_id,
+		    UDPStreamStats *stats)
+  {
+    Stream        *st;
+    unsigned long  n_latency;
+
+    if (!active || stream_id < 0 || stream_id >= maxStreams)
+      return FALSE;
+
+    st = &streams[stream_id];
+    stats->received   = st->received.load(std::memory_order_relaxed);
+    stats->lost       = st->lost.load(std::memory_order_relaxed);
+    stats->reordered  = st->reordered.load(std::memory_order_relaxed);
+    stats->duplicates = st->duplicates.load(std::memory_order_relaxed);
+    stats->restarts   = st->restarts.load(std::memory_order_relaxed);
+    stats->bytes      = st->bytes.load(std::memory_order_relaxed);
+
+    n_latency = 0;
+    for (int i=0; i<UDP_SEQ_HIST_BINS; ++i) {
+      stats->latency_hist[i] = st->latency_hist[i].load(std::memory_order_relaxed);
+      n_latency += stats->latency_hist[i];
+    }
+
+    if (n_latency > 0) {
+      stats->latency_min  = st->latency_min_ns.load(std::memory_order_relaxed) * 1.e-9;
+      stats->latency_max  = st->latency_max_ns.load(std::memory_order_relaxed) * 1.e-9;
+      stats->latency_mean = st->latency_sum_ns.load(std::memory_order_relaxed) * 1.e-9
+	/ n_latency;
+    } else {
+      stats->latency_min = stats->latency_max = stats->latency_mean = 0;
+    }
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  resetUDPStreamStats
+\date  Oct 2026
+
+\remarks
+
+Clears the counters of a stream. The sequence tracking is not affected.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     stream_id       : the stream
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPSequencedChannel::
+  resetUDPStreamStats(int stream_id)
+  {
+    Stream *st;
+
+    if (stream_id < 0 || stream_id >= maxStreams)
+      return FALSE;
+
+    st = &streams[stream_id];
+    st->received.store(0);
+    st->lost.store(0);
+    st->reordered.store(0);
+    st->duplicates.store(0);
+    st->restarts.store(0);
+    st->bytes.store(0);
+    st->latency_min_ns.store(INT64_MAX);
+    st->latency_max_ns.store(INT64_MIN);
+    st->latency_sum_ns.store(0);
+    for (int i=0; i<UDP_SEQ_HIST_BINS; ++i)
+      st->latency_hist[i].store(0);
+
+    return TRUE;
+  }
+
+} // end of namespace
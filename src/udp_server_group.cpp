@@ -0,0 +1,406 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_server_group.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  A group of UDP server sockets that share one port with SO_REUSEPORT, each
+  read by its own thread that can be pinned to a core. The kernel distributes
+  the incoming datagrams over the sockets, such that a server scales over
+  several cores. By default, the kernel hashes the address/port 4-tuple, i.e.,
+  a client socket always reaches the same worker. Alternatively, a classic BPF
+  program can steer by the source IP address only (all sockets of a client
+  host reach the same worker), or by the CPU that received the datagram.
+
+  ============================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+#include "unistd.h"
+#include "string.h"
+#include "errno.h"
+#include "poll.h"
+#include "time.h"
+#include "pthread.h"
+#include "sched.h"
+#include "sys/socket.h"
+#include "sys/eventfd.h"
+#include "linux/filter.h"
+
+// my utilities library
+#include "utility.h"
+
+#include "udp_server_group.h"
+
+namespace udp_communication {
+
+  static uint64_t
+  monotonicTimeNs(void)
+  {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Constructor
+\date  Oct 2026
+
+\remarks
+
+The group is inactive until startUDPServerGroup() was called.
+
+  ******************************************************************************/
+  UDPServerGroup::
+  UDPServerGroup()
+  {
+    active   = FALSE;
+    nWorkers = 0;
+    workers  = NULL;
+    wakeupFd = ERROR;
+    running.store(false);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Destructor
+\date  Oct 2026
+
+\remarks
+
+Stops the workers if still running.
+
+  ******************************************************************************/
+  UDPServerGroup::
+  ~UDPServerGroup()
+  {
+    if (active)
+      stopUDPServerGroup();
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  startUDPServerGroup
+\date  Oct 2026
+
+\remarks
+
+Opens n_workers server sockets on the same port and starts one receive thread
+per socket. Each thread waits for data, drains its socket with batched reads,
+and calls the handler with every batch. The handler runs in the worker thread
+and can reply through getUDPWorkerSocket().
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     serverPortNum   : which port to use
+\param[in]     serverName      : name or IP address of server -- pass "" to
+                                 use all interfaces
+\param[in]     n_workers       : number of sockets and threads
+\param[in]     max_msg_len     : max. datagram size
+\param[in]     steering        : how datagrams are distributed over workers
+\param[in]     cpus            : cpus[i] is the core of worker i, -1 for no
+                                 pinning -- pass NULL to pin worker i to core
+                                 i modulo the number of cores
+\param[in]     handler         : called with every received batch
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPServerGroup::
+  startUDPServerGroup(int             serverPortNum,
+		      char           *serverName,
+		      int             n_workers,
+		      int             max_msg_len,
+		      UDPSteering     steering,
+		      const int      *cpus,
+		      UDPGroupHandler handler)
+  {
+    int n_cpus;
+
+    if (active) {
+      printf("Server group is already active\n");
+      return FALSE;
+    }
+
+    if (n_workers <= 0) {
+      printf("Error: invalid number of workers\n");
+      return FALSE;
+    }
+
+    if ((wakeupFd = eventfd(0, EFD_CLOEXEC)) == ERROR) {
+      printf("Error: could not create wakeup event (errno=%d)\n",errno);
+      return FALSE;
+    }
+
+    n_cpus    = sysconf(_SC_NPROCESSORS_ONLN);
+    nWorkers  = n_workers;
+    maxMsgLen = max_msg_len;
+    workers   = new Worker[n_workers];
+    this->handler = handler;
+
+    // the sockets join the reuseport group in this order, which defines the
+    // worker index that the steering program returns
+    for (int i=0; i<n_workers; ++i) {
+      workers[i].udp = new UDP_communication();
+      workers[i].cpu = cpus != NULL ? cpus[i] : i % n_cpus;
+      workers[i].packets.store(0);
+      workers[i].bytes.store(0);
+      workers[i].batches.store(0);
+      workers[i].busy_ns.store(0);
+
+      if (!workers[i].udp->setUDPReusePort(TRUE) ||
+	  !workers[i].udp->makeUDPServer(serverPortNum,serverName)) {
+	nWorkers = i+1;
+	stopUDPServerGroup();
+	return FALSE;
+      }
+
+      workers[i].udp->setUDPNonBlocking(TRUE);
+    }
+
+    active = TRUE;
+
+    if (steering != UDP_STEER_FLOW && !attachUDPSteering(steering)) {
+      stopUDPServerGroup();
+      return FALSE;
+    }
+
+    running.store(true);
+    for (int i=0; i<n_workers; ++i)
+      workers[i].thread = std::thread(&UDPServerGroup::workerLoop, this, i);
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  attachUDPSteering
+\date  Oct 2026
+
+\remarks
+
+Attaches a classic BPF program to the reuseport group that returns the index
+of the socket to deliver to. An index out of range falls back to the hash.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     steering        : UDP_STEER_SOURCE or UDP_STEER_CPU
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPServerGroup::
+  attachUDPSteering(UDPSteering steering)
+  {
+    struct sock_filter source_code[] = {
+      // A = source address of the IP header
+      { BPF_LD  | BPF_W   | BPF_ABS, 0, 0, (uint32_t) (SKF_NET_OFF + 12) },
+      { BPF_ALU | BPF_MOD | BPF_K,   0, 0, (uint32_t) nWorkers },
+      { BPF_RET | BPF_A,             0, 0, 0 },
+    };
+    struct sock_filter cpu_code[] = {
+      // A = the CPU that processes the datagram
+      { BPF_LD  | BPF_W   | BPF_ABS, 0, 0, (uint32_t) (SKF_AD_OFF + SKF_AD_CPU) },
+      { BPF_ALU | BPF_MOD | BPF_K,   0, 0, (uint32_t) nWorkers },
+      { BPF_RET | BPF_A,             0, 0, 0 },
+    };
+    struct sock_fprog prog;
+
+    prog.len    = 3;
+    prog.filter = steering == UDP_STEER_SOURCE ? source_code : cpu_code;
+
+    // the program applies to the whole group, attaching it to one socket is enough
+    if (setsockopt(workers[0].udp->getUDPSocketFd(), SOL_SOCKET,
+		   SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) == ERROR) {
+      printf("Error: couldn't attach steering program (errno=%d)\n",errno);
+      return FALSE;
+    }
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  stopUDPServerGroup
+\date  Oct 2026
+
+\remarks
+
+Stops all workers and closes their sockets.
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPServerGroup::
+  stopUDPServerGroup(void)
+  {
+    uint64_t one = 1;
+
+    if (workers == NULL) {
+      printf("Server group not initialized\n");
+      return FALSE;
+    }
+
+    active = FALSE;
+    running.store(false);
+    if (write(wakeupFd, &one, sizeof(one)) < 0)
+      printf("Error: could not wake up workers (errno=%d)\n",errno);
+
+    for (int i=0; i<nWorkers; ++i) {
+      if (workers[i].thread.joinable())
+	workers[i].thread.join();
+      delete workers[i].udp;
+    }
+
+    delete [] workers;
+    workers  = NULL;
+    nWorkers = 0;
+    close(wakeupFd);
+    wakeupFd = ERROR;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  workerLoop
+\date  Oct 2026
+
+\remarks
+
+The thread of one worker: pins itself, waits for data, and hands every batch
+of datagrams to the handler. The wakeup event is never read, such that it
+stays readable and stops all workers.
+
+  ******************************************************************************/
+  void UDPServerGroup::
+  workerLoop(int worker)
+  {
+    Worker        *w = &workers[worker];
+    UDPMessage     msgs[UDP_MAX_BATCH];
+    char          *bufs;
+    struct pollfd  fds[2];
+    int            n_msgs;
+    unsigned long  n_bytes;
+    uint64_t       t0;
+
+    if (w->cpu >= 0) {
+      cpu_set_t set;
+
+      CPU_ZERO(&set);
+      CPU_SET(w->cpu, &set);
+      if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+	printf("Error: could not pin worker %d to cpu %d\n",worker,w->cpu);
+	w->cpu = ERROR;
+      }
+    }
+
+    bufs = (char *) malloc((size_t) UDP_MAX_BATCH * maxMsgLen);
+    for (int i=0; i<UDP_MAX_BATCH; ++i) {
+      msgs[i].buf    = bufs + (size_t) i * maxMsgLen;
+      msgs[i].bufLen = maxMsgLen;
+    }
+
+    fds[0].fd     = w->udp->getUDPSocketFd();
+    fds[0].events = POLLIN;
+    fds[1].fd     = wakeupFd;
+    fds[1].events = POLLIN;
+
+    while (running.load()) {
+
+      if (poll(fds, 2, -1) == ERROR && errno != EINTR)
+	break;
+
+      while ((n_msgs = w->udp->readUDPSocketBatch(msgs, UDP_MAX_BATCH)) > 0) {
+	n_bytes = 0;
+	for (int i=0; i<n_msgs; ++i)
+	  n_bytes += msgs[i].msgLen;
+
+	t0 = monotonicTimeNs();
+	handler(worker, msgs, n_msgs);
+
+	w->busy_ns.fetch_add(monotonicTimeNs() - t0, std::memory_order_relaxed);
+	w->packets.fetch_add(n_msgs, std::memory_order_relaxed);
+	w->bytes.fetch_add(n_bytes, std::memory_order_relaxed);
+	w->batches.fetch_add(1, std::memory_order_relaxed);
+      }
+
+    }
+
+    free(bufs);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  getUDPWorkerSocket
+\date  Oct 2026
+
+\remarks
+
+Returns the socket of a worker, e.g., to send replies from the handler.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     worker          : the worker
+
+returns the socket, or NULL if the worker does not exist
+
+  ******************************************************************************/
+  UDP_communication * UDPServerGroup::
+  getUDPWorkerSocket(int worker)
+  {
+    if (!active || worker < 0 || worker >= nWorkers)
+      return NULL;
+
+    return workers[worker].udp;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  getUDPWorkerStats
+\date  Oct 2026
+
+\remarks
+
+Returns a snapshot of the load of a worker; can be called from any thread.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     worker          : the worker
+\param[out]    stats           : the load counters
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPServerGroup::
+  getUDPWorkerStats(int worker,
+		    UDPWorkerStats *stats)
+  {
+    Worker *w;
+
+    if (!active || worker < 0 || worker >= nWorkers)
+      return FALSE;
+
+    w = &workers[worker];
+    stats->packets = w->packets.load(std::memory_order_relaxed);
+    stats->bytes   = w->bytes.load(std::memory_order_relaxed);
+    stats->batches = w->batches.load(std::memory_order_relaxed);
+    stats->busy    = w->busy_ns.load(std::memory_order_relaxed) * 1.e-9;
+    stats->cpu     = w->cpu;
+
+    return TRUE;
+  }
+
+} // end of namespace
@@ -0,0 +1,577 @@
+/*!=============================================================================
+  ==============================================================================
+
+  \file    udp_uring.cpp
+
+  \author  Stefan Schaal
+  \date    Oct 2026
+
+  ==============================================================================
+  \remarks
+
+  An io_uring based receive engine for a UDP_communication server socket. A
+  single multishot recvmsg request stays armed in the kernel and places
+  incoming datagrams into a ring of provided buffers. The application reaps
+  completions directly from the memory mapped completion queue, i.e., without
+  any system call as long as data is available, and only enters the kernel
+  when it wants to wait for new data.
+
+  The io_uring interface is used directly through its system calls, such that
+  no additional library is needed. Multishot recvmsg requires Linux 6.0 or
+  newer.
+
+  ============================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+#include "unistd.h"
+#include "string.h"
+#include "errno.h"
+#include "sys/mman.h"
+#include "sys/syscall.h"
+
+// my utilities library
+#include "utility.h"
+
+#include "udp_uring.h"
+#include "comm_log.h"
+
+namespace udp_communication {
+
+  using namespace comm_log;
+
+  // thin wrappers around the io_uring system calls
+  static int
+  io_uring_setup(unsigned entries, struct io_uring_params *p)
+  {
+    return (int) syscall(__NR_io_uring_setup, entries, p);
+  }
+
+  static int
+  io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+  {
+    return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+  }
+
+  static int
+  io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args)
+  {
+    return (int) syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Constructor
+\date  Oct 2026
+
+\remarks
+
+The engine is inactive until initUDPUring() was called.
+
+  ******************************************************************************/
+  UDPUring::
+  UDPUring()
+  {
+    active  = FALSE;
+    armed   = FALSE;
+    ringFd  = ERROR;
+    sFd     = ERROR;
+    sqRing  = MAP_FAILED;
+    cqRing  = MAP_FAILED;
+    sqes    = (struct io_uring_sqe *) MAP_FAILED;
+    bufRing = (struct io_uring_buf_ring *) MAP_FAILED;
+    bufBase = NULL;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  Destructor
+\date  Oct 2026
+
+\remarks
+
+Tears down the io_uring if still active. The UDP socket is not closed.
+
+  ******************************************************************************/
+  UDPUring::
+  ~UDPUring()
+  {
+    if (active)
+      closeUDPUring();
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  initUDPUring
+\date  Oct 2026
+
+\remarks
+
+Creates the io_uring, registers a ring of provided receive buffers, and arms a
+multishot recvmsg on the socket of udp, which needs to be a server socket.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     udp             : the (server) UDP socket to receive from
+\param[in]     n_buffers       : number of receive buffers (rounded up to a
+                                 power of 2), i.e., how many datagrams can be
+                                 queued before the kernel runs out of buffers
+\param[in]     buf_len         : max. datagram size
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPUring::
+  initUDPUring(UDP_communication *udp,
+	       int n_buffers,
+	       int buf_len)
+  {
+    struct io_uring_params  params;
+    struct io_uring_buf_reg reg;
+    int                     i;
+
+    if (active) {
+      printf("io_uring is already active\n");
+      return FALSE;
+    }
+
+    if ((sFd = udp->getUDPSocketFd()) == ERROR) {
+      printf("Socket not initialized\n");
+      return FALSE;
+    }
+
+    // the buffer ring needs a power of 2 number of entries
+    nBuffers = 1;
+    while (nBuffers < n_buffers && nBuffers < 32768)
+      nBuffers <<= 1;
+
+    // each buffer holds the recvmsg header, the source address, and the payload
+    bufLen = sizeof(struct io_uring_recvmsg_out) + sizeof(struct sockaddr_in) + buf_len;
+
+    // create the ring
+    bzero((char *) &params, sizeof(params));
+    if ((ringFd = io_uring_setup(UDP_URING_ENTRIES, &params)) < 0) {
+      printf("Error: could not create io_uring (errno=%d)\n",errno);
+      ringFd = ERROR;
+      return FALSE;
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+      if (cqRingSize > sqRingSize)
+	sqRingSize = cqRingSize;
+      cqRingSize = sqRingSize;
+    }
+
+    sqRing = mmap(NULL, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		  ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+      printf("Error: could not map io_uring submission queue\n");
+      active = TRUE;
+      closeUDPUring();
+      return FALSE;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+      cqRing = sqRing;
+    else
+      cqRing = mmap(NULL, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		    ringFd, IORING_OFF_CQ_RING);
+
+    sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes = (struct io_uring_sqe *) mmap(NULL, sqesSize, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+
+    if (cqRing == MAP_FAILED || sqes == MAP_FAILED) {
+      printf("Error: could not map io_uring completion queue\n");
+      active = TRUE;
+      closeUDPUring();
+      return FALSE;
+    }
+
+    sqHead  = (unsigned *) ((char *) sqRing + params.sq_off.head);
+    sqTail  = (unsigned *) ((char *) sqRing + params.sq_off.tail);
+    sqMask  = (unsigned *) ((char *) sqRing + params.sq_off.ring_mask);
+    sqArray = (unsigned *) ((char *) sqRing + params.sq_off.array);
+    cqHead  = (unsigned *) ((char *) cqRing + params.cq_off.head);
+    cqTail  = (unsigned *) ((char *) cqRing + params.cq_off.tail);
+    cqMask  = (unsigned *) ((char *) cqRing + params.cq_off.ring_mask);
+    cqes    = (struct io_uring_cqe *) ((char *) cqRing + params.cq_off.cqes);
+
+    // the provided buffer ring and the buffers
+    bufRingSize = nBuffers * sizeof(struct io_uring_buf);
+    bufRing = (struct io_uring_buf_ring *) mmap(NULL, bufRingSize, PROT_READ | PROT_WRITE,
+						MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    bufBase = (char *) malloc((size_t) nBuffers * bufLen);
+    if (bufRing == MAP_FAILED || bufBase == NULL) {
+      printf("Error: could not allocate io_uring buffers\n");
+      active = TRUE;
+      closeUDPUring();
+      return FALSE;
+    }
+
+    bzero((char *) &reg, sizeof(reg));
+    reg.ring_addr    = (unsigned long) bufRing;
+    reg.ring_entries = nBuffers;
+    reg.bgid         = UDP_URING_BGID;
+    if (io_uring_register(ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+      printf("Error: could not register io_uring buffer ring (errno=%d)\n",errno);
+      active = TRUE;
+      closeUDPUring();
+      return FALSE;
+    }
+
+    bufTail = 0;
+    for (i=0; i<nBuffers; ++i)
+      recycleUDPUringBuffer(i);
+    __atomic_store_n(&bufRing->tail, bufTail, __ATOMIC_RELEASE);
+
+    // the recvmsg template: only the source address, no control data
+    bzero((char *) &recvHdr, sizeof(recvHdr));
+    recvHdr.msg_namelen = sizeof(struct sockaddr_in);
+
+    active = TRUE;
+
+    if (!armUDPUring()) {
+      closeUDPUring();
+      return FALSE;
+    }
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  armUDPUring
+\date  Oct 2026
+
+\remarks
+
+Submits the multishot recvmsg request. This is only needed initially and
+whenever the kernel terminated the multishot request, e.g., after running out
+of provided buffers.
+
+  ******************************************************************************/
+  int UDPUring::
+  armUDPUring(void)
+  {
+    struct io_uring_sqe *sqe;
+    unsigned             tail;
+    unsigned             index;
+
+    tail  = *sqTail;
+    index = tail & *sqMask;
+    sqe   = &sqes[index];
+
+    bzero((char *) sqe, sizeof(struct io_uring_sqe));
+    sqe->opcode    = IORING_OP_RECVMSG;
+    sqe->fd        = sFd;
+    sqe->addr      = (unsigned long) &recvHdr;
+    sqe->len       = 1;
+    sqe->ioprio    = IORING_RECV_MULTISHOT;
+    sqe->flags     = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = UDP_URING_BGID;
+    sqe->user_data = UDP_URING_RECV_TAG;
+
+    sqArray[index] = index;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    if (io_uring_enter(ringFd, 1, 0, 0) < 0) {
+      logCommEvent(COMM_EV_UDP_READ_ERROR,errno,sFd);
+      return FALSE;
+    }
+
+    armed = TRUE;
+
+    return TRUE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  recycleUDPUringBuffer
+\date  Oct 2026
+
+\remarks
+
+Hands a buffer back to the kernel. The new tail only becomes visible to the
+kernel when it is published with a release store.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in]     bid             : buffer id
+
+  ******************************************************************************/
+  void UDPUring::
+  recycleUDPUringBuffer(int bid)
+  {
+    struct io_uring_buf *buf;
+
+    // note: bufRing->bufs cannot be used from C++, as the flexible array macro
+    // of the kernel header places it behind an empty struct of size 1
+    buf = (struct io_uring_buf *) bufRing + (bufTail & (nBuffers - 1));
+    buf->addr = (unsigned long) (bufBase + (size_t) bid * bufLen);
+    buf->len  = bufLen;
+    buf->bid  = bid;
+    ++bufTail;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  reapUDPUring
+\date  Oct 2026
+
+\remarks
+
+Collects received datagrams from the completion queue and copies them into the
+message slots. As long as completions are available, no system call is made.
+
+*******************************************************************************
+Function Parameters: [in]=input,[out]=output
+
+\param[in,out] msgs            : array of message slots; buf and bufLen need
+                                 to be set, msgLen, addr, and truncated are
+                                 filled in for each received message
+\param[in]     n_msgs          : number of slots in msgs
+\param[in]     wait            : TRUE: block until at least one datagram is
+                                 available, FALSE: only poll the queue
+
+returns the number of messages received, or ERROR
+
+  ******************************************************************************/
+  int UDPUring::
+  reapUDPUring(UDPMessage *msgs,
+	       int         n_msgs,
+	       int         wait)
+  {
+    struct io_uring_cqe        *cqe;
+    struct io_uring_recvmsg_out *out;
+    unsigned                    head;
+    unsigned                    tail;
+    unsigned                    recycled = bufTail;
+    char                       *buf;
+    char                       *payload;
+    int                         n = 0;
+    int                         len;
+    int                         stored;
+
+    if (!active) {
+      logCommEvent(COMM_EV_UDP_NOT_ACTIVE,0,sFd);
+      return ERROR;
+    }
+
+    head = *cqHead;
+
+    while (n < n_msgs) {
+
+      tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+      if (head == tail) {
+	if (n > 0 || !wait)
+	  break;
+
+	// make sure that a receive is pending before waiting for it
+	__atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+	if (recycled != bufTail) {
+	  __atomic_store_n(&bufRing->tail, bufTail, __ATOMIC_RELEASE);
+	  recycled = bufTail;
+	}
+	if (!armed && !armUDPUring())
+	  return ERROR;
+
+	if (io_uring_enter(ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+	  logCommEvent(COMM_EV_UDP_READ_ERROR,errno,sFd);
+	  return ERROR;
+	}
+	continue;
+      }
+
+      cqe = &cqes[head & *cqMask];
+      ++head;
+
+      if (!(cqe->flags & IORING_CQE_F_MORE))
+	armed = FALSE;
+
+      if (cqe->res < 0) {
+	// running out of buffers just terminates the multishot request
+	if (cqe->res != -ENOBUFS)
+	  logCommEvent(COMM_EV_UDP_READ_ERROR,-cqe->res,sFd);
+	continue;
+      }
+
+      if (!(cqe->flags & IORING_CQE_F_BUFFER))
+	continue;
+
+      buf = bufBase + (size_t) (cqe->flags >> IORING_CQE_BUFFER_SHIFT) * bufLen;
+      out = (struct io_uring_recvmsg_out *) buf;
+      payload = buf + sizeof(struct io_uring_recvmsg_out) + recvHdr.msg_namelen
+	+ recvHdr.msg_controllen;
+
+      // on MSG_TRUNC, payloadlen is the length of the datagram, not the
+      // bytes the kernel stored in the buffer
+      len = out->payloadlen;
+      msgs[n].truncated = (out->flags & MSG_TRUNC) != 0;
+      stored = cqe->res - (int) (sizeof(struct io_uring_recvmsg_out)
+				 + recvHdr.msg_namelen + recvHdr.msg_controllen);
+      if (len > stored) {
+	len = stored < 0 ? 0 : stored;
+	msgs[n].truncated = TRUE;
+      }
+      if (len > msgs[n].bufLen) {
+	len = msgs[n].bufLen;
+	msgs[n].truncated = TRUE;
+      }
+      memcpy(msgs[n].buf, payload, len);
+      msgs[n].msgLen = len;
+      memcpy(&msgs[n].addr, buf + sizeof(struct io_uring_recvmsg_out),
+	     sizeof(struct sockaddr_in));
+
+      recycleUDPUringBuffer(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+      ++n;
+    }
+
+    // give the consumed completions and buffers back to the kernel
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    if (recycled != bufTail)
+      __atomic_store_n(&bufRing->tail, bufTail, __ATOMIC_RELEASE);
+
+    if (!armed && !armUDPUring())
+      return ERROR;
+
+    return n;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  cancelUDPUring
+\date  Oct 2026
+
+\remarks
+
+Cancels the multishot recvmsg and waits until the kernel completed both the
+cancellation and the receive, such that no receive writes into the provided
+buffers anymore.
+
+  ******************************************************************************/
+  void UDPUring::
+  cancelUDPUring(void)
+  {
+    struct io_uring_sqe *sqe;
+    struct io_uring_cqe *cqe;
+    unsigned             head;
+    unsigned             tail;
+    unsigned             index;
+    bool                 cancelled = FALSE;
+
+    if (!armed || sqes == MAP_FAILED || cqRing == MAP_FAILED)
+      return;
+
+    tail  = *sqTail;
+    index = tail & *sqMask;
+    sqe   = &sqes[index];
+
+    bzero((char *) sqe, sizeof(struct io_uring_sqe));
+    sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+    sqe->fd        = -1;
+    sqe->addr      = UDP_URING_RECV_TAG;
+    sqe->user_data = UDP_URING_CANCEL_TAG;
+
+    sqArray[index] = index;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    if (io_uring_enter(ringFd, 1, 0, 0) < 0) {
+      logCommEvent(COMM_EV_UDP_READ_ERROR,errno,sFd);
+      return;
+    }
+
+    head = *cqHead;
+
+    while (armed || !cancelled) {
+      tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+      if (head == tail) {
+	__atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+	if (io_uring_enter(ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+	  logCommEvent(COMM_EV_UDP_READ_ERROR,errno,sFd);
+	  break;
+	}
+	continue;
+      }
+
+      cqe = &cqes[head & *cqMask];
+      ++head;
+
+      if (cqe->user_data == UDP_URING_CANCEL_TAG) {
+	cancelled = TRUE;
+	// the receive already ended, and its last completion was reaped
+	if (cqe->res == -ENOENT)
+	  armed = FALSE;
+      } else if (!(cqe->flags & IORING_CQE_F_MORE)) {
+	armed = FALSE;
+      }
+    }
+
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    armed = FALSE;
+  }
+
+  /*!*****************************************************************************
+*******************************************************************************
+\note  closeUDPUring
+\date  Oct 2026
+
+\remarks
+
+Cancels the pending receive and releases all io_uring resources. The
+buffers are only freed after the kernel confirmed the cancellation.
+
+returns TRUE if all OK, otherwise FALSE
+
+  ******************************************************************************/
+  int UDPUring::
+  closeUDPUring(void)
+  {
+    struct io_uring_buf_reg reg;
+
+    if (!active) {
+      printf("io_uring not initialized\n");
+      return FALSE;
+    }
+
+    active = FALSE;
+
+    if (ringFd != ERROR) {
+      cancelUDPUring();
+      if (bufRing != MAP_FAILED) {
+	bzero((char *) &reg, sizeof(reg));
+	reg.bgid = UDP_URING_BGID;
+	io_uring_register(ringFd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+      }
+      close(ringFd);
+    }
+    armed = FALSE;
+    ringFd = ERROR;
+
+    if (sqes != MAP_FAILED)
+      munmap(sqes, sqesSize);
+    if (cqRing != MAP_FAILED && cqRing != sqRing)
+      munmap(cqRing, cqRingSize);
+    if (sqRing != MAP_FAILED)
+      munmap(sqRing, sqRingSize);
+    if (bufRing != MAP_FAILED)
+      munmap(bufRing, bufRingSize);
+    if (bufBase != NULL)
+      free(bufBase);
+
+    sqRing  = MAP_FAILED;
+    cqRing  = MAP_FAILED;
+    sqes    = (struct io_uring_sqe *) MAP_FAILED;
+    bufRing = (struct io_uring_buf_ring *) MAP_FAILED;
+    bufBase = NULL;
+
+    return TRUE;
+  }
+
+} // end of namespace